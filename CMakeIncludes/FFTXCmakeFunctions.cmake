@@ -419,6 +419,9 @@ function ( FFTX_find_libraries )
 	string ( REGEX REPLACE ".so.*$" "" _lib ${_lib} )	## strip trailing stuff - Linux
 	string ( REGEX REPLACE ".dll.*$" "" _lib ${_lib} )	## strip trailing stuff - Windows
 	string ( REGEX REPLACE ".dylib.*$" "" _lib ${_lib} )	## strip trailing stuff - MAC
+	if ( "${_lib}" STREQUAL "fftx_fftw" )
+	    continue ()			## FFTW3 shim, linked explicitly in place of fftw3
+	endif ()
 	list ( FIND _libraries_added "${_lib}" _posnlist )
 	if ( ${_posnlist} EQUAL -1 )
 	    ##  message ( STATUS "${_lib} not in list -- adding" )
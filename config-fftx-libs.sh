@@ -60,15 +60,30 @@ DFTBAT_LIB=true
 ##  Build the batch 1D packed real DFT (real to complex, complex to real) library
 PRDFTBAT_LIB=false
 
+##  Build the batch 3D DFT (complex to complex) library
+MDDFTBAT_LIB=true
+
+##  Build the batch 3D DFT (real to complex, complex to real) library
+MDPRDFTBAT_LIB=true
+
 ##  Build the 3D DFT (complex to complex) library
 MDDFT_LIB=true
 
 ##  Build the 3D DFT (real to complex, complex to real) library
 MDPRDFT_LIB=true
 
-##  Build the Real Convolution library
+##  Build the Real Convolution libraries (real and complex symbol)
 RCONV_LIB=true
 
+##  Build the pruned 3D DFT (complex to complex, half-cube output or input) library
+PMDDFT_LIB=true
+
+##  Build the spectral resampling (2x refinement of a real cube) library
+RESAMPLE_LIB=true
+
+##  Build the 3D real-to-real (DCT and DST, types I, II and III) libraries
+R2R_LIB=true
+
 ##  Build the PSATD fixed sizes library
 PSATD_LIB=false
 
@@ -82,6 +97,9 @@ GPU_SIZES_FILE="cube-sizes-gpu.txt"
 ##  File containing the sizes to build for the CPU version of batch 1D DFT and batch 1D PRDFT
 DFTBAT_SIZES_FILE="dftbatch-sizes.txt"
 
+##  File containing the sizes to build for batch 3D DFT and batch 3D PRDFT
+MDDFTBAT_SIZES_FILE="mddftbatch-sizes.txt"
+
 ##  File containing the sizes to build for the PSATD library
 PSATD_SIZES_FILE="cube-psatd.txt"
 
@@ -94,15 +112,37 @@ echo "#!/bin/bash" >> build-lib-code-options.sh
 
 echo "DFTBAT_LIB=$DFTBAT_LIB" >> build-lib-code-options.sh
 echo "PRDFTBAT_LIB=$PRDFTBAT_LIB" >> build-lib-code-options.sh
+echo "MDDFTBAT_LIB=$MDDFTBAT_LIB" >> build-lib-code-options.sh
+echo "MDPRDFTBAT_LIB=$MDPRDFTBAT_LIB" >> build-lib-code-options.sh
 echo "MDDFT_LIB=$MDDFT_LIB" >> build-lib-code-options.sh
 echo "MDPRDFT_LIB=$MDPRDFT_LIB" >> build-lib-code-options.sh
 echo "RCONV_LIB=$RCONV_LIB" >> build-lib-code-options.sh
+echo "PMDDFT_LIB=$PMDDFT_LIB" >> build-lib-code-options.sh
+echo "RESAMPLE_LIB=$RESAMPLE_LIB" >> build-lib-code-options.sh
+echo "R2R_LIB=$R2R_LIB" >> build-lib-code-options.sh
 echo "PSATD_LIB=$PSATD_LIB" >> build-lib-code-options.sh
 echo "CPU_SIZES_FILE=$CPU_SIZES_FILE" >> build-lib-code-options.sh
 echo "GPU_SIZES_FILE=$GPU_SIZES_FILE" >> build-lib-code-options.sh
 echo "DFTBAT_SIZES_FILE=$DFTBAT_SIZES_FILE" >> build-lib-code-options.sh
+echo "MDDFTBAT_SIZES_FILE=$MDDFTBAT_SIZES_FILE" >> build-lib-code-options.sh
 echo "PSATD_SIZES_FILE=$PSATD_SIZES_FILE" >> build-lib-code-options.sh
 
+##  Write the same options as macros for interface.hpp, so it only includes and looks up
+##  the public headers of the libraries that are built
+rm -f fftx_libs_config.h
+touch fftx_libs_config.h
+
+echo "//  Generated by config-fftx-libs.sh -- do not edit" >> fftx_libs_config.h
+echo "#ifndef FFTX_LIBS_CONFIG_HEADER" >> fftx_libs_config.h
+echo "#define FFTX_LIBS_CONFIG_HEADER" >> fftx_libs_config.h
+for lib in PMDDFT MDDFTBAT MDPRDFTBAT RESAMPLE R2R; do
+    eval setopt=\$${lib}_LIB
+    if [ "$setopt" = true ]; then
+	echo "#define FFTX_${lib}_LIB" >> fftx_libs_config.h
+    fi
+done
+echo "#endif" >> fftx_libs_config.h
+
 popd
 
 ##  Make a directory for cached JIT files (may be written by code gen from build-lib-code or
@@ -167,6 +207,20 @@ else
 fi
 echo "option ( PRDFTBAT_LIB \"Build the batch 1D packed real DFT (real to complex, complex to real) library\" $setopt )" >> options.cmake
 
+if [ "$MDDFTBAT_LIB" = true ]; then
+    setopt="ON"
+else
+    setopt="OFF"
+fi
+echo "option ( MDDFTBAT_LIB \"Build the batch 3D DFT (complex to complex) library\" $setopt )" >> options.cmake
+
+if [ "$MDPRDFTBAT_LIB" = true ]; then
+    setopt="ON"
+else
+    setopt="OFF"
+fi
+echo "option ( MDPRDFTBAT_LIB \"Build the batch 3D DFT (real to complex, complex to real) library\" $setopt )" >> options.cmake
+
 if [ "$MDDFT_LIB" = true ]; then
     setopt="ON"
 else
@@ -186,7 +240,28 @@ if [ "$RCONV_LIB" = true ]; then
 else
     setopt="OFF"
 fi
-echo "option ( RCONV_LIB \"Build the Real Convolution library\" $setopt )" >> options.cmake
+echo "option ( RCONV_LIB \"Build the Real Convolution libraries\" $setopt )" >> options.cmake
+
+if [ "$PMDDFT_LIB" = true ]; then
+    setopt="ON"
+else
+    setopt="OFF"
+fi
+echo "option ( PMDDFT_LIB \"Build the pruned 3D DFT library\" $setopt )" >> options.cmake
+
+if [ "$RESAMPLE_LIB" = true ]; then
+    setopt="ON"
+else
+    setopt="OFF"
+fi
+echo "option ( RESAMPLE_LIB \"Build the spectral resampling library\" $setopt )" >> options.cmake
+
+if [ "$R2R_LIB" = true ]; then
+    setopt="ON"
+else
+    setopt="OFF"
+fi
+echo "option ( R2R_LIB \"Build the 3D DCT and DST libraries\" $setopt )" >> options.cmake
 
 if [ "$PSATD_LIB" = true ]; then
     setopt="ON"
@@ -0,0 +1,144 @@
+#include <mpi.h>
+#include <complex>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <stdlib.h>
+
+#include "fftx_mpi.hpp"
+#include "fftx_1d_mpi_cpu.hpp"
+
+using namespace std;
+
+#define TOLERANCE 1e-10
+
+inline size_t ceil_div(size_t a, size_t b) {
+  return (a + b - 1) / b;
+}
+
+// relative L2 error over all ranks.
+static double rel_error(double *local, MPI_Comm comm) {
+  double global[2];
+  MPI_Allreduce(local, global, 2, MPI_DOUBLE, MPI_SUM, comm);
+  return sqrt(global[0] / (global[1] > 0 ? global[1] : 1.0));
+}
+
+int main(int argc, char* argv[]) {
+
+  // the slab plan runs its threads between MPI calls.
+  int provided;
+  MPI_Init_thread(&argc, &argv, MPI_THREAD_FUNNELED, &provided);
+
+  int rank;
+  int p;
+
+  MPI_Comm_size(MPI_COMM_WORLD, &p);
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+  bool timed = argc > 1 && strcmp(argv[argc-1], "-t") == 0;
+  if (timed)
+    argc--;
+  if (argc != 5 && argc != 6) {
+    if (rank == 0) {
+      printf("usage: %s <M> <N> <K> <batch> [threads] [-t]\n", argv[0]);
+    }
+    MPI_Finalize();
+    exit(-1);
+  }
+  size_t M = atoi(argv[1]);
+  size_t N = atoi(argv[2]);
+  size_t K = atoi(argv[3]);
+  size_t batch = atoi(argv[4]);
+  int threads  = argc == 6 ? atoi(argv[5]) : 0;
+
+  // forward input [K0, N, M, b], forward output [M0, N, K, b].
+  size_t K0 = ceil_div(K, p);
+  size_t M0 = ceil_div(M, p);
+  size_t in_size  = K0 * N * M * batch;
+  size_t out_size = M0 * N * K * batch;
+
+  complex<double> *in  = new complex<double>[in_size];
+  complex<double> *out = new complex<double>[out_size];
+  complex<double> *rt  = new complex<double>[in_size];
+
+  // batch b holds a plane wave of frequency (b, 2b, 3b), so the forward
+  // transform is M N K at that frequency and zero elsewhere.
+  double twopi = 2.0 * M_PI;
+  for (size_t k = 0; k < K0; k++) {
+    for (size_t n = 0; n < N; n++) {
+      for (size_t m = 0; m < M; m++) {
+        for (size_t b = 0; b < batch; b++) {
+          size_t kg = rank * K0 + k;
+          double ph = twopi * ((double) (b % M) * m / M + (double) (2*b % N) * n / N + (double) (3*b % K) * kg / K);
+          in[((k * N + n) * M + m) * batch + b] = kg < K ? complex<double>(cos(ph), sin(ph)) : 0.0;
+        }
+      }
+    }
+  }
+
+  fftx_plan plan = fftx_plan_distributed_1d_cpu(p, M, N, K, batch, false, true, threads);
+  if (timed)
+    fftx_plan_timing(plan, true);
+
+  if (rank == 0) {
+    cout<<"Problem size: "<<M<<" x "<<N<<" x "<<K<<endl;
+    cout<<"Batch size  : "<<batch<<endl;
+    cout<<"Ranks       : "<<p<<endl;
+  }
+
+  double start_time = MPI_Wtime();
+  fftx_execute(plan, (double *) out, (double *) in, DEVICE_FFT_FORWARD);
+  double end_time = MPI_Wtime();
+
+  double max_time, local_time = end_time - start_time;
+  MPI_Reduce(&local_time, &max_time, 1, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
+  if (rank == 0)
+    cout<<endl<<"end_to_end," << max_time<<endl;
+
+  // the forward output against the expected spikes, skipping the padding rows.
+  double scale = (double) M * N * K;
+  double local[2] = {0.0, 0.0};
+  for (size_t m = 0; m < M0 && rank * M0 + m < M; m++) {
+    for (size_t n = 0; n < N; n++) {
+      for (size_t k = 0; k < K; k++) {
+        for (size_t b = 0; b < batch; b++) {
+          size_t mg = rank * M0 + m;
+          bool spike = mg == b % M && n == 2*b % N && k == 3*b % K;
+          complex<double> d = out[((m * N + n) * K + k) * batch + b] - (spike ? scale : 0.0);
+          local[0] += norm(d);
+          local[1] += spike ? scale * scale : 0.0;
+        }
+      }
+    }
+  }
+  double fwd_err = rel_error(local, MPI_COMM_WORLD);
+  if (rank == 0)
+    cout<<"forward relative error: "<<fwd_err<<(fwd_err <= TOLERANCE ? " (PASS)" : " (FAIL)")<<endl;
+
+  // the inverse of the forward output is M N K times the input.
+  fftx_execute(plan, (double *) rt, (double *) out, DEVICE_FFT_INVERSE);
+  local[0] = local[1] = 0.0;
+  for (size_t k = 0; k < K0 && rank * K0 + k < K; k++) {
+    for (size_t i = 0; i < N * M * batch; i++) {
+      size_t j = k * N * M * batch + i;
+      local[0] += norm(rt[j] - scale * in[j]);
+      local[1] += norm(scale * in[j]);
+    }
+  }
+  double rt_err = rel_error(local, MPI_COMM_WORLD);
+  if (rank == 0)
+    cout<<"round trip relative error"<<(M % p || K % p ? " (uneven sizes): " : ": ")
+        <<rt_err<<(rt_err <= TOLERANCE ? " (PASS)" : " (FAIL)")<<endl;
+
+  if (timed)
+    fftx_plan_timers_json(plan, stdout);
+
+  fftx_plan_destroy(plan);
+
+  delete[] in;
+  delete[] out;
+  delete[] rt;
+
+  MPI_Finalize();
+  return 0;
+}
@@ -0,0 +1,207 @@
+//  Copyright (c) 2018-2022, Carnegie Mellon University
+//  See LICENSE for details
+
+//  Plans the FFTW3 entry points of fftx_fftw with FFTW_ESTIMATE, FFTW_MEASURE
+//  and FFTW_WISDOM_ONLY and checks each run against a direct DFT.
+
+#include <complex>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "fftx_fftw3.h"
+
+typedef std::complex<double> cplx;
+
+#define TOLERANCE 1e-10
+
+static bool passed = true;
+
+//  direct DFT of count arrays of length n, element j of array b at b*dist + j*stride.
+static void dft1 ( cplx *y, const cplx *x, int n, int count, int stride, int dist, int sign )
+{
+    std::vector<cplx> t ( n );
+    for ( int b = 0; b < count; b++ ) {
+        for ( int k = 0; k < n; k++ ) {
+            t[k] = 0.0;
+            for ( int j = 0; j < n; j++ )
+                t[k] += x[b*dist + j*stride] * std::polar ( 1.0, sign * 2.0 * M_PI * ((double) j * k / n) );
+        }
+        for ( int k = 0; k < n; k++ )
+            y[b*dist + k*stride] = t[k];
+    }
+}
+
+//  direct 3D DFT of a contiguous n0 x n1 x n2 array, one dimension at a time.
+static void dft3 ( cplx *y, const cplx *x, int n0, int n1, int n2, int sign )
+{
+    for ( int i = 0; i < n0*n1*n2; i++ )
+        y[i] = x[i];
+    dft1 ( y, y, n2, n0*n1, 1, n2, sign );
+    for ( int i0 = 0; i0 < n0; i0++ )
+        dft1 ( y + i0*n1*n2, y + i0*n1*n2, n1, n2, n2, 1, sign );
+    dft1 ( y, y, n0, n1*n2, n1*n2, 1, sign );
+}
+
+static void fill ( cplx *x, size_t n )
+{
+    for ( size_t i = 0; i < n; i++ )
+        x[i] = cplx ( ((double) rand()) / RAND_MAX - 0.5, ((double) rand()) / RAND_MAX - 0.5 );
+}
+
+//  relative L2 error of count elements of y, stride apart, against a contiguous ref.
+static void report ( const char *name, const char *flag, const cplx *y, const cplx *ref, size_t count, size_t stride = 1 )
+{
+    double d = 0.0, r = 0.0;
+    for ( size_t i = 0; i < count; i++ ) {
+        d += std::norm ( y[i*stride] - ref[i] );
+        r += std::norm ( ref[i] );
+    }
+    double err = std::sqrt ( d / (r > 0.0 ? r : 1.0) );
+    bool ok = err <= TOLERANCE;
+    passed &= ok;
+    printf ( "%-24s %-18s relative error = %E (%s)\n", name, flag, err, ok ? "PASS" : "FAIL" );
+}
+
+//  a NULL plan is expected only for FFTW_WISDOM_ONLY, when the library lacks the size.
+static bool planned ( fftw_plan p, const char *name, const char *flag, unsigned flags )
+{
+    if ( p != NULL )
+        return true;
+    bool ok = ( flags & FFTW_WISDOM_ONLY ) != 0;
+    passed &= ok;
+    printf ( "%-24s %-18s %s\n", name, flag, ok ? "not in the library, skipped" : "plan failed (FAIL)" );
+    return false;
+}
+
+int main ( int argc, char *argv[] )
+{
+    int n0 = 8, n1 = 8, n2 = 8, howmany = 3;
+    if ( argc == 4 ) {
+        n0 = atoi ( argv[1] );
+        n1 = atoi ( argv[2] );
+        n2 = atoi ( argv[3] );
+    }
+    else if ( argc != 1 ) {
+        printf ( "Usage: %s [n0 n1 n2]\n", argv[0] );
+        exit ( -1 );
+    }
+    int n[3] = { n0, n1, n2 };
+    int nh = n2/2 + 1;
+    size_t npts = (size_t) n0 * n1 * n2;
+    size_t hpts = (size_t) n0 * n1 * nh;
+    printf ( "fftx_fftw: %d x %d x %d, 1D length %d, batch %d\n", n0, n1, n2, n2, howmany );
+
+    //  room for the largest case: a batch of 3D arrays, or 1D arrays with gaps.
+    size_t room = npts * howmany + (size_t) 2 * howmany;
+    cplx *in   = (cplx *) fftw_alloc_complex ( room );
+    cplx *out  = (cplx *) fftw_alloc_complex ( room );
+    cplx *ref  = (cplx *) fftw_alloc_complex ( room );
+    double *rin  = fftw_alloc_real ( npts );
+    double *rout = fftw_alloc_real ( npts );
+
+    unsigned flags[3] = { FFTW_ESTIMATE, FFTW_MEASURE, FFTW_WISDOM_ONLY };
+    const char *flag_names[3] = { "FFTW_ESTIMATE", "FFTW_MEASURE", "FFTW_WISDOM_ONLY" };
+
+    for ( int f = 0; f < 3; f++ ) {
+        const char *fn = flag_names[f];
+        fftw_plan p;
+
+        //  FFTW_MEASURE overwrites the arrays, so every input is set after planning.
+        p = fftw_plan_dft_3d ( n0, n1, n2, (fftw_complex *) in, (fftw_complex *) out, FFTW_FORWARD, flags[f] );
+        if ( planned ( p, "dft_3d forward", fn, flags[f] ) ) {
+            fill ( in, npts );
+            fftw_execute ( p );
+            dft3 ( ref, in, n0, n1, n2, FFTW_FORWARD );
+            report ( "dft_3d forward", fn, out, ref, npts );
+            fftw_destroy_plan ( p );
+        }
+
+        p = fftw_plan_dft_3d ( n0, n1, n2, (fftw_complex *) in, (fftw_complex *) in, FFTW_BACKWARD, flags[f] );
+        if ( planned ( p, "dft_3d in-place backward", fn, flags[f] ) ) {
+            fill ( in, npts );
+            dft3 ( ref, in, n0, n1, n2, FFTW_BACKWARD );
+            fftw_execute ( p );
+            report ( "dft_3d in-place backward", fn, in, ref, npts );
+            fftw_destroy_plan ( p );
+        }
+
+        //  the complex side keeps the n2/2 + 1 nonredundant elements of the last dimension.
+        p = fftw_plan_dft_r2c_3d ( n0, n1, n2, rin, (fftw_complex *) out, flags[f] );
+        if ( planned ( p, "dft_r2c_3d", fn, flags[f] ) ) {
+            for ( size_t i = 0; i < npts; i++ ) {
+                rin[i] = ((double) rand()) / RAND_MAX - 0.5;
+                in[i] = rin[i];
+            }
+            fftw_execute ( p );
+            dft3 ( ref, in, n0, n1, n2, FFTW_FORWARD );
+            for ( size_t i = 0; i < hpts; i++ )
+                ref[i] = ref[(i / nh) * n2 + i % nh];
+            report ( "dft_r2c_3d", fn, out, ref, hpts );
+            fftw_destroy_plan ( p );
+        }
+
+        //  the inverse of a real array's spectrum is npts times the array.
+        p = fftw_plan_dft_c2r_3d ( n0, n1, n2, (fftw_complex *) in, rout, flags[f] );
+        if ( planned ( p, "dft_c2r_3d", fn, flags[f] ) ) {
+            for ( size_t i = 0; i < npts; i++ )
+                ref[i] = ((double) rand()) / RAND_MAX - 0.5;
+            dft3 ( out, ref, n0, n1, n2, FFTW_FORWARD );
+            for ( size_t i = 0; i < hpts; i++ )
+                in[i] = out[(i / nh) * n2 + i % nh];
+            fftw_execute ( p );
+            for ( size_t i = 0; i < npts; i++ ) {
+                out[i] = rout[i];
+                ref[i] *= (double) npts;
+            }
+            report ( "dft_c2r_3d", fn, out, ref, npts );
+            fftw_destroy_plan ( p );
+        }
+
+        //  1D batch read interleaved element by element, written with a gap of
+        //  two elements after each array.
+        p = fftw_plan_many_dft ( 1, &n2, howmany, (fftw_complex *) in, NULL, howmany, 1,
+                                 (fftw_complex *) out, NULL, 1, n2 + 2, FFTW_FORWARD, flags[f] );
+        if ( planned ( p, "many_dft 1D strided", fn, flags[f] ) ) {
+            fill ( in, (size_t) n2 * howmany );
+            fftw_execute ( p );
+            for ( int b = 0; b < howmany; b++ )
+                for ( int j = 0; j < n2; j++ )
+                    ref[b*(n2 + 2) + j] = in[j*howmany + b];
+            dft1 ( ref, ref, n2, howmany, 1, n2 + 2, FFTW_FORWARD );
+            for ( int b = 0; b < howmany; b++ )
+                report ( "many_dft 1D strided", fn, out + b*(n2 + 2), ref + b*(n2 + 2), n2 );
+            fftw_destroy_plan ( p );
+        }
+
+        //  3D batch read contiguous and written interleaved element by element.
+        p = fftw_plan_many_dft ( 3, n, howmany, (fftw_complex *) in, NULL, 1, (int) npts,
+                                 (fftw_complex *) out, n, howmany, 1, FFTW_FORWARD, flags[f] );
+        if ( planned ( p, "many_dft 3D", fn, flags[f] ) ) {
+            fill ( in, npts * howmany );
+            fftw_execute ( p );
+            for ( int b = 0; b < howmany; b++ ) {
+                dft3 ( ref, in + b*npts, n0, n1, n2, FFTW_FORWARD );
+                report ( "many_dft 3D", fn, out + b, ref, npts, howmany );
+            }
+            fftw_destroy_plan ( p );
+        }
+    }
+
+    //  a single strided 3D array is neither contiguous nor interleaved.
+    fftw_plan p = fftw_plan_many_dft ( 3, n, 1, (fftw_complex *) in, NULL, 2, 0,
+                                       (fftw_complex *) out, NULL, 1, 0, FFTW_FORWARD, FFTW_ESTIMATE );
+    passed &= ( p == NULL );
+    printf ( "%-24s %-18s %s\n", "many_dft 3D stride 2", "FFTW_ESTIMATE", p == NULL ? "rejected (PASS)" : "planned (FAIL)" );
+    fftw_destroy_plan ( p );
+
+    fftw_free ( in );
+    fftw_free ( out );
+    fftw_free ( ref );
+    fftw_free ( rin );
+    fftw_free ( rout );
+
+    printf ( "%s\n", passed ? "All fftx_fftw checks passed" : "Some fftx_fftw checks FAILED" );
+    return passed ? 0 : 1;
+}
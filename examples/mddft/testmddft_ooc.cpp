@@ -0,0 +1,89 @@
+#include "fftx3.hpp"
+#include "interface.hpp"
+//  also defines MDDFTProblem and IMDDFTProblem
+#include "mddftooc.hpp"
+#include <string>
+#include <fstream>
+#include <cmath>
+
+//  Checks the out-of-core 3D DFT against the in-core MDDFTProblem and
+//  IMDDFTProblem. The memory limit is set so that each pass takes 4 slabs.
+
+int main(int argc, char* argv[])
+{
+    int mm = 24, nn = 32, kk = 40; // default cube dimensions
+    char *prog = argv[0];
+    int baz = 0;
+
+    while ( argc > 1 && argv[1][0] == '-' ) {
+        switch ( argv[1][1] ) {
+        case 's':
+            argv++, argc--;
+            mm = atoi ( argv[1] );
+            while ( argv[1][baz] != 'x' ) baz++;
+            baz++ ;
+            nn = atoi ( & argv[1][baz] );
+            while ( argv[1][baz] != 'x' ) baz++;
+            baz++ ;
+            kk = atoi ( & argv[1][baz] );
+            break;
+        case 'h':
+            printf ( "Usage: %s: [ -s MMxNNxKK ] (MM and NN multiples of 4) [ -h (print help message) ]\n", argv[0] );
+            exit (0);
+        default:
+            printf ( "%s: unknown argument: %s ... ignored\n", prog, argv[1] );
+        }
+        argv++, argc--;
+    }
+    if ( mm % 4 || nn % 4 ) {
+        printf ( "%s: MM and NN must be multiples of 4\n", prog );
+        exit (-1);
+    }
+
+    std::cout << mm << " " << nn << " " << kk << std::endl;
+    std::vector<int> sizes{mm,nn,kk};
+    size_t npts = (size_t) mm * nn * kk;
+    std::vector<std::complex<double>> X(npts), Y(npts), F(npts);
+    std::vector<double> sym(2 * npts);
+    for ( size_t i = 0; i < npts; i++ )
+        X[i] = std::complex<double>(1 - ((double) rand()) / (double) (RAND_MAX/2),
+                                    1 - ((double) rand()) / (double) (RAND_MAX/2));
+
+    // four slabs of a quarter of the cube each.
+    size_t mem_bytes = 4 * sizeof(std::complex<double>) * (npts / 4);
+    std::string path = "mddft_ooc.bin";
+    bool all_correct = true;
+
+    for ( int sign = -1; sign <= 1; sign += 2 ) {
+        std::ofstream ofs ( path, std::ios::binary );
+        ofs.write ( (const char *) X.data(), npts * sizeof(std::complex<double>) );
+        ofs.close();
+        mddft_ooc ( mm, nn, kk, sign, path, mem_bytes );
+        std::ifstream ifs ( path, std::ios::binary );
+        ifs.read ( (char *) F.data(), npts * sizeof(std::complex<double>) );
+        ifs.close();
+
+        double *dX = (double *) X.data(), *dY = (double *) Y.data(), *dsym = sym.data();
+        std::vector<void*> args{dY,dX,dsym};
+        if ( sign == -1 ) {
+            MDDFTProblem mdp(args, sizes, "mddft");
+            mdp.transform();
+        } else {
+            IMDDFTProblem imdp(args, sizes, "imddft");
+            imdp.transform();
+        }
+
+        double maxdelta = 0.0, maxval = 0.0;
+        for ( size_t i = 0; i < npts; i++ ) {
+            maxdelta = std::max ( maxdelta, std::abs ( F[i] - Y[i] ) );
+            maxval = std::max ( maxval, std::abs ( Y[i] ) );
+        }
+        bool correct = maxdelta <= 1e-12 * std::max ( maxval, 1.0 );
+        all_correct &= correct;
+        printf ( "%s out-of-core vs in-core: Correct: %s\tMax delta = %E\n",
+                 ( sign == -1 ? "forward" : "inverse" ), ( correct ? "True" : "False" ), maxdelta );
+    }
+    remove ( path.c_str() );
+
+    return all_correct ? 0 : 1;
+}
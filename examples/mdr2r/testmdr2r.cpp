@@ -0,0 +1,198 @@
+//  Copyright (c) 2018-2022, Carnegie Mellon University
+//  See LICENSE for details
+
+//  Runs the 3D DCTs and DSTs of types I, II and III, each with the same kind
+//  in every dimension and through "mdr2r" with mixed kinds, and checks them
+//  against a direct O(n^2) sum along each dimension, unnormalized as the
+//  SPIRAL transforms:
+//    DCT1: cos(pi k l / (n-1))           DST1: sin(pi (k+1) (l+1) / (n+1))
+//    DCT2: cos(pi k (2l+1) / (2n))       DST2: sin(pi (k+1) (2l+1) / (2n))
+//    DCT3: cos(pi (2k+1) l / (2n))       DST3: sin(pi (2k+1) (l+1) / (2n))
+
+#include "fftx3.hpp"
+#include "fftx3utilities.h"
+#include "interface.hpp"
+#include "mdr2rObj.hpp"
+#include <cstring>
+
+#if defined FFTX_CUDA
+#include "cudabackend.hpp"
+#elif defined FFTX_HIP
+#include "hipbackend.hpp"
+#else
+#include "cpubackend.hpp"
+#endif
+#if defined (FFTX_CUDA) || defined(FFTX_HIP)
+#include "device_macros.h"
+#endif
+
+#define TOLERANCE 1e-10
+
+//  device buffer of n doubles; host memory for CPU builds.
+static double *deviceAlloc ( size_t n )
+{
+    double *d;
+#if defined (FFTX_CUDA) || defined(FFTX_HIP)
+    DEVICE_MALLOC ( &d, n * sizeof(double) );
+#else
+    d = new double[n];
+#endif
+    return d;
+}
+
+static void deviceFree ( double *d )
+{
+#if defined (FFTX_CUDA) || defined(FFTX_HIP)
+    DEVICE_FREE ( d );
+#else
+    delete[] d;
+#endif
+}
+
+static void toDevice ( double *d, const void *h, size_t n )
+{
+#if defined (FFTX_CUDA) || defined(FFTX_HIP)
+    DEVICE_MEM_COPY ( d, h, n * sizeof(double), MEM_COPY_HOST_TO_DEVICE );
+#else
+    memcpy ( d, h, n * sizeof(double) );
+#endif
+}
+
+static void toHost ( void *h, const double *d, size_t n )
+{
+#if defined (FFTX_CUDA) || defined(FFTX_HIP)
+    DEVICE_MEM_COPY ( h, d, n * sizeof(double), MEM_COPY_DEVICE_TO_HOST );
+#else
+    memcpy ( h, d, n * sizeof(double) );
+#endif
+}
+
+//  {output, input, symbol} as the problems take them: CUDA takes the
+//  addresses of the device pointers.
+static std::vector<void*> problemArgs ( double **out, double **in, double **sym )
+{
+#if defined FFTX_CUDA
+    return { (void*) out, (void*) in, (void*) sym };
+#else
+    return { (void*) *out, (void*) *in, (void*) *sym };
+#endif
+}
+
+static double relError ( const double *out, const double *ref, size_t n )
+{
+    double d = 0.0, r = 0.0;
+    for ( size_t i = 0; i < n; i++ ) {
+        d += ( out[i] - ref[i] ) * ( out[i] - ref[i] );
+        r += ref[i] * ref[i];
+    }
+    return sqrt ( d / ( r > 0.0 ? r : 1.0 ) );
+}
+
+//  element (k, l) of the kind of transform of length n.
+static double r2rEntry ( r2r_t kind, int n, int k, int l )
+{
+    switch ( kind ) {
+    case DCT1: return cos ( M_PI * k * l / ( n - 1 ) );
+    case DCT2: return cos ( M_PI * k * ( 2*l + 1 ) / ( 2.0 * n ) );
+    case DCT3: return cos ( M_PI * ( 2*k + 1 ) * l / ( 2.0 * n ) );
+    case DST1: return sin ( M_PI * ( k + 1 ) * ( l + 1 ) / ( n + 1 ) );
+    case DST2: return sin ( M_PI * ( k + 1 ) * ( 2*l + 1 ) / ( 2.0 * n ) );
+    default:   return sin ( M_PI * ( 2*k + 1 ) * ( l + 1 ) / ( 2.0 * n ) );
+    }
+}
+
+//  the kind of transform along dimension d of the row major array a, in place.
+static void r2rAxis ( std::vector<double>& a, const int dims[3], int d, r2r_t kind )
+{
+    int n = dims[d];
+    size_t before = 1, after = 1;
+    for ( int e = 0; e < d; e++ ) before *= dims[e];
+    for ( int e = d + 1; e < 3; e++ ) after *= dims[e];
+    std::vector<double> t ( n );
+    for ( size_t p = 0; p < before; p++ ) {
+        for ( size_t q = 0; q < after; q++ ) {
+            for ( int k = 0; k < n; k++ ) {
+                t[k] = 0.0;
+                for ( int l = 0; l < n; l++ )
+                    t[k] += r2rEntry ( kind, n, k, l ) * a[( p * n + l ) * after + q];
+            }
+            for ( int k = 0; k < n; k++ )
+                a[( p * n + k ) * after + q] = t[k];
+        }
+    }
+}
+
+//  runs one transform and reports it against the direct sums.
+static bool check ( const std::string& name, const std::vector<int>& sizes )
+{
+    std::array<r2r_t, 3> kinds = r2rKinds ( name, sizes );
+    int dims[3] = { sizes.at(0), sizes.at(1), sizes.at(2) };
+    size_t npts = (size_t) dims[0] * dims[1] * dims[2];
+
+    std::vector<double> inputHost ( npts ), outputHost ( npts );
+    for ( size_t i = 0; i < npts; i++ )
+        inputHost[i] = 1 - ((double) rand()) / (double) (RAND_MAX/2);
+    std::vector<double> refHost = inputHost;
+    for ( int d = 0; d < 3; d++ )
+        r2rAxis ( refHost, dims, d, kinds[d] );
+
+    double *dX = deviceAlloc ( npts );
+    double *dY = deviceAlloc ( npts );
+    double *dsym = deviceAlloc ( 1 );
+    toDevice ( dX, inputHost.data(), npts );
+
+    MDR2RProblem rp ( problemArgs ( &dY, &dX, &dsym ), sizes, name );
+    rp.transform();
+    toHost ( outputHost.data(), dY, npts );
+
+    double err = relError ( outputHost.data(), refHost.data(), npts );
+    bool ok = err <= TOLERANCE;
+    printf ( "%-8s [ %d, %d, %d ] kinds [ %s, %s, %s ]:\trelative error = %E (%s)\n",
+             name.c_str(), dims[0], dims[1], dims[2], r2rName ( kinds[0] ), r2rName ( kinds[1] ),
+             r2rName ( kinds[2] ), err, ok ? "PASS" : "FAIL" );
+
+    deviceFree ( dX );
+    deviceFree ( dY );
+    deviceFree ( dsym );
+    return ok;
+}
+
+int main ( int argc, char* argv[] )
+{
+    int mm = 12, nn = 10, kk = 8;
+    char *prog = argv[0];
+    int baz = 0;
+
+    while ( argc > 1 && argv[1][0] == '-' ) {
+        switch ( argv[1][1] ) {
+        case 's':
+            argv++, argc--;
+            mm = atoi ( argv[1] );
+            while ( argv[1][baz] != 'x' ) baz++;
+            baz++ ;
+            nn = atoi ( & argv[1][baz] );
+            while ( argv[1][baz] != 'x' ) baz++;
+            baz++ ;
+            kk = atoi ( & argv[1][baz] );
+            break;
+        case 'h':
+            printf ( "Usage: %s: [ -s MMxNNxKK ] [ -h (print help message) ]\n", argv[0] );
+            exit (0);
+        default:
+            printf ( "%s: unknown argument: %s ... ignored\n", prog, argv[1] );
+        }
+        argv++, argc--;
+    }
+    std::cout << mm << " " << nn << " " << kk << std::endl;
+    srand ( time ( NULL ) );
+
+    bool passed = true;
+    const char *names[] = { "mddct", "imddct", "mddst", "imddst", "mddct1", "mddst1" };
+    for ( const char *name : names )
+        passed &= check ( name, { mm, nn, kk } );
+    passed &= check ( "mdr2r", { mm, nn, kk, DCT2, DST1, DCT3 } );
+    passed &= check ( "mdr2r", { mm, nn, kk, DST3, DCT1, DST2 } );
+
+    printf ( "%s: All done, exiting\n", prog );
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,212 @@
+//  Copyright (c) 2018-2022, Carnegie Mellon University
+//  See LICENSE for details
+
+//  Traces y = IPRDFT((kx^2 + ky^2) PRDFT(x) + conj(PRDFT(x))) / (mm nn kk) as
+//  one pipeline, with kx^2 + ky^2 built as k^2 + (i kz)^2 from multiply by a
+//  real and a complex expression, add, conjugate and scale. Checks it against
+//  separate mdprdft and imdprdft calls with the symbol applied by forall.
+
+#include "fftx3.hpp"
+#include "fftx3utilities.h"
+#include "interface.hpp"
+#include "mdprdftObj.hpp"
+#include "imdprdftObj.hpp"
+#include "pipelineObj.hpp"
+#include <cstring>
+#include <string>
+
+#if defined FFTX_CUDA
+#include "cudabackend.hpp"
+#elif defined FFTX_HIP
+#include "hipbackend.hpp"
+#else
+#include "cpubackend.hpp"
+#endif
+#if defined (FFTX_CUDA) || defined(FFTX_HIP)
+#include "device_macros.h"
+#endif
+
+#define TOLERANCE 1e-10
+
+//  device buffer of n doubles; host memory for CPU builds.
+static double *deviceAlloc ( size_t n )
+{
+    double *d;
+#if defined (FFTX_CUDA) || defined(FFTX_HIP)
+    DEVICE_MALLOC ( &d, n * sizeof(double) );
+#else
+    d = new double[n];
+#endif
+    return d;
+}
+
+static void deviceFree ( double *d )
+{
+#if defined (FFTX_CUDA) || defined(FFTX_HIP)
+    DEVICE_FREE ( d );
+#else
+    delete[] d;
+#endif
+}
+
+static void toDevice ( double *d, const void *h, size_t n )
+{
+#if defined (FFTX_CUDA) || defined(FFTX_HIP)
+    DEVICE_MEM_COPY ( d, h, n * sizeof(double), MEM_COPY_HOST_TO_DEVICE );
+#else
+    memcpy ( d, h, n * sizeof(double) );
+#endif
+}
+
+static void toHost ( void *h, const double *d, size_t n )
+{
+#if defined (FFTX_CUDA) || defined(FFTX_HIP)
+    DEVICE_MEM_COPY ( h, d, n * sizeof(double), MEM_COPY_DEVICE_TO_HOST );
+#else
+    memcpy ( h, d, n * sizeof(double) );
+#endif
+}
+
+//  {output, input, symbol} as the problems take them: CUDA takes the
+//  addresses of the device pointers.
+static std::vector<void*> problemArgs ( double **out, double **in, double **sym )
+{
+#if defined FFTX_CUDA
+    return { (void*) out, (void*) in, (void*) sym };
+#else
+    return { (void*) *out, (void*) *in, (void*) *sym };
+#endif
+}
+
+//  the signed frequency of 0-based index i of a DFT of length n.
+static int freq ( int i, int n )
+{
+    return ( i <= n/2 ) ? i : i - n;
+}
+
+static void traceLaplacian ( const std::vector<int>& sizes, const std::string& name )
+{
+    fftx::point_t<3> ext ( { { sizes.at(0), sizes.at(1), sizes.at(2) } } );
+    fftx::box_t<3> domain = domainFromSize ( ext );
+    fftx::box_t<3> fdomain = domainFromSize ( truncatedComplexDimensions ( ext ) );
+
+    fftx::pipeline_t<3> p;
+    fftx::array_t<3, double>& x = p.input<double> ( domain );
+    fftx::array_t<3, double>& y = p.output<double> ( domain );
+    fftx::array_t<3, std::complex<double>>& X = p.temporary<std::complex<double>> ( fdomain );
+    fftx::array_t<3, std::complex<double>>& A = p.temporary<std::complex<double>> ( fdomain );
+    fftx::array_t<3, std::complex<double>>& D = p.temporary<std::complex<double>> ( fdomain );
+    fftx::array_t<3, std::complex<double>>& D2 = p.temporary<std::complex<double>> ( fdomain );
+    fftx::array_t<3, std::complex<double>>& L = p.temporary<std::complex<double>> ( fdomain );
+    fftx::array_t<3, std::complex<double>>& C = p.temporary<std::complex<double>> ( fdomain );
+    fftx::array_t<3, std::complex<double>>& S = p.temporary<std::complex<double>> ( fdomain );
+    fftx::array_t<3, std::complex<double>>& T = p.temporary<std::complex<double>> ( fdomain );
+
+    fftx::expr_t kx = fftx::frequency ( 0, sizes.at(0) );
+    fftx::expr_t ky = fftx::frequency ( 1, sizes.at(1) );
+    fftx::expr_t kz = fftx::frequency ( 2, sizes.at(2) );
+
+    fftx::PRDFT ( ext, X, x );
+    fftx::multiply ( kx*kx + ky*ky + kz*kz, A, X );
+    fftx::multiply ( fftx::imaginary ( kz ), D, X );
+    fftx::multiply ( fftx::imaginary ( kz ), D2, D );
+    fftx::add ( L, A, D2 );
+    fftx::conjugate ( C, X );
+    fftx::add ( S, L, C );
+    fftx::scale ( 1.0 / ( (double) sizes.at(0) * sizes.at(1) * sizes.at(2) ), T, S );
+    fftx::IPRDFT ( ext, y, T );
+    p.close ( name );
+}
+
+int main ( int argc, char* argv[] )
+{
+    int mm = 16, nn = 16, kk = 16;
+    char *prog = argv[0];
+    int baz = 0;
+
+    while ( argc > 1 && argv[1][0] == '-' ) {
+        switch ( argv[1][1] ) {
+        case 's':
+            argv++, argc--;
+            mm = atoi ( argv[1] );
+            while ( argv[1][baz] != 'x' ) baz++;
+            baz++ ;
+            nn = atoi ( & argv[1][baz] );
+            while ( argv[1][baz] != 'x' ) baz++;
+            baz++ ;
+            kk = atoi ( & argv[1][baz] );
+            break;
+        case 'h':
+            printf ( "Usage: %s: [ -s MMxNNxKK ] [ -h (print help message) ]\n", argv[0] );
+            exit (0);
+        default:
+            printf ( "%s: unknown argument: %s ... ignored\n", prog, argv[1] );
+        }
+        argv++, argc--;
+    }
+    std::cout << mm << " " << nn << " " << kk << std::endl;
+    std::vector<int> sizes{mm, nn, kk};
+    fftx::point_t<3> ext ( { { mm, nn, kk } } );
+    fftx::box_t<3> domain = domainFromSize ( ext );
+    fftx::box_t<3> fdomain = domainFromSize ( truncatedComplexDimensions ( ext ) );
+    size_t npts = domain.size();
+    size_t fpts = fdomain.size();
+
+    fftx::array_t<3, double> inputHost ( domain );
+    fftx::array_t<3, std::complex<double>> spectrumHost ( fdomain );
+    fftx::array_t<3, double> refHost ( domain );
+    fftx::array_t<3, double> outputHost ( domain );
+
+    srand ( time ( NULL ) );
+    double *hostinp = inputHost.m_data.local();
+    for ( size_t i = 0; i < npts; i++ )
+        hostinp[i] = 1 - ((double) rand()) / (double) (RAND_MAX/2);
+
+    double *dX = deviceAlloc ( npts );
+    double *dY = deviceAlloc ( npts );
+    double *dF = deviceAlloc ( 2 * fpts );
+    double *dsym = deviceAlloc ( 2 * fpts );
+    toDevice ( dX, hostinp, npts );
+
+    //  reference: separate transforms, with the symbol applied on the host.
+    MDPRDFTProblem mdp ( problemArgs ( &dF, &dX, &dsym ), sizes, "mdprdft" );
+    mdp.transform();
+    toHost ( spectrumHost.m_data.local(), dF, 2 * fpts );
+    fftx::point_t<3> lo = fdomain.lo;
+    double norm = 1.0 / ( (double) mm * nn * kk );
+    forall ( [lo, mm, nn, norm] ( std::complex<double>(&v), const fftx::point_t<3>& p )
+             {
+                 int kx = freq ( p[0] - lo[0], mm ), ky = freq ( p[1] - lo[1], nn );
+                 v = norm * ( (double) ( kx*kx + ky*ky ) * v + std::conj ( v ) );
+             }, spectrumHost );
+    toDevice ( dF, spectrumHost.m_data.local(), 2 * fpts );
+    IMDPRDFTProblem imdp ( problemArgs ( &dY, &dF, &dsym ), sizes, "imdprdft" );
+    imdp.transform();
+    toHost ( refHost.m_data.local(), dY, npts );
+
+    //  the traced pipeline, as one generated function.
+    PIPELINEProblem pp ( problemArgs ( &dY, &dX, &dsym ), sizes, "laplacian_conj", traceLaplacian );
+    pp.transform();
+    toHost ( outputHost.m_data.local(), dY, npts );
+
+    double d = 0.0, r = 0.0;
+    double *ref = refHost.m_data.local(), *out = outputHost.m_data.local();
+    for ( size_t i = 0; i < npts; i++ ) {
+        d += ( out[i] - ref[i] ) * ( out[i] - ref[i] );
+        r += ref[i] * ref[i];
+    }
+    double err = sqrt ( d / ( r > 0.0 ? r : 1.0 ) );
+    bool passed = err <= TOLERANCE;
+    printf ( "cube = [ %d, %d, %d ]\tpipeline vs separate calls: relative error = %E (%s)\n",
+             mm, nn, kk, err, passed ? "PASS" : "FAIL" );
+    printf ( "Pipeline time %.7e ms, separate calls %.7e ms\n",
+             pp.getTime(), mdp.getTime() + imdp.getTime() );
+
+    deviceFree ( dX );
+    deviceFree ( dY );
+    deviceFree ( dF );
+    deviceFree ( dsym );
+
+    printf ( "%s: All done, exiting\n", prog );
+    return passed ? 0 : 1;
+}
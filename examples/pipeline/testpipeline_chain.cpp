@@ -0,0 +1,241 @@
+//  Copyright (c) 2018-2022, Carnegie Mellon University
+//  See LICENSE for details
+
+//  Runs z = extract(IPRDFT(symbol * PRDFT(x))) through PIPELINEProblem as one
+//  generated function and checks it against separate mdprdft and imdprdft
+//  calls, with the symbol and the extraction done on the host. Then traces
+//  another chain under the same name, with the symbol replaced by a scale of
+//  2, and checks that it gets its own code: z = 2 mm nn kk extract(x).
+
+#include "fftx3.hpp"
+#include "fftx3utilities.h"
+#include "interface.hpp"
+#include "mdprdftObj.hpp"
+#include "imdprdftObj.hpp"
+#include "pipelineObj.hpp"
+#include <cstring>
+#include <string>
+
+#if defined FFTX_CUDA
+#include "cudabackend.hpp"
+#elif defined FFTX_HIP
+#include "hipbackend.hpp"
+#else
+#include "cpubackend.hpp"
+#endif
+#if defined (FFTX_CUDA) || defined(FFTX_HIP)
+#include "device_macros.h"
+#endif
+
+#define TOLERANCE 1e-10
+
+//  device buffer of n doubles; host memory for CPU builds.
+static double *deviceAlloc ( size_t n )
+{
+    double *d;
+#if defined (FFTX_CUDA) || defined(FFTX_HIP)
+    DEVICE_MALLOC ( &d, n * sizeof(double) );
+#else
+    d = new double[n];
+#endif
+    return d;
+}
+
+static void deviceFree ( double *d )
+{
+#if defined (FFTX_CUDA) || defined(FFTX_HIP)
+    DEVICE_FREE ( d );
+#else
+    delete[] d;
+#endif
+}
+
+static void toDevice ( double *d, const void *h, size_t n )
+{
+#if defined (FFTX_CUDA) || defined(FFTX_HIP)
+    DEVICE_MEM_COPY ( d, h, n * sizeof(double), MEM_COPY_HOST_TO_DEVICE );
+#else
+    memcpy ( d, h, n * sizeof(double) );
+#endif
+}
+
+static void toHost ( void *h, const double *d, size_t n )
+{
+#if defined (FFTX_CUDA) || defined(FFTX_HIP)
+    DEVICE_MEM_COPY ( h, d, n * sizeof(double), MEM_COPY_DEVICE_TO_HOST );
+#else
+    memcpy ( h, d, n * sizeof(double) );
+#endif
+}
+
+//  {output, input, symbol} as the problems take them: CUDA takes the
+//  addresses of the device pointers.
+static std::vector<void*> problemArgs ( double **out, double **in, double **sym )
+{
+#if defined FFTX_CUDA
+    return { (void*) out, (void*) in, (void*) sym };
+#else
+    return { (void*) *out, (void*) *in, (void*) *sym };
+#endif
+}
+
+//  the middle half of the cube in each dimension, 0-based in the cube as
+//  extractBox takes it.
+static fftx::box_t<3> middleBox ( const std::vector<int>& sizes )
+{
+    fftx::box_t<3> bx;
+    for ( int d = 0; d < 3; d++ ) {
+        bx.lo[d] = sizes.at(d) / 4;
+        bx.hi[d] = sizes.at(d) / 4 + sizes.at(d) / 2 - 1;
+    }
+    return bx;
+}
+
+//  symbol selects the middle step: the symbol argument, or a scale of 2.
+static void traceChain ( const std::vector<int>& sizes, const std::string& name, bool symbol )
+{
+    fftx::point_t<3> ext ( { { sizes.at(0), sizes.at(1), sizes.at(2) } } );
+    fftx::box_t<3> domain = domainFromSize ( ext );
+    fftx::box_t<3> fdomain = domainFromSize ( truncatedComplexDimensions ( ext ) );
+
+    //  the symbol is the symbol argument; only its size goes into the trace.
+    fftx::array_t<3, double> sym ( fdomain );
+    fftx::pipeline_t<3> p;
+    fftx::array_t<3, double>& x = p.input<double> ( domain );
+    fftx::array_t<3, double>& z = p.output<double> ( middleBox ( sizes ) );
+    fftx::array_t<3, std::complex<double>>& X = p.temporary<std::complex<double>> ( fdomain );
+    fftx::array_t<3, std::complex<double>>& Y = p.temporary<std::complex<double>> ( fdomain );
+    fftx::array_t<3, double>& y = p.temporary<double> ( domain );
+
+    fftx::PRDFT ( ext, X, x );
+    if ( symbol )
+        fftx::kernel ( sym, Y, X );
+    else
+        fftx::scale ( 2.0, Y, X );
+    fftx::IPRDFT ( ext, y, Y );
+    fftx::extractBox ( z, y );
+    p.close ( name );
+}
+
+static double relError ( const double *out, const double *ref, size_t n )
+{
+    double d = 0.0, r = 0.0;
+    for ( size_t i = 0; i < n; i++ ) {
+        d += ( out[i] - ref[i] ) * ( out[i] - ref[i] );
+        r += ref[i] * ref[i];
+    }
+    return sqrt ( d / ( r > 0.0 ? r : 1.0 ) );
+}
+
+//  the middle box of the cube a, row major, into z.
+static void extractHost ( double *z, const double *a, const std::vector<int>& sizes )
+{
+    fftx::box_t<3> bx = middleBox ( sizes );
+    size_t i = 0;
+    for ( int m = bx.lo[0]; m <= bx.hi[0]; m++ )
+        for ( int n = bx.lo[1]; n <= bx.hi[1]; n++ )
+            for ( int k = bx.lo[2]; k <= bx.hi[2]; k++ )
+                z[i++] = a[( (size_t) m * sizes.at(1) + n ) * sizes.at(2) + k];
+}
+
+int main ( int argc, char* argv[] )
+{
+    int mm = 16, nn = 16, kk = 16;
+    char *prog = argv[0];
+    int baz = 0;
+
+    while ( argc > 1 && argv[1][0] == '-' ) {
+        switch ( argv[1][1] ) {
+        case 's':
+            argv++, argc--;
+            mm = atoi ( argv[1] );
+            while ( argv[1][baz] != 'x' ) baz++;
+            baz++ ;
+            nn = atoi ( & argv[1][baz] );
+            while ( argv[1][baz] != 'x' ) baz++;
+            baz++ ;
+            kk = atoi ( & argv[1][baz] );
+            break;
+        case 'h':
+            printf ( "Usage: %s: [ -s MMxNNxKK ] [ -h (print help message) ]\n", argv[0] );
+            exit (0);
+        default:
+            printf ( "%s: unknown argument: %s ... ignored\n", prog, argv[1] );
+        }
+        argv++, argc--;
+    }
+    std::cout << mm << " " << nn << " " << kk << std::endl;
+    std::vector<int> sizes{mm, nn, kk};
+    fftx::point_t<3> ext ( { { mm, nn, kk } } );
+    fftx::box_t<3> domain = domainFromSize ( ext );
+    fftx::box_t<3> fdomain = domainFromSize ( truncatedComplexDimensions ( ext ) );
+    size_t npts = domain.size();
+    size_t fpts = fdomain.size();
+    size_t zpts = middleBox ( sizes ).size();
+
+    std::vector<double> inputHost ( npts ), symHost ( fpts ), cubeHost ( npts );
+    std::vector<std::complex<double>> spectrumHost ( fpts );
+    std::vector<double> refHost ( zpts ), outputHost ( zpts );
+
+    srand ( time ( NULL ) );
+    for ( size_t i = 0; i < npts; i++ )
+        inputHost[i] = 1 - ((double) rand()) / (double) (RAND_MAX/2);
+    for ( size_t i = 0; i < fpts; i++ )
+        symHost[i] = ((double) rand()) / RAND_MAX;
+
+    double *dX = deviceAlloc ( npts );
+    double *dY = deviceAlloc ( npts );
+    double *dZ = deviceAlloc ( zpts );
+    double *dF = deviceAlloc ( 2 * fpts );
+    double *dsym = deviceAlloc ( fpts );
+    toDevice ( dX, inputHost.data(), npts );
+    toDevice ( dsym, symHost.data(), fpts );
+
+    //  reference: separate transforms, with the symbol and the extraction on the host.
+    MDPRDFTProblem mdp ( problemArgs ( &dF, &dX, &dsym ), sizes, "mdprdft" );
+    mdp.transform();
+    toHost ( spectrumHost.data(), dF, 2 * fpts );
+    for ( size_t i = 0; i < fpts; i++ )
+        spectrumHost[i] *= symHost[i];
+    toDevice ( dF, spectrumHost.data(), 2 * fpts );
+    IMDPRDFTProblem imdp ( problemArgs ( &dY, &dF, &dsym ), sizes, "imdprdft" );
+    imdp.transform();
+    toHost ( cubeHost.data(), dY, npts );
+    extractHost ( refHost.data(), cubeHost.data(), sizes );
+
+    bool passed = true;
+    PIPELINEProblem pp ( problemArgs ( &dZ, &dX, &dsym ), sizes, "chain",
+                         [] ( const std::vector<int>& s, const std::string& n ) { traceChain ( s, n, true ); } );
+    pp.transform();
+    toHost ( outputHost.data(), dZ, zpts );
+    double err = relError ( outputHost.data(), refHost.data(), zpts );
+    passed &= err <= TOLERANCE;
+    printf ( "cube = [ %d, %d, %d ]\tPRDFT, symbol, IPRDFT, extractBox vs separate calls: relative error = %E (%s)\n",
+             mm, nn, kk, err, err <= TOLERANCE ? "PASS" : "FAIL" );
+    printf ( "Pipeline time %.7e ms, separate calls %.7e ms\n",
+             pp.getTime(), mdp.getTime() + imdp.getTime() );
+
+    //  same name, different chain: the cache must not hand back the code above.
+    PIPELINEProblem ps ( problemArgs ( &dZ, &dX, &dsym ), sizes, "chain",
+                         [] ( const std::vector<int>& s, const std::string& n ) { traceChain ( s, n, false ); } );
+    bool distinct = ps.cacheName() != pp.cacheName();
+    passed &= distinct;
+    ps.transform();
+    toHost ( outputHost.data(), dZ, zpts );
+    extractHost ( refHost.data(), inputHost.data(), sizes );
+    for ( size_t i = 0; i < zpts; i++ )
+        refHost[i] *= 2.0 * npts;
+    err = relError ( outputHost.data(), refHost.data(), zpts );
+    passed &= err <= TOLERANCE;
+    printf ( "cube = [ %d, %d, %d ]\tsame name, scaled chain (%s cache key): relative error = %E (%s)\n",
+             mm, nn, kk, distinct ? "own" : "SHARED", err, err <= TOLERANCE ? "PASS" : "FAIL" );
+
+    deviceFree ( dX );
+    deviceFree ( dY );
+    deviceFree ( dZ );
+    deviceFree ( dF );
+    deviceFree ( dsym );
+
+    printf ( "%s: All done, exiting\n", prog );
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,169 @@
+//  Copyright (c) 2018-2022, Carnegie Mellon University
+//  See LICENSE for details
+
+//  Runs RCONVBATProblem, one input convolved with S random real symbols in
+//  one generated function, and checks each of the S results against a
+//  separate RCONVProblem call with that symbol.
+
+#include "fftx3.hpp"
+#include "fftx3utilities.h"
+#include "interface.hpp"
+#include "rconvbatObj.hpp"
+#include "../rconv/rconvObj.hpp"
+#include <cstring>
+
+#if defined FFTX_CUDA
+#include "cudabackend.hpp"
+#elif defined FFTX_HIP
+#include "hipbackend.hpp"
+#else
+#include "cpubackend.hpp"
+#endif
+#if defined (FFTX_CUDA) || defined(FFTX_HIP)
+#include "device_macros.h"
+#endif
+
+#define TOLERANCE 1e-10
+
+//  device buffer of n doubles; host memory for CPU builds.
+static double *deviceAlloc ( size_t n )
+{
+    double *d;
+#if defined (FFTX_CUDA) || defined(FFTX_HIP)
+    DEVICE_MALLOC ( &d, n * sizeof(double) );
+#else
+    d = new double[n];
+#endif
+    return d;
+}
+
+static void deviceFree ( double *d )
+{
+#if defined (FFTX_CUDA) || defined(FFTX_HIP)
+    DEVICE_FREE ( d );
+#else
+    delete[] d;
+#endif
+}
+
+static void toDevice ( double *d, const void *h, size_t n )
+{
+#if defined (FFTX_CUDA) || defined(FFTX_HIP)
+    DEVICE_MEM_COPY ( d, h, n * sizeof(double), MEM_COPY_HOST_TO_DEVICE );
+#else
+    memcpy ( d, h, n * sizeof(double) );
+#endif
+}
+
+static void toHost ( void *h, const double *d, size_t n )
+{
+#if defined (FFTX_CUDA) || defined(FFTX_HIP)
+    DEVICE_MEM_COPY ( h, d, n * sizeof(double), MEM_COPY_DEVICE_TO_HOST );
+#else
+    memcpy ( h, d, n * sizeof(double) );
+#endif
+}
+
+//  {output, input, symbol} as the problems take them: CUDA takes the
+//  addresses of the device pointers.
+static std::vector<void*> problemArgs ( double **out, double **in, double **sym )
+{
+#if defined FFTX_CUDA
+    return { (void*) out, (void*) in, (void*) sym };
+#else
+    return { (void*) *out, (void*) *in, (void*) *sym };
+#endif
+}
+
+static double relError ( const double *out, const double *ref, size_t n )
+{
+    double d = 0.0, r = 0.0;
+    for ( size_t i = 0; i < n; i++ ) {
+        d += ( out[i] - ref[i] ) * ( out[i] - ref[i] );
+        r += ref[i] * ref[i];
+    }
+    return sqrt ( d / ( r > 0.0 ? r : 1.0 ) );
+}
+
+int main ( int argc, char* argv[] )
+{
+    int mm = 16, nn = 16, kk = 16, count = 3;
+    char *prog = argv[0];
+    int baz = 0;
+
+    while ( argc > 1 && argv[1][0] == '-' ) {
+        switch ( argv[1][1] ) {
+        case 'b':
+            argv++, argc--;
+            count = atoi ( argv[1] );
+            break;
+        case 's':
+            argv++, argc--;
+            mm = atoi ( argv[1] );
+            while ( argv[1][baz] != 'x' ) baz++;
+            baz++ ;
+            nn = atoi ( & argv[1][baz] );
+            while ( argv[1][baz] != 'x' ) baz++;
+            baz++ ;
+            kk = atoi ( & argv[1][baz] );
+            break;
+        case 'h':
+            printf ( "Usage: %s: [ -b symbols ] [ -s MMxNNxKK ] [ -h (print help message) ]\n", argv[0] );
+            exit (0);
+        default:
+            printf ( "%s: unknown argument: %s ... ignored\n", prog, argv[1] );
+        }
+        argv++, argc--;
+    }
+    std::cout << mm << " " << nn << " " << kk << ", " << count << " symbols" << std::endl;
+    std::vector<int> sizes{mm, nn, kk};
+    fftx::point_t<3> ext ( { { mm, nn, kk } } );
+    size_t npts = domainFromSize ( ext ).size();
+    size_t fpts = domainFromSize ( truncatedComplexDimensions ( ext ) ).size();
+
+    std::vector<double> inputHost ( npts ), symHost ( count * fpts );
+    std::vector<double> outputHost ( count * npts ), refHost ( npts );
+
+    srand ( time ( NULL ) );
+    for ( size_t i = 0; i < npts; i++ )
+        inputHost[i] = 1 - ((double) rand()) / (double) (RAND_MAX/2);
+    for ( size_t i = 0; i < count * fpts; i++ )
+        symHost[i] = ((double) rand()) / RAND_MAX;
+
+    double *dX = deviceAlloc ( npts );
+    double *dY = deviceAlloc ( count * npts );
+    double *dR = deviceAlloc ( npts );
+    double *dsyms = deviceAlloc ( count * fpts );
+    double *dsym = deviceAlloc ( fpts );
+    toDevice ( dX, inputHost.data(), npts );
+    toDevice ( dsyms, symHost.data(), count * fpts );
+
+    RCONVBATProblem rbp ( problemArgs ( &dY, &dX, &dsyms ), { mm, nn, kk, count }, "rconvbat" );
+    rbp.transform();
+    toHost ( outputHost.data(), dY, count * npts );
+
+    bool passed = true;
+    double separate = 0.0;
+    for ( int s = 0; s < count; s++ ) {
+        toDevice ( dsym, symHost.data() + s * fpts, fpts );
+        RCONVProblem rp ( problemArgs ( &dR, &dX, &dsym ), sizes, "rconv" );
+        rp.transform();
+        separate += rp.getTime();
+        toHost ( refHost.data(), dR, npts );
+
+        double err = relError ( outputHost.data() + s * npts, refHost.data(), npts );
+        passed &= err <= TOLERANCE;
+        printf ( "cube = [ %d, %d, %d ]\tsymbol %d of %d vs rconv: relative error = %E (%s)\n",
+                 mm, nn, kk, s, count, err, err <= TOLERANCE ? "PASS" : "FAIL" );
+    }
+    printf ( "rconvbat time %.7e ms, %d rconv calls %.7e ms\n", rbp.getTime(), count, separate );
+
+    deviceFree ( dX );
+    deviceFree ( dY );
+    deviceFree ( dR );
+    deviceFree ( dsyms );
+    deviceFree ( dsym );
+
+    printf ( "%s: All done, exiting\n", prog );
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,233 @@
+//  Copyright (c) 2018-2022, Carnegie Mellon University
+//  See LICENSE for details
+
+//  Checks RCONVCProblem and RCONVSEPProblem against RCONVProblem with the
+//  equivalent real symbol. A real symbol s is passed as s + 0i. A complex
+//  symbol s(k) exp(-2 pi i k.d/n) is checked as rconv with s of the input
+//  cyclically shifted by d, since the forward transform of the shifted
+//  input is the spectrum times that phase. The separable factors of
+//  rconvsep are expanded to their product for rconv.
+
+#include "fftx3.hpp"
+#include "fftx3utilities.h"
+#include "interface.hpp"
+#include "rconvcObj.hpp"
+#include "rconvsepObj.hpp"
+#include "../rconv/rconvObj.hpp"
+#include <complex>
+#include <cstring>
+
+#if defined FFTX_CUDA
+#include "cudabackend.hpp"
+#elif defined FFTX_HIP
+#include "hipbackend.hpp"
+#else
+#include "cpubackend.hpp"
+#endif
+#if defined (FFTX_CUDA) || defined(FFTX_HIP)
+#include "device_macros.h"
+#endif
+
+#define TOLERANCE 1e-10
+
+//  device buffer of n doubles; host memory for CPU builds.
+static double *deviceAlloc ( size_t n )
+{
+    double *d;
+#if defined (FFTX_CUDA) || defined(FFTX_HIP)
+    DEVICE_MALLOC ( &d, n * sizeof(double) );
+#else
+    d = new double[n];
+#endif
+    return d;
+}
+
+static void deviceFree ( double *d )
+{
+#if defined (FFTX_CUDA) || defined(FFTX_HIP)
+    DEVICE_FREE ( d );
+#else
+    delete[] d;
+#endif
+}
+
+static void toDevice ( double *d, const void *h, size_t n )
+{
+#if defined (FFTX_CUDA) || defined(FFTX_HIP)
+    DEVICE_MEM_COPY ( d, h, n * sizeof(double), MEM_COPY_HOST_TO_DEVICE );
+#else
+    memcpy ( d, h, n * sizeof(double) );
+#endif
+}
+
+static void toHost ( void *h, const double *d, size_t n )
+{
+#if defined (FFTX_CUDA) || defined(FFTX_HIP)
+    DEVICE_MEM_COPY ( h, d, n * sizeof(double), MEM_COPY_DEVICE_TO_HOST );
+#else
+    memcpy ( h, d, n * sizeof(double) );
+#endif
+}
+
+//  {output, input, symbol} as the problems take them: CUDA takes the
+//  addresses of the device pointers.
+static std::vector<void*> problemArgs ( double **out, double **in, double **sym )
+{
+#if defined FFTX_CUDA
+    return { (void*) out, (void*) in, (void*) sym };
+#else
+    return { (void*) *out, (void*) *in, (void*) *sym };
+#endif
+}
+
+static double relError ( const double *out, const double *ref, size_t n )
+{
+    double d = 0.0, r = 0.0;
+    for ( size_t i = 0; i < n; i++ ) {
+        d += ( out[i] - ref[i] ) * ( out[i] - ref[i] );
+        r += ref[i] * ref[i];
+    }
+    return sqrt ( d / ( r > 0.0 ? r : 1.0 ) );
+}
+
+typedef std::complex<double> cplx;
+
+//  the shift applied through the complex symbols.
+static const int shift[3] = { 1, 2, 3 };
+
+//  exp(-2 pi i k shift[d] / n[d]) at index k in dimension d of the spectrum.
+static cplx phase ( int d, int k, const int n[3] )
+{
+    return std::polar ( 1.0, -2.0 * M_PI * ((double) k * shift[d] / n[d]) );
+}
+
+//  rconv of x with the real symbol sym, as the reference.
+static void rconvRef ( std::vector<double>& ref, const std::vector<double>& x, const std::vector<double>& sym,
+                       const std::vector<int>& sizes )
+{
+    double *dX = deviceAlloc ( x.size() );
+    double *dY = deviceAlloc ( x.size() );
+    double *dsym = deviceAlloc ( sym.size() );
+    toDevice ( dX, x.data(), x.size() );
+    toDevice ( dsym, sym.data(), sym.size() );
+    RCONVProblem rp ( problemArgs ( &dY, &dX, &dsym ), sizes, "rconv" );
+    rp.transform();
+    toHost ( ref.data(), dY, x.size() );
+    deviceFree ( dX );
+    deviceFree ( dY );
+    deviceFree ( dsym );
+}
+
+//  runs name with the symbol argument sym, nsym doubles, and reports it against ref.
+template<class PROBLEM>
+static bool check ( const char *name, const char *label, const std::vector<double>& x, const void *sym,
+                    size_t nsym, const std::vector<double>& ref, const std::vector<int>& sizes )
+{
+    std::vector<double> out ( x.size() );
+    double *dX = deviceAlloc ( x.size() );
+    double *dY = deviceAlloc ( x.size() );
+    double *dsym = deviceAlloc ( nsym );
+    toDevice ( dX, x.data(), x.size() );
+    toDevice ( dsym, sym, nsym );
+    PROBLEM p ( problemArgs ( &dY, &dX, &dsym ), sizes, name );
+    p.transform();
+    toHost ( out.data(), dY, x.size() );
+    deviceFree ( dX );
+    deviceFree ( dY );
+    deviceFree ( dsym );
+
+    double err = relError ( out.data(), ref.data(), x.size() );
+    bool ok = err <= TOLERANCE;
+    printf ( "cube = [ %d, %d, %d ]\t%-8s %-36s relative error = %E (%s)\n",
+             sizes.at(0), sizes.at(1), sizes.at(2), name, label, err, ok ? "PASS" : "FAIL" );
+    return ok;
+}
+
+int main ( int argc, char* argv[] )
+{
+    int mm = 16, nn = 16, kk = 16;
+    char *prog = argv[0];
+    int baz = 0;
+
+    while ( argc > 1 && argv[1][0] == '-' ) {
+        switch ( argv[1][1] ) {
+        case 's':
+            argv++, argc--;
+            mm = atoi ( argv[1] );
+            while ( argv[1][baz] != 'x' ) baz++;
+            baz++ ;
+            nn = atoi ( & argv[1][baz] );
+            while ( argv[1][baz] != 'x' ) baz++;
+            baz++ ;
+            kk = atoi ( & argv[1][baz] );
+            break;
+        case 'h':
+            printf ( "Usage: %s: [ -s MMxNNxKK ] [ -h (print help message) ]\n", argv[0] );
+            exit (0);
+        default:
+            printf ( "%s: unknown argument: %s ... ignored\n", prog, argv[1] );
+        }
+        argv++, argc--;
+    }
+    std::cout << mm << " " << nn << " " << kk << std::endl;
+    srand ( time ( NULL ) );
+
+    std::vector<int> sizes{mm, nn, kk};
+    int n[3] = { mm, nn, kk };
+    fftx::point_t<3> ext ( { { mm, nn, kk } } );
+    fftx::point_t<3> fext = truncatedComplexDimensions ( ext );
+    int f[3] = { fext[0], fext[1], fext[2] };
+    size_t npts = (size_t) mm * nn * kk;
+    size_t fpts = (size_t) f[0] * f[1] * f[2];
+
+    //  the input, and the input cyclically shifted by shift.
+    std::vector<double> x ( npts ), xs ( npts ), ref ( npts );
+    for ( size_t i = 0; i < npts; i++ )
+        x[i] = 1 - ((double) rand()) / (double) (RAND_MAX/2);
+    for ( int i = 0; i < mm; i++ )
+        for ( int j = 0; j < nn; j++ )
+            for ( int k = 0; k < kk; k++ )
+                xs[( (size_t) i * nn + j ) * kk + k] =
+                    x[( (size_t) ( (i - shift[0] + mm) % mm ) * nn + (j - shift[1] + nn) % nn ) * kk + (k - shift[2] + kk) % kk];
+
+    bool passed = true;
+
+    //  rconvc: a real symbol, then the same symbol with the shift phase.
+    std::vector<double> sym ( fpts );
+    std::vector<cplx> csym ( fpts );
+    for ( size_t i = 0; i < fpts; i++ ) {
+        sym[i] = ((double) rand()) / RAND_MAX;
+        csym[i] = sym[i];
+    }
+    rconvRef ( ref, x, sym, sizes );
+    passed &= check<RCONVCProblem> ( "rconvc", "real symbol vs rconv", x, csym.data(), 2 * fpts, ref, sizes );
+
+    size_t p = 0;
+    for ( int i = 0; i < f[0]; i++ )
+        for ( int j = 0; j < f[1]; j++ )
+            for ( int k = 0; k < f[2]; k++, p++ )
+                csym[p] = sym[p] * phase ( 0, i, n ) * phase ( 1, j, n ) * phase ( 2, k, n );
+    rconvRef ( ref, xs, sym, sizes );
+    passed &= check<RCONVCProblem> ( "rconvc", "shift symbol vs rconv of shifted x", x, csym.data(), 2 * fpts, ref, sizes );
+
+    //  rconvsep: real factors, then the same factors with the shift phase.
+    std::vector<cplx> factors ( f[0] + f[1] + f[2] );
+    for ( size_t i = 0; i < factors.size(); i++ )
+        factors[i] = ((double) rand()) / RAND_MAX;
+    p = 0;
+    for ( int i = 0; i < f[0]; i++ )
+        for ( int j = 0; j < f[1]; j++ )
+            for ( int k = 0; k < f[2]; k++ )
+                sym[p++] = ( factors[i] * factors[f[0] + j] * factors[f[0] + f[1] + k] ).real();
+    rconvRef ( ref, x, sym, sizes );
+    passed &= check<RCONVSEPProblem> ( "rconvsep", "real factors vs rconv", x, factors.data(), 2 * factors.size(), ref, sizes );
+
+    for ( int d = 0, o = 0; d < 3; o += f[d], d++ )
+        for ( int k = 0; k < f[d]; k++ )
+            factors[o + k] *= phase ( d, k, n );
+    rconvRef ( ref, xs, sym, sizes );
+    passed &= check<RCONVSEPProblem> ( "rconvsep", "shift factors vs rconv of shifted x", x, factors.data(), 2 * factors.size(), ref, sizes );
+
+    printf ( "%s: All done, exiting\n", prog );
+    return passed ? 0 : 1;
+}
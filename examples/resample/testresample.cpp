@@ -0,0 +1,215 @@
+//  Copyright (c) 2018-2022, Carnegie Mellon University
+//  See LICENSE for details
+
+//  Runs RESAMPLEProblem on the library case, 2x refinement without shift, and
+//  on run time cases with a shift and a grid ratio other than 2, and checks
+//  each against zero-padded FFT interpolation on the host: a direct DFT of
+//  each line of the input, evaluated on the output points of that line.
+//  The input is band limited, so the Nyquist convention plays no part.
+
+#include "fftx3.hpp"
+#include "fftx3utilities.h"
+#include "interface.hpp"
+#include "resampleObj.hpp"
+#include <complex>
+#include <cstring>
+
+#if defined FFTX_CUDA
+#include "cudabackend.hpp"
+#elif defined FFTX_HIP
+#include "hipbackend.hpp"
+#else
+#include "cpubackend.hpp"
+#endif
+#if defined (FFTX_CUDA) || defined(FFTX_HIP)
+#include "device_macros.h"
+#endif
+
+#define TOLERANCE 1e-10
+
+//  device buffer of n doubles; host memory for CPU builds.
+static double *deviceAlloc ( size_t n )
+{
+    double *d;
+#if defined (FFTX_CUDA) || defined(FFTX_HIP)
+    DEVICE_MALLOC ( &d, n * sizeof(double) );
+#else
+    d = new double[n];
+#endif
+    return d;
+}
+
+static void deviceFree ( double *d )
+{
+#if defined (FFTX_CUDA) || defined(FFTX_HIP)
+    DEVICE_FREE ( d );
+#else
+    delete[] d;
+#endif
+}
+
+static void toDevice ( double *d, const void *h, size_t n )
+{
+#if defined (FFTX_CUDA) || defined(FFTX_HIP)
+    DEVICE_MEM_COPY ( d, h, n * sizeof(double), MEM_COPY_HOST_TO_DEVICE );
+#else
+    memcpy ( d, h, n * sizeof(double) );
+#endif
+}
+
+static void toHost ( void *h, const double *d, size_t n )
+{
+#if defined (FFTX_CUDA) || defined(FFTX_HIP)
+    DEVICE_MEM_COPY ( h, d, n * sizeof(double), MEM_COPY_DEVICE_TO_HOST );
+#else
+    memcpy ( h, d, n * sizeof(double) );
+#endif
+}
+
+//  {output, input, symbol} as the problems take them: CUDA takes the
+//  addresses of the device pointers.
+static std::vector<void*> problemArgs ( double **out, double **in, double **sym )
+{
+#if defined FFTX_CUDA
+    return { (void*) out, (void*) in, (void*) sym };
+#else
+    return { (void*) *out, (void*) *in, (void*) *sym };
+#endif
+}
+
+static double relError ( const double *out, const double *ref, size_t n )
+{
+    double d = 0.0, r = 0.0;
+    for ( size_t i = 0; i < n; i++ ) {
+        d += ( out[i] - ref[i] ) * ( out[i] - ref[i] );
+        r += ref[i] * ref[i];
+    }
+    return sqrt ( d / ( r > 0.0 ? r : 1.0 ) );
+}
+
+//  zero-padded FFT interpolation of the row major array a along dimension d,
+//  from dims[d] points onto nout, output j at j dims[d] / nout + shift input
+//  cells. The Nyquist term of an even length is split between +n/2 and -n/2.
+static std::vector<double> interpAxis ( const std::vector<double>& a, int dims[3], int d, int nout, double shift )
+{
+    int n = dims[d];
+    size_t before = 1, after = 1;
+    for ( int e = 0; e < d; e++ ) before *= dims[e];
+    for ( int e = d + 1; e < 3; e++ ) after *= dims[e];
+    std::vector<double> b ( before * nout * after );
+    std::vector<std::complex<double>> X ( n );
+
+    for ( size_t p = 0; p < before; p++ ) {
+        for ( size_t q = 0; q < after; q++ ) {
+            for ( int k = 0; k < n; k++ ) {
+                X[k] = 0.0;
+                for ( int i = 0; i < n; i++ )
+                    X[k] += a[( p * n + i ) * after + q] * std::polar ( 1.0, -2.0 * M_PI * ((double) k * i / n) );
+            }
+            for ( int j = 0; j < nout; j++ ) {
+                double t = (double) j * n / nout + shift;
+                double y = X[0].real();
+                for ( int k = 1; 2 * k < n; k++ )
+                    y += 2.0 * ( X[k] * std::polar ( 1.0, 2.0 * M_PI * k * t / n ) ).real();
+                if ( n % 2 == 0 )
+                    y += X[n/2].real() * cos ( M_PI * t );
+                b[( p * nout + j ) * after + q] = y / n;
+            }
+        }
+    }
+    dims[d] = nout;
+    return b;
+}
+
+//  a sum of plane waves below the Nyquist frequency of each dimension.
+static void bandLimited ( std::vector<double>& x, const int dims[3] )
+{
+    std::fill ( x.begin(), x.end(), 0.0 );
+    for ( int w = 0; w < 8; w++ ) {
+        int k[3];
+        for ( int d = 0; d < 3; d++ ) {
+            int kmax = ( dims[d] - 1 ) / 2;
+            k[d] = rand() % ( 2 * kmax + 1 ) - kmax;
+        }
+        double amp = ((double) rand()) / RAND_MAX;
+        double phase = 2.0 * M_PI * ((double) rand()) / RAND_MAX;
+        size_t i = 0;
+        for ( int m = 0; m < dims[0]; m++ )
+            for ( int n = 0; n < dims[1]; n++ )
+                for ( int l = 0; l < dims[2]; l++ )
+                    x[i++] += amp * cos ( 2.0 * M_PI * ( (double) k[0] * m / dims[0] + (double) k[1] * n / dims[1]
+                                                         + (double) k[2] * l / dims[2] ) + phase );
+    }
+}
+
+//  runs one resampling and reports it against the host interpolation.
+static bool check ( const std::vector<int>& sizes, const char *label )
+{
+    std::vector<int> r = resampleSizes ( sizes );
+    int dims[3] = { r[3], r[4], r[5] };
+    size_t ipts = (size_t) r[3] * r[4] * r[5];
+    size_t opts = (size_t) r[0] * r[1] * r[2];
+
+    std::vector<double> inputHost ( ipts ), outputHost ( opts );
+    bandLimited ( inputHost, dims );
+    std::vector<double> refHost = inputHost;
+    for ( int d = 0; d < 3; d++ )
+        refHost = interpAxis ( refHost, dims, d, r[d], r[6+d] / (double) r[9] );
+
+    double *dX = deviceAlloc ( ipts );
+    double *dY = deviceAlloc ( opts );
+    double *dsym = deviceAlloc ( 1 );
+    toDevice ( dX, inputHost.data(), ipts );
+
+    RESAMPLEProblem rp ( problemArgs ( &dY, &dX, &dsym ), sizes, "resample" );
+    rp.transform();
+    toHost ( outputHost.data(), dY, opts );
+
+    double err = relError ( outputHost.data(), refHost.data(), opts );
+    bool ok = err <= TOLERANCE;
+    printf ( "[ %d, %d, %d ] -> [ %d, %d, %d ], shift [ %d, %d, %d ] / %d (%s):\trelative error = %E (%s)\n",
+             r[3], r[4], r[5], r[0], r[1], r[2], r[6], r[7], r[8], r[9], label, err, ok ? "PASS" : "FAIL" );
+
+    deviceFree ( dX );
+    deviceFree ( dY );
+    deviceFree ( dsym );
+    return ok;
+}
+
+int main ( int argc, char* argv[] )
+{
+    int mm = 16, nn = 16, kk = 16;
+    char *prog = argv[0];
+    int baz = 0;
+
+    while ( argc > 1 && argv[1][0] == '-' ) {
+        switch ( argv[1][1] ) {
+        case 's':
+            argv++, argc--;
+            mm = atoi ( argv[1] );
+            while ( argv[1][baz] != 'x' ) baz++;
+            baz++ ;
+            nn = atoi ( & argv[1][baz] );
+            while ( argv[1][baz] != 'x' ) baz++;
+            baz++ ;
+            kk = atoi ( & argv[1][baz] );
+            break;
+        case 'h':
+            printf ( "Usage: %s: [ -s MMxNNxKK ] [ -h (print help message) ]\n", argv[0] );
+            exit (0);
+        default:
+            printf ( "%s: unknown argument: %s ... ignored\n", prog, argv[1] );
+        }
+        argv++, argc--;
+    }
+    std::cout << mm << " " << nn << " " << kk << std::endl;
+    srand ( time ( NULL ) );
+
+    bool passed = true;
+    passed &= check ( { mm, nn, kk }, "library" );
+    passed &= check ( { mm, nn, kk, mm/2, nn/2, kk/2, -1, -1, -1, 4 }, "cell centered" );
+    passed &= check ( { mm, nn, kk, 3*mm/4, 3*nn/4, 3*kk/4, 1, 0, -1, 3 }, "ratio 4/3" );
+
+    printf ( "%s: All done, exiting\n", prog );
+    return passed ? 0 : 1;
+}
@@ -3,28 +3,24 @@ static std::string batch1ddft_script = "transform := let(\n\
          TFCall(TRC(TTensorI(DFT(N, sign), B, write, read)),\n\
             rec(fname := name, params := [])));";
 
+// explicit strides, see batchLayoutSizes().
+static std::string batch1ddft_strided_script = "transform := let(\n\
+         TFCall(TRC(TCompose([TScat(wfun), TTensorI(DFT(N, sign), B, write, read), TGath(rfun)])),\n\
+            rec(fname := name, params := [])));";
+
+// sizes: {N, B, read, write}, 0 for packed (APar) and 1 for interleaved (AVec)
+// arrays, or with explicit strides as from batchLayoutSizes().
 class BATCH1DDFTProblem: public FFTXProblem {
 public:
     using FFTXProblem::FFTXProblem;
     void randomProblemInstance() {
     }
     void semantics() {
-        std::cout << "N := " << sizes.at(0) << ";" << std::endl;
-        std::cout << "B := " << sizes.at(1) << ";" << std::endl;
-        if(sizes.at(2) == 0) {
-            std::cout << "read := APar;" << std::endl;
-        }
-        else{
-            std::cout << "read := AVec;" << std::endl;
-        }
-        if(sizes.at(3) == 0) {
-            std::cout << "write := APar;" << std::endl;
-        }
-        else{
-            std::cout << "write := AVec;" << std::endl;
-        }
-        std::cout << "sign := -1;" << std::endl;
-        std::cout << "name := \""<< name << "_spiral" << "\";" << std::endl;
-        std::cout << batch1ddft_script << std::endl;
+        fftx::script() << "N := " << sizes.at(0) << ";" << std::endl;
+        fftx::script() << "B := " << sizes.at(1) << ";" << std::endl;
+        bool strided = printBatchLayout(sizes);
+        fftx::script() << "sign := -1;" << std::endl;
+        fftx::script() << "name := \""<< name << "_spiral" << "\";" << std::endl;
+        fftx::script() << (strided ? batch1ddft_strided_script : batch1ddft_script) << std::endl;
     }
 };
@@ -21,29 +21,33 @@ public:
     void randomProblemInstance() {
     }
     void semantics() {
-        std::cout << "Import(realdft);" << std::endl;
-        std::cout << "N := " << sizes.at(0) << ";" << std::endl;
-        std::cout << "B := " << sizes.at(1) << ";" << std::endl;
-        std::cout << "b := " << sizes.at(2) << ";" << std::endl;
+        fftx::script() << "Import(realdft);" << std::endl;
+        fftx::script() << "N := " << sizes.at(0) << ";" << std::endl;
+        fftx::script() << "B := " << sizes.at(1) << ";" << std::endl;
+        fftx::script() << "b := " << sizes.at(2) << ";" << std::endl;
         if(sizes.at(3) == 0) {
-            std::cout << "read := APar;" << std::endl;
+            fftx::script() << "read := APar;" << std::endl;
         }
         else{
-            std::cout << "read := AVec;" << std::endl;
+            fftx::script() << "read := AVec;" << std::endl;
         }
         if(sizes.at(4) == 0) {
-            std::cout << "write := APar;" << std::endl;
+            fftx::script() << "write := APar;" << std::endl;
         }
         else{
-            std::cout << "write := AVec;" << std::endl;
+            fftx::script() << "write := AVec;" << std::endl;
         }
-        std::cout << "sign := -1;" << std::endl;
-        std::cout << "name := \""<< name << "_spiral" << "\";" << std::endl;
+        fftx::script() << "sign := -1;" << std::endl;
+        fftx::script() << "name := \""<< name << "_spiral" << "\";" << std::endl;
         if(sizes.at(3) == 0 && sizes.at(4) == 0)
-            std::cout << batch2dprdft_script_0x0 << std::endl;
+            fftx::script() << batch2dprdft_script_0x0 << std::endl;
         else if(sizes.at(3) == 0 && sizes.at(4) == 1)
-            std::cout << batch2dprdft_script_0x1 << std::endl;
+            fftx::script() << batch2dprdft_script_0x1 << std::endl;
         else if(sizes.at(3) == 1 && sizes.at(4) == 0)
-            std::cout << batch2dprdft_script_1x0 << std::endl;
+            fftx::script() << batch2dprdft_script_1x0 << std::endl;
+        else {
+            std::cout << "batch2dprdft: read and write can not both be strided" << std::endl;
+            exit(-1);
+        }
     }
 };
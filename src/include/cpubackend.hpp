@@ -20,6 +20,7 @@
   #define pclose _pclose
 
   #include <direct.h>
+  #include <process.h>   // _getpid
   #define getcwd _getcwd
   #define chdir _chdir
 #else
@@ -45,6 +46,8 @@
 #include <stdlib.h>
 #include <cstring>
 #include <chrono>
+#include <atomic>
+#include <cerrno>
 #include <regex>
 #pragma once
 
@@ -90,26 +93,64 @@ endif ()
 int redirect_input(int);
 void restore_input(int);
 
+/** \internal
+    Removes a build directory of Executor::execute() once the last executor
+    sharing it is gone.
+*/
+struct removeBuildDir {
+    void operator()(std::string *dir) const {
+        #if defined (_WIN32) || defined (_WIN64)
+            std::string cmd = "rmdir /s /q \"" + *dir + "\"";
+        #else
+            std::string cmd = "rm -rf \"" + *dir + "\"";
+        #endif
+        int systemret = system(cmd.c_str());
+        (void) systemret;
+        delete dir;
+    }
+};
+
 class Executor {
     private:
         void * shared_lib;
         float CPUTime;
+        void (*init_fn) () = nullptr;
+        void (*run_fn) (double *, double *, double *) = nullptr;
+        void (*destroy_fn) () = nullptr;
+        // own directory under temp/ for each build, shared by copies.
+        std::shared_ptr<std::string> build_dir;
+        std::string kept_lib;
+        std::string builtLib();
     public:
         float initAndLaunch(std::vector<void*>& args, std::string name);
+        void load(std::string name);
+        float run(std::vector<void*>& args);
+        void unload();
+        void clean();
         void execute(std::string file_name);
         float getKernelTime();
         //void returnData(std::vector<fftx::array_t<3,std::complex<double>>> &out1);
 };
 
+/** \internal */
+std::string Executor::builtLib() {
+    std::string dir = build_dir ? *build_dir : std::string("temp");
+    #if defined (_WIN32) || defined (_WIN64)
+        return dir + "/Release/tmp.dll";
+    #elif defined(__APPLE__)
+        return dir + "/libtmp.dylib";
+    #else
+        return dir + "/libtmp.so";
+    #endif
+}
+
 float Executor::initAndLaunch(std::vector<void*>& args, std::string name) {
     if ( DEBUGOUT) std::cout << "Loading shared library\n";
 
     #if defined (_WIN32) || defined (_WIN64)
-        shared_lib = (void *)LoadLibrary("temp/Release/tmp.dll");
-    #elif defined(__APPLE__)
-        shared_lib = dlopen("temp/libtmp.dylib", RTLD_LAZY);
+        shared_lib = (void *)LoadLibrary(builtLib().c_str());
     #else
-        shared_lib = dlopen("temp/libtmp.so", RTLD_LAZY); 
+        shared_lib = dlopen(builtLib().c_str(), RTLD_LAZY); 
     #endif
 
     if(!shared_lib) {
@@ -176,38 +217,141 @@ float Executor::initAndLaunch(std::vector<void*>& args, std::string name) {
 }
 
 
-void Executor::execute(std::string result) {
-    if ( DEBUGOUT) std::cout << "entered CPU backend execute\n";
-    std::string compile;
-    
-    char buff[FILENAME_MAX]; //create string buffer to hold path
-    char* getcwdret = getcwd( buff, FILENAME_MAX );
-    std::string current_working_dir(buff);
+/** \internal
+    Keeps the library built by the last execute() loaded and initialized, for
+    repeated run() calls until unload(). The library is loaded from a private
+    copy, so executors copied from one build each get their own instance, with
+    its own static temporaries. unload() removes the copy.
+*/
+void Executor::load(std::string name) {
+    std::string lib = builtLib();
+    #if defined (_WIN32) || defined (_WIN64)
+        static std::atomic<int> loaded(0);
+        std::string kept = "temp/libtmp_plan" + std::to_string(_getpid()) + "_" +
+                           std::to_string(loaded++) + ".dll";
+    #else
+        std::string ext = lib.substr(lib.rfind('.'));
+        std::string kept = "temp/libtmp_planXXXXXX" + ext;
+        int fd = mkstemps(&kept[0], (int) ext.size());
+        if(fd < 0) {
+            std::cout << "Cannot create a name for library " << lib << std::endl;
+            exit(-1);
+        }
+        close(fd);
+    #endif
+    std::ifstream src(lib, std::ios::binary);
+    std::ofstream dst(kept, std::ios::binary | std::ios::trunc);
+    if(!src || !(dst << src.rdbuf())) {
+        std::cout << "Cannot keep library " << lib << std::endl;
+        exit(-1);
+    }
+    dst.close();
+    kept_lib = kept;
 
-    struct stat sb;
+    #if defined (_WIN32) || defined (_WIN64)
+        shared_lib = (void *)LoadLibrary(kept.c_str());
+    #else
+        shared_lib = dlopen(kept.c_str(), RTLD_NOW);
+    #endif
+    if(!shared_lib) {
+        std::cout << "Cannot open library: " << kept << std::endl;
+        exit(-1);
+    }
 
-    int systemret;
-    if(stat((current_working_dir+"/temp").c_str(), &sb) == 0)
-        systemret = system("rm -rf temp");
-        
-    if ( DEBUGOUT) {
-        std::cout << "created compile\n";
+    std::string init = "init_" + name + "_spiral";
+    std::string transform = name + "_spiral";
+    std::string destroy = "destroy_" + name + "_spiral";
+    #if defined (_WIN32) || defined (_WIN64)
+        init_fn = (void (*)()) GetProcAddress ( (HMODULE) shared_lib, init.c_str() );
+        run_fn = (void (*)(double *, double *, double *)) GetProcAddress ( (HMODULE) shared_lib, transform.c_str() );
+        destroy_fn = (void (*)()) GetProcAddress ( (HMODULE) shared_lib, destroy.c_str() );
+    #else
+        init_fn = (void (*)())dlsym(shared_lib, init.c_str());
+        run_fn = (void (*)(double *, double *, double *))dlsym(shared_lib, transform.c_str());
+        destroy_fn = (void (*)())dlsym(shared_lib, destroy.c_str());
+    #endif
+    if(!init_fn || !run_fn || !destroy_fn) {
+        std::cout << "Cannot find " << transform << " in " << kept << std::endl;
+        exit(-1);
     }
+    init_fn();
+}
 
-    std::string result2 = result.substr(result.find("#include"));
+/** \internal
+    Runs the transform loaded by load() once.
+*/
+float Executor::run(std::vector<void*>& args) {
+    auto start = std::chrono::high_resolution_clock::now();
+    run_fn((double*)args.at(0), (double*)args.at(1), (double*)args.at(2));
+    auto stop = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<float, std::milli> duration = stop - start;
+    CPUTime = duration.count();
+    return getKernelTime();
+}
+
+/** \internal */
+void Executor::unload() {
+    if(destroy_fn)
+        destroy_fn();
+    #if defined (_WIN32) || defined (_WIN64)
+        FreeLibrary ( (HMODULE) shared_lib );
+    #else
+        dlclose(shared_lib);
+    #endif
+    if(!kept_lib.empty())
+        std::remove(kept_lib.c_str());
+    kept_lib.clear();
+    init_fn = nullptr;
+    run_fn = nullptr;
+    destroy_fn = nullptr;
+}
+
+/** \internal
+    Drops this executor's share of its build directory; the directory is removed
+    with the last share. Loaded copies are not affected.
+*/
+void Executor::clean() {
+    build_dir.reset();
+}
+
+
+void Executor::execute(std::string result) {
+    if ( DEBUGOUT) std::cout << "entered CPU backend execute\n";
+
+    // each build gets its own directory under temp/, so threads and processes
+    // sharing the working directory can build at once.
     #if defined (_WIN32) || defined (_WIN64)
         int check = _mkdir("temp");
     #else
         int check = mkdir("temp", 0777);
     #endif
-    if(check != 0) {
+    if(check != 0 && errno != EEXIST) {
         std::cout << "failed to create temp directory for runtime code\n";
         exit(-1);
     }
-    std::ofstream out("temp/spiral_generated.c");
+    #if defined (_WIN32) || defined (_WIN64)
+        static std::atomic<int> built(0);
+        std::string dir = "temp/build" + std::to_string(_getpid()) + "_" + std::to_string(built++);
+        bool made = (_mkdir(dir.c_str()) == 0);
+    #else
+        std::string dir = "temp/buildXXXXXX";
+        bool made = (mkdtemp(&dir[0]) != nullptr);
+    #endif
+    if(!made) {
+        std::cout << "failed to create a build directory for runtime code\n";
+        exit(-1);
+    }
+    build_dir.reset(new std::string(dir), removeBuildDir());
+
+    if ( DEBUGOUT) {
+        std::cout << "created compile\n";
+    }
+
+    std::string result2 = result.substr(result.find("#include"));
+    std::ofstream out(dir + "/spiral_generated.c");
     out << result2;
     out.close();
-    std::ofstream cmakelists("temp/CMakeLists.txt");
+    std::ofstream cmakelists(dir + "/CMakeLists.txt");
     if(DEBUGOUT)
         cmakelists << "set ( _addl_options -Wall )" << std::endl;       //  -Wextra
 
@@ -215,33 +359,23 @@ void Executor::execute(std::string result) {
     cmakelists.close();
     if ( DEBUGOUT )
         std::cout << "compiling\n";
-    
-    check = chdir("temp");
-    if(check != 0) {
-        std::cout << "failed to change to temp directory for runtime code\n";
-        exit(-1);
-    }
 
+    // the shell changes directory, not the process, which other threads share.
+    int systemret;
     #if defined(_WIN32) || defined (_WIN64)
-        systemret = system("cmake . && cmake --build . --config Release");      //  --target install
+        systemret = system(("cd /d \"" + dir + "\" && cmake . && cmake --build . --config Release").c_str());      //  --target install
     #elif defined(__APPLE__)
         struct utsname unameData;
         uname(&unameData);
         std::string machine_name(unameData.machine);
         if(machine_name == "arm64")
-            systemret = system("cmake -DCMAKE_APPLE_SILICON_PROCESSOR=arm64 . && make");
+            systemret = system(("cd \"" + dir + "\" && cmake -DCMAKE_APPLE_SILICON_PROCESSOR=arm64 . && make").c_str());
         else
-            systemret = system("cmake . && make");
+            systemret = system(("cd \"" + dir + "\" && cmake . && make").c_str());
     #else
-        systemret = system("cmake . && make"); 
+        systemret = system(("cd \"" + dir + "\" && cmake . && make").c_str()); 
     #endif
-
-    check = chdir(current_working_dir.c_str());
-    if(check != 0) {
-        std::cout << "failed to change to working directory for runtime code\n";
-        exit(-1);
-    }
-    // systemret = system("cd ..;");
+    (void) systemret;
     if ( DEBUGOUT )
         std::cout << "finished compiling\n";
 }
@@ -10,21 +10,50 @@ static std::string dftbat_script = "ns := szns;\n\
                  rec ( fname := name, params := [] ) )\n\
     );";
 
+// a BatchLayout given after the usual sizes, see DFTBATProblem.
+static std::string dftbat_layout_script = "ns := szns;\n\
+    name := transform_spiral;\n\
+    t := let(\n\
+        name := name,\n\
+        TFCall ( TRC ( TCompose ( [ TScat ( wfun ), TTensorI ( DFT ( ns[1], sign ), nbatch, write, read ), TGath ( rfun ) ] ) ),\n\
+                 rec ( fname := name, params := [] ) )\n\
+    );";
 
+// sizes: {n, nbatch, stridetype, sign, dir}, or with
+// {istride, idist, ostride, odist} after them as in BatchLayout, which
+// replace stridetype.
 class DFTBATProblem: public FFTXProblem {
 public:
     using FFTXProblem::FFTXProblem;
     void randomProblemInstance() {
     }
     void semantics() {
-        std::cout << "szns := [" << sizes.at(0) << "];" << std::endl;
-        std::cout << "nbatch := " << sizes.at(1) << ";" << std::endl;
-        std::cout << "stridetype := " << sizes.at(2) << ";" << std::endl;
-        std::cout << "sign := " << sizes.at(3) << ";" << std::endl;
+        fftx::script() << "szns := [" << sizes.at(0) << "];" << std::endl;
+        fftx::script() << "nbatch := " << sizes.at(1) << ";" << std::endl;
+        fftx::script() << "stridetype := " << sizes.at(2) << ";" << std::endl;
+        fftx::script() << "sign := " << sizes.at(3) << ";" << std::endl;
          if(sizes.at(4) == -1)
-            std::cout << "prefix := \"fftx_dftbat_\";" << std::endl;
+            fftx::script() << "prefix := \"fftx_dftbat_\";" << std::endl;
         else
-            std::cout << "prefix := \"fftx_idftbat_\";" << std::endl;
-        std::cout << dftbat_script << std::endl;
+            fftx::script() << "prefix := \"fftx_idftbat_\";" << std::endl;
+        if(sizes.size() == 5) {
+            fftx::script() << dftbat_script << std::endl;
+            return;
+        }
+        BatchLayout layout;
+        layout.istride = sizes.at(5);
+        layout.idist = sizes.at(6);
+        layout.ostride = sizes.at(7);
+        layout.odist = sizes.at(8);
+        std::vector<int> ls = batchLayoutSizes(sizes.at(0), sizes.at(1), layout);
+        if(ls.empty()) {
+            std::cout << "dftbat: the arrays of a batch overlap" << std::endl;
+            exit(-1);
+        }
+        if(ls.size() == 4)
+            ls.insert(ls.end(), {1, sizes.at(0), 1, sizes.at(0)});
+        fftx::script() << "B := nbatch;" << std::endl;
+        printBatchLayout(sizes.at(0), sizes.at(0), &ls.at(2), true);
+        fftx::script() << dftbat_layout_script << std::endl;
     }
 };
@@ -29,6 +29,7 @@
 #include <cassert>
 #include <complex>
 #include <iomanip>
+#include <sstream>
 /**
    \mainpage Documentation for FFTX
 
@@ -50,13 +51,49 @@ namespace fftx
   /**
      Is this a FFTX codegen program, or is this application code using a generated transform.
   */
-  static bool tracing = false; // when creating a trace program user sets this to 'true'
+  static thread_local bool tracing = false; // when creating a trace program user sets this to 'true'
 
   /**
      Counter for generated variable names duringn FFTX codegen tracing.
      Not meant for FFTX users, but can be used when debugging codegen itself.
   */
-  static uint64_t ID=1; // variable naming counter
+  static thread_local uint64_t ID=1; // variable naming counter
+
+  /** \internal */
+  inline std::ostream*& scriptStream()
+  {
+    static thread_local std::ostream* stream = &std::cout;
+    return stream;
+  }
+
+  /**
+     Stream that tracing writes the SPIRAL script to: std::cout, unless a
+     ScriptBuilder is open on the calling thread.
+  */
+  inline std::ostream& script() { return *scriptStream(); }
+
+  /**
+     Collects the script traced on the calling thread while it is in scope,
+     so several threads can trace at once without touching std::cout.
+     Builders nest; the previous stream is restored on destruction.
+  */
+  class ScriptBuilder
+  {
+  public:
+    ScriptBuilder():m_prev(scriptStream()) { scriptStream() = &m_out; }
+    ~ScriptBuilder() { scriptStream() = m_prev; }
+    ScriptBuilder(const ScriptBuilder&) = delete;
+    ScriptBuilder& operator=(const ScriptBuilder&) = delete;
+
+    /** The stream that tracing writes to while this builder is open. */
+    std::ostream& stream() { return m_out; }
+    /** The script traced so far. */
+    std::string str() const { return m_out.str(); }
+
+  private:
+    std::ostringstream m_out;
+    std::ostream* m_prev;
+  };
   
   /** \internal */
   typedef int intrank_t; // just useful for self-documenting code.
@@ -247,7 +284,7 @@ namespace fftx
       if (tracing)
         {
           m_data = global_ptr<T>((T*)ID);
-          std::cout<<"var_"<<ID<<":= var(\"var_"<<ID<<"\", BoxND("<<a_box.extents()<<", TReal));\n";
+          script()<<"var_"<<ID<<":= var(\"var_"<<ID<<"\", BoxND("<<a_box.extents()<<", TReal));\n";
           ID++;
         }
       else
@@ -350,7 +387,7 @@ namespace fftx
   {
     box_t<DIM-1> b = array.m_domain.projectC();
     array_t<DIM-1, T> rtn(b);
-    std::cout<<"var_"<<(uint64_t)rtn.m_data.local()<<":=nth(var_"<<(uint64_t)array.m_data.local()<<","<<index<<");\n";
+    script()<<"var_"<<(uint64_t)rtn.m_data.local()<<":=nth(var_"<<(uint64_t)array.m_data.local()<<","<<index<<");\n";
     return rtn;
   }
 
@@ -358,13 +395,13 @@ namespace fftx
   template<int DIM, typename T>
   void copy(array_t<DIM, T>& dest, const array_t<DIM, T>& src)
   {
-    std::cout<<"    TDAGNode(TGath(fBox("<<src.m_domain.extents()<<")),var_"<<dest.id()<<", var_"<<src.id()<<"),\n";
+    script()<<"    TDAGNode(TGath(fBox("<<src.m_domain.extents()<<")),var_"<<dest.id()<<", var_"<<src.id()<<"),\n";
   }
 
   /** \internal */
   inline void rawScript(const std::string& a_rawScript)
   {
-    std::cout<<"\n"<<a_rawScript<<"\n";
+    script()<<"\n"<<a_rawScript<<"\n";
   }
 
   /** \internal */
@@ -415,7 +452,7 @@ namespace fftx
              array_t<DIM, std::complex<double>>& destination,
              array_t<DIM, std::complex<double>>& source)
   {
-    std::cout<<"   TDAGNode(TTensorI(MDDFT("<<extents<<",-1),"<<batch<<",APar, APar), var_"<<destination.id()<<",var_"<<source.id()<<"),\n";
+    script()<<"   TDAGNode(TTensorI(MDDFT("<<extents<<",-1),"<<batch<<",APar, APar), var_"<<destination.id()<<",var_"<<source.id()<<"),\n";
   }
   
   /** \internal */
@@ -424,16 +461,48 @@ namespace fftx
              array_t<DIM, std::complex<double>>& destination,
              array_t<DIM, std::complex<double>>& source)
   {
-    std::cout<<"   TDAGNode(TTensorI(MDDFT("<<extents<<",1),"<<batch<<",APar, APar), var_"<<destination.id()<<",var_"<<source.id()<<"),\n";
+    script()<<"   TDAGNode(TTensorI(MDDFT("<<extents<<",1),"<<batch<<",APar, APar), var_"<<destination.id()<<",var_"<<source.id()<<"),\n";
   }
     
+  /** \internal
+      DFT of size extents with sign, whose input is nonzero only on the box of
+      source and whose output is kept only on the box of destination, both
+      inside [0, extents). Traced as one node, so the zero embedding and the
+      extraction are fused into the first and last stages of the DFT.
+  */
+  template<int DIM>
+  void prunedMDDFT(const point_t<DIM>& extents, int sign,
+                   array_t<DIM, std::complex<double>>& destination,
+                   const array_t<DIM, std::complex<double>>& source)
+  {
+    bool pruneIn  = !(source.m_domain.extents() == extents);
+    bool pruneOut = !(destination.m_domain.extents() == extents);
+    script()<<"    TDAGNode(TCompose([";
+    if(pruneOut)
+      {
+        script()<<"ExtractBox("<<extents<<",[";
+        for(int i=0; i<DIM; i++)
+          script()<<(i ? "," : "")<<"["<<destination.m_domain.lo[i]<<".."<<destination.m_domain.hi[i]<<"]";
+        script()<<"]), ";
+      }
+    script()<<"TTensorI(MDDFT("<<extents<<","<<sign<<"),1,APar, APar)";
+    if(pruneIn)
+      {
+        script()<<", ZeroEmbedBox("<<extents<<",[";
+        for(int i=0; i<DIM; i++)
+          script()<<(i ? "," : "")<<"["<<source.m_domain.lo[i]<<".."<<source.m_domain.hi[i]<<"]";
+        script()<<"])";
+      }
+    script()<<"]), var_"<<destination.id()<<",var_"<<source.id()<<"),\n";
+  }
+
   /** \internal */
   template<int DIM>
   void MDPRDFT(const point_t<DIM>& extent, int batch,
                array_t<DIM+1, double>& destination,
                array_t<DIM+1, double>& source)
   {
-    std::cout<<"    TDAGNode(TTensorI(MDPRDFT("<<extent<<",-1),"<<batch<<",APar,APar), var_"<<destination.id()<<",var_"<<source.id()<<"),\n";
+    script()<<"    TDAGNode(TTensorI(MDPRDFT("<<extent<<",-1),"<<batch<<",APar,APar), var_"<<destination.id()<<",var_"<<source.id()<<"),\n";
   }
 
   /** \internal */
@@ -442,7 +511,7 @@ namespace fftx
                array_t<DIM+1, double>& destination,
                array_t<DIM+1, double>& source)
   {
-    std::cout<<"    TDAGNode(TTensorI(IMDPRDFT("<<extent<<",1),"<<batch<<",APar,APar), var_"<<destination.id()<<",var_"<<source.id()<<"),\n";
+    script()<<"    TDAGNode(TTensorI(IMDPRDFT("<<extent<<",1),"<<batch<<",APar,APar), var_"<<destination.id()<<",var_"<<source.id()<<"),\n";
   }
 
   /** \internal */
@@ -451,7 +520,7 @@ namespace fftx
              array_t<DIM, std::complex<double>>& destination,
              array_t<DIM, double>& source)
   {
-    std::cout<<"    TDAGNode(MDPRDFT("<<extent<<",-1), var_"<<destination.id()<<",var_"<<source.id()<<"),\n"; // FIXME: was 1, not -1.
+    script()<<"    TDAGNode(MDPRDFT("<<extent<<",-1), var_"<<destination.id()<<",var_"<<source.id()<<"),\n"; // FIXME: was 1, not -1.
   }
 
   /** \internal */
@@ -460,7 +529,54 @@ namespace fftx
               array_t<DIM, double>& destination,
               array_t<DIM, std::complex<double>>& source)
   {
-    std::cout<<"    TDAGNode(IMDPRDFT("<<extent<<",1), var_"<<destination.id()<<",var_"<<source.id()<<"),\n"; // FIXME: was -1, not 1.
+    script()<<"    TDAGNode(IMDPRDFT("<<extent<<",1), var_"<<destination.id()<<",var_"<<source.id()<<"),\n"; // FIXME: was -1, not 1.
+  }
+
+  /** \internal
+      count inverse transforms of size extent, stored one after another in
+      source and in destination. */
+  template<int DIM>
+  void IPRDFT(const point_t<DIM>& extent, int count,
+              array_t<DIM, double>& destination,
+              array_t<DIM, std::complex<double>>& source)
+  {
+    script()<<"    TDAGNode(TTensorI(IMDPRDFT("<<extent<<",1),"<<count<<",APar,APar), var_"<<destination.id()<<",var_"<<source.id()<<"),\n";
+  }
+
+  /** Kinds of real-to-real transform along one dimension, unnormalized as
+      the SPIRAL transforms of the same names. */
+  enum r2r_t { DCT1 = 1, DCT2, DCT3, DST1, DST2, DST3 };
+
+  /** \internal */
+  inline const char* r2rName(r2r_t kind)
+  {
+    static const char* names[] = {"DCT1", "DCT2", "DCT3", "DST1", "DST2", "DST3"};
+    if(kind < DCT1 || kind > DST3)
+      {
+        std::cout<<"R2R: unknown transform kind "<<(int)kind<<std::endl;
+        exit(-1);
+      }
+    return names[kind - DCT1];
+  }
+
+  /** Real-to-real transform of source into destination, with kinds[d] along
+      dimension d, and dimension DIM-1 fastest. */
+  template<int DIM>
+  void R2R(const std::array<r2r_t, DIM>& kinds,
+           array_t<DIM, double>& destination,
+           const array_t<DIM, double>& source)
+  {
+    point_t<DIM> n = source.m_domain.extents();
+    script()<<"    TDAGNode(TCompose([";
+    for(int d=0; d<DIM; d++)
+      {
+        int before = 1, after = 1;
+        for(int e=0; e<d; e++) before *= n[e];
+        for(int e=d+1; e<DIM; e++) after *= n[e];
+        script()<<(d ? ", " : "")<<"TTensorI(TTensorI("<<r2rName(kinds[d])<<"("<<n[d]<<"), "
+                <<after<<", AVec, AVec), "<<before<<", APar, APar)";
+      }
+    script()<<"]), var_"<<destination.id()<<",var_"<<source.id()<<"),\n";
   }
 
   /** \internal */
@@ -469,7 +585,24 @@ namespace fftx
               array_t<DIM, std::complex<double>>& destination,
               const array_t<DIM, std::complex<double>>& source)
   {
-    std::cout<<"    TDAGNode(Diag(diagTensor(FDataOfs(symvar,"<<symbol.m_domain.size()<<",0),fConst(TReal, 2, 1))), var_"<<destination.id()<<",var_"<<source.id()<<"),\n";
+    script()<<"    TDAGNode(Diag(diagTensor(FDataOfs(symvar,"<<symbol.m_domain.size()<<",0),fConst(TReal, 2, 1))), var_"<<destination.id()<<",var_"<<source.id()<<"),\n";
+  }
+
+  /** \internal
+      Applies count real symbols, stored one after another in the symbol
+      argument, to the same source, and writes the count products one after
+      another in destination. symbol has the size of one symbol. */
+  template<int DIM>
+  void kernels(int count,
+               const array_t<DIM, double>& symbol,
+               array_t<DIM, std::complex<double>>& destination,
+               const array_t<DIM, std::complex<double>>& source)
+  {
+    size_t n = symbol.m_domain.size();
+    script()<<"    TDAGNode(VStack(";
+    for(int s=0; s<count; s++)
+      script()<<(s ? ", " : "")<<"Diag(diagTensor(FDataOfs(symvar,"<<n<<","<<s*n<<"),fConst(TReal, 2, 1)))";
+    script()<<"), var_"<<destination.id()<<",var_"<<source.id()<<"),\n";
   }
 
   /** \internal */
@@ -478,49 +611,289 @@ namespace fftx
               array_t<DIM, std::complex<double>>& destination,
               const array_t<DIM, std::complex<double>>& source)
   {
-    std::cout<<"    TDAGNode(RCDiag(FDataOfs(symvar,"<<2*symbol.m_domain.size()<<",0)), var_"<<destination.id()<<",var_"<<source.id()<<"),\n";
+    script()<<"    TDAGNode(RCDiag(FDataOfs(symvar,"<<2*symbol.m_domain.size()<<",0)), var_"<<destination.id()<<",var_"<<source.id()<<"),\n";
+  }
+
+  /** Applies the complex symbol f_0(i_0) * ... * f_{DIM-1}(i_{DIM-1}) to
+      source, computing it in the generated kernel instead of reading a
+      full-size symbol array. The symbol argument holds only the factors:
+      the extent of source in dimension 0 complex values of f_0, then those
+      of f_1, and so on. factors has that total size. */
+  template<int DIM>
+  void separableKernel(const array_t<1, std::complex<double>>& factors,
+                       array_t<DIM, std::complex<double>>& destination,
+                       const array_t<DIM, std::complex<double>>& source)
+  {
+    point_t<DIM> ext = source.m_domain.extents();
+    std::size_t total = 0;
+    for(int d=0; d<DIM; d++) total += ext[d];
+    if(factors.m_domain.size() != total)
+      {
+        std::cout<<"separableKernel: factors must have "<<total<<" elements"<<std::endl;
+        exit(-1);
+      }
+    // i runs over interleaved real and imaginary parts, j over elements.
+    std::string j = "idiv(i, 2)";
+    std::string re, im;
+    std::size_t stride = 1, offset = total;
+    for(int d=DIM-1; d>=0; d--)
+      {
+        offset -= ext[d];
+        std::string k = (stride == 1) ? j : "idiv("+j+", "+std::to_string(stride)+")";
+        if(d > 0)
+          k = "imod("+k+", "+std::to_string(ext[d])+")";
+        std::string at = std::to_string(2*offset)+" + 2*"+k;
+        std::string fr = "nth(symvar, "+at+")", fi = "nth(symvar, "+at+" + 1)";
+        if(d == DIM-1)
+          {
+            re = fr;
+            im = fi;
+          }
+        else
+          {
+            std::string re1 = "("+re+"*"+fr+" - "+im+"*"+fi+")";
+            im = "("+re+"*"+fi+" + "+im+"*"+fr+")";
+            re = re1;
+          }
+        stride *= ext[d];
+      }
+    script()<<"    TDAGNode(RCDiag((i -> Lambda(i, cond(eq(imod(i, 2), 0), "<<re<<", "<<im
+            <<")).setRange(TReal))(Ind("<<2*source.m_domain.size()<<"))), var_"<<destination.id()<<",var_"<<source.id()<<"),\n";
+  }
+
+  /** Real-valued expression of the position in an array, for pointwise
+      operations that are traced into the generated code, where
+      <tt>forall</tt> can not be. Built from constants, index(), frequency(),
+      sqrt() and the arithmetic operators, for instance
+      <tt>frequency(0, n)*frequency(0, n) + frequency(1, n)*frequency(1, n)</tt>.
+  */
+  struct expr_t
+  {
+    /** \internal SPIRAL text, with $d for the 0-based index in dimension d. */
+    std::string m_spiral;
+
+    expr_t(double a_value)
+    {
+      std::ostringstream os;
+      os<<std::setprecision(17)<<a_value;
+      m_spiral = os.str();
+    }
+
+    /** \internal */
+    explicit expr_t(const std::string& a_spiral) : m_spiral(a_spiral) { }
+  };
+
+  /** \relates fftx::expr_t
+      The 0-based index in dimension d of the array the expression is applied to. */
+  inline expr_t index(int d)
+  {
+    return expr_t("$"+std::to_string(d));
+  }
+
+  /** \relates fftx::expr_t
+      The signed frequency in dimension d of a DFT of length n:
+      the index if at most n/2, else the index minus n.
+      In the truncated dimension of a real transform the index is always at most n/2. */
+  inline expr_t frequency(int d, int n)
+  {
+    std::string i = "$"+std::to_string(d);
+    return expr_t("cond(leq("+i+", "+std::to_string(n/2)+"), "+i+", "+i+" - "+std::to_string(n)+")");
+  }
+
+  /** \relates fftx::expr_t */
+  inline expr_t operator+(const expr_t& a, const expr_t& b) { return expr_t("("+a.m_spiral+" + "+b.m_spiral+")"); }
+  /** \relates fftx::expr_t */
+  inline expr_t operator-(const expr_t& a, const expr_t& b) { return expr_t("("+a.m_spiral+" - "+b.m_spiral+")"); }
+  /** \relates fftx::expr_t */
+  inline expr_t operator*(const expr_t& a, const expr_t& b) { return expr_t("("+a.m_spiral+" * "+b.m_spiral+")"); }
+  /** \relates fftx::expr_t */
+  inline expr_t operator/(const expr_t& a, const expr_t& b) { return expr_t("("+a.m_spiral+" / "+b.m_spiral+")"); }
+  /** \relates fftx::expr_t */
+  inline expr_t operator-(const expr_t& a) { return expr_t("(-"+a.m_spiral+")"); }
+  /** \relates fftx::expr_t */
+  inline expr_t sqrt(const expr_t& a) { return expr_t("sqrt("+a.m_spiral+")"); }
+
+  /** Complex-valued expression of the position in an array, as a real and an
+      imaginary expr_t, for symbols such as <tt>i k</tt> of a derivative:
+      <tt>imaginary(frequency(2, n))</tt>. A real expr_t converts to one with
+      a zero imaginary part.
+  */
+  struct cexpr_t
+  {
+    expr_t m_re;
+    expr_t m_im;
+
+    cexpr_t(double a_re) : m_re(a_re), m_im(0.0) { }
+
+    cexpr_t(const expr_t& a_re, const expr_t& a_im = expr_t(0.0)) : m_re(a_re), m_im(a_im) { }
+  };
+
+  /** \relates fftx::cexpr_t
+      The purely imaginary expression <tt>i a</tt>. */
+  inline cexpr_t imaginary(const expr_t& a) { return cexpr_t(expr_t(0.0), a); }
+
+  /** \relates fftx::cexpr_t */
+  inline cexpr_t operator+(const cexpr_t& a, const cexpr_t& b) { return cexpr_t(a.m_re + b.m_re, a.m_im + b.m_im); }
+  /** \relates fftx::cexpr_t */
+  inline cexpr_t operator-(const cexpr_t& a, const cexpr_t& b) { return cexpr_t(a.m_re - b.m_re, a.m_im - b.m_im); }
+  /** \relates fftx::cexpr_t */
+  inline cexpr_t operator*(const cexpr_t& a, const cexpr_t& b)
+  {
+    return cexpr_t(a.m_re * b.m_re - a.m_im * b.m_im, a.m_re * b.m_im + a.m_im * b.m_re);
+  }
+  /** \relates fftx::cexpr_t */
+  inline cexpr_t conj(const cexpr_t& a) { return cexpr_t(a.m_re, -a.m_im); }
+
+  /** \internal
+      SPIRAL text of e with $d replaced by the index in dimension d of
+      element j of box, last dimension fastest. */
+  template<int DIM>
+  std::string pointwiseBody(const expr_t& e, const box_t<DIM>& box, const std::string& j)
+  {
+    point_t<DIM> ext = box.extents();
+    std::string body = e.m_spiral;
+    std::size_t stride = 1;
+    for(int d=DIM-1; d>=0; d--)
+      {
+        std::string idx = (stride == 1) ? j : "idiv("+j+", "+std::to_string(stride)+")";
+        if(d > 0)
+          idx = "imod("+idx+", "+std::to_string(ext[d])+")";
+        body = std::regex_replace(body, std::regex("\\$"+std::to_string(d)), idx);
+        stride *= ext[d];
+      }
+    return body;
+  }
+
+  /** \internal
+      SPIRAL diagonal function over the elements of box, from e with $d
+      replaced by the index in dimension d, last dimension fastest. */
+  template<int DIM>
+  std::string pointwiseLambda(const expr_t& e, const box_t<DIM>& box)
+  {
+    return "(i -> Lambda(i, "+pointwiseBody(e, box, "i")+").setRange(TReal))(Ind("+std::to_string(box.size())+"))";
+  }
+
+  /** \internal */
+  template<int DIM>
+  void pointwiseNode(const std::string& op, const array_t<DIM, double>& destination, const array_t<DIM, double>& source, const std::string& fun)
+  {
+    script()<<"    TDAGNode("<<op<<"("<<fun<<"), var_"<<destination.id()<<",var_"<<source.id()<<"),\n";
+  }
+
+  /** \internal
+      Complex arrays are interleaved, so a real diagonal repeats each entry. */
+  template<int DIM>
+  void pointwiseNode(const std::string& op, const array_t<DIM, std::complex<double>>& destination, const array_t<DIM, std::complex<double>>& source, const std::string& fun)
+  {
+    script()<<"    TDAGNode("<<op<<"(diagTensor("<<fun<<",fConst(TReal, 2, 1))), var_"<<destination.id()<<",var_"<<source.id()<<"),\n";
+  }
+
+  /** Traces <tt>destination = alpha * source</tt>. */
+  template<int DIM, typename T>
+  void scale(double alpha, array_t<DIM, T>& destination, const array_t<DIM, T>& source)
+  {
+    std::ostringstream os;
+    os<<"fConst(TReal, "<<source.m_domain.size()<<", "<<std::setprecision(17)<<alpha<<")";
+    pointwiseNode("Diag", destination, source, os.str());
+  }
+
+  /** Traces <tt>destination = f * source</tt> elementwise, with f a real
+      expression of the index, such as a Laplacian symbol built from frequency(). */
+  template<int DIM, typename T>
+  void multiply(const expr_t& f, array_t<DIM, T>& destination, const array_t<DIM, T>& source)
+  {
+    pointwiseNode("Diag", destination, source, pointwiseLambda(f, source.m_domain));
+  }
+
+  /** Traces the complex product <tt>destination = f * source</tt>
+      elementwise, with f a complex expression of the index, such as
+      <tt>imaginary(frequency(2, n))</tt> for a derivative. */
+  template<int DIM>
+  void multiply(const cexpr_t& f,
+                array_t<DIM, std::complex<double>>& destination,
+                const array_t<DIM, std::complex<double>>& source)
+  {
+    // i runs over interleaved real and imaginary parts, as in separableKernel.
+    std::string re = pointwiseBody(f.m_re, source.m_domain, "idiv(i, 2)");
+    std::string im = pointwiseBody(f.m_im, source.m_domain, "idiv(i, 2)");
+    script()<<"    TDAGNode(RCDiag((i -> Lambda(i, cond(eq(imod(i, 2), 0), "<<re<<", "<<im
+            <<")).setRange(TReal))(Ind("<<2*source.m_domain.size()<<"))), var_"<<destination.id()<<",var_"<<source.id()<<"),\n";
+  }
+
+  /** Traces <tt>destination = a * source</tt> elementwise, with a a real array
+      computed earlier in the same DAG. */
+  template<int DIM, typename T>
+  void multiply(const array_t<DIM, double>& a, array_t<DIM, T>& destination, const array_t<DIM, T>& source)
+  {
+    pointwiseNode("Diag", destination, source, "FDataOfs(var_"+std::to_string(a.id())+","+std::to_string(a.m_domain.size())+",0)");
+  }
+
+  /** Traces the complex product <tt>destination = a * source</tt> elementwise,
+      with a a complex array computed earlier in the same DAG. */
+  template<int DIM>
+  void multiply(const array_t<DIM, std::complex<double>>& a,
+                array_t<DIM, std::complex<double>>& destination,
+                const array_t<DIM, std::complex<double>>& source)
+  {
+    script()<<"    TDAGNode(RCDiag(FDataOfs(var_"<<a.id()<<","<<2*a.m_domain.size()<<",0)), var_"<<destination.id()<<",var_"<<source.id()<<"),\n";
+  }
+
+  /** Traces <tt>destination = conj(source)</tt>. */
+  template<int DIM>
+  void conjugate(array_t<DIM, std::complex<double>>& destination,
+                 const array_t<DIM, std::complex<double>>& source)
+  {
+    script()<<"    TDAGNode(Diag(diagTensor(fConst(TReal, "<<source.m_domain.size()<<", 1),FList(TReal, [1, -1]))), var_"<<destination.id()<<",var_"<<source.id()<<"),\n";
+  }
+
+  /** Traces <tt>destination = a + b</tt>, as one node reading both arrays. */
+  template<int DIM, typename T>
+  void add(array_t<DIM, T>& destination, const array_t<DIM, T>& a, const array_t<DIM, T>& b)
+  {
+    std::size_t n = a.m_domain.size() * sizeof(T) / sizeof(double);
+    script()<<"    TDAGNode(HStack(I("<<n<<"), I("<<n<<")), var_"<<destination.id()<<",[var_"<<a.id()<<", var_"<<b.id()<<"]),\n";
   }
 
   /** \internal */
   inline void include(const char* includeFile)
   {
-    std::cout<<"opts.includes:=opts.includes::["<<includeFile<<"];\n";
+    script()<<"opts.includes:=opts.includes::["<<includeFile<<"];\n";
   }
 
   /** \internal */
   template<int DIM, typename T>
   void zeroEmbedBox(array_t<DIM, T>& destination, const array_t<DIM, T>& source)
   {
-    std::cout<<"    TDAGNode(ZeroEmbedBox("<<destination.m_domain.extents()<<",[";
+    script()<<"    TDAGNode(ZeroEmbedBox("<<destination.m_domain.extents()<<",[";
     for(int i=0; i<DIM; i++)
       {
-        std::cout<<"["<<source.m_domain.lo[i]<<".."<<source.m_domain.hi[i]<<"]";
-        if(i<DIM-1) std::cout<<",";
+        script()<<"["<<source.m_domain.lo[i]<<".."<<source.m_domain.hi[i]<<"]";
+        if(i<DIM-1) script()<<",";
       }
-    std::cout<<"]), var_"<<destination.id()<<",var_"<<source.id()<<"),\n";
+    script()<<"]), var_"<<destination.id()<<",var_"<<source.id()<<"),\n";
   }
 
   /** \internal */
   template<int DIM, typename T>
   void extractBox(array_t<DIM, T>& destination, const array_t<DIM, T>& source)
   {
-    std::cout<<"    TDAGNode(ExtractBox("<<source.m_domain.extents()<<",[";
+    script()<<"    TDAGNode(ExtractBox("<<source.m_domain.extents()<<",[";
     for(int i=0; i<DIM; i++)
       {
-        std::cout<<"["<<destination.m_domain.lo[i]<<".."<<destination.m_domain.hi[i]<<"]";
-        if(i<DIM-1) std::cout<<",";
+        script()<<"["<<destination.m_domain.lo[i]<<".."<<destination.m_domain.hi[i]<<"]";
+        if(i<DIM-1) script()<<",";
       }
-    std::cout<<"]), var_"<<destination.id()<<",var_"<<source.id()<<"),\n";
+    script()<<"]), var_"<<destination.id()<<",var_"<<source.id()<<"),\n";
   }
   
   /** \internal */
-  static std::string inputType = "double";
+  static thread_local std::string inputType = "double";
   /** \internal */
-  static int inputCount = 1;
+  static thread_local int inputCount = 1;
   /** \internal */
-  static std::string outputType = "double";
+  static thread_local std::string outputType = "double";
   /** \internal */
-  static int outputCount = 1;
+  static thread_local int outputCount = 1;
 
   /** \internal */
   template<int DIM, typename T, std::size_t COUNT>
@@ -529,7 +902,7 @@ namespace fftx
     inputType = TypeName<T>::Get();
     for(int i=0; i<COUNT; i++)
       {
-        std::cout<<"var_"<<a_inputs[i].id()<<":= nth(X,"<<i<<");\n";
+        script()<<"var_"<<a_inputs[i].id()<<":= nth(X,"<<i<<");\n";
       }
   }
   /** \internal */
@@ -537,7 +910,7 @@ namespace fftx
   void setInputs(const array_t<DIM, T>& a_inputs)
   {
     inputType = TypeName<T>::Get();
-    std::cout<<"var_"<<a_inputs.id()<<":= X;\n";
+    script()<<"var_"<<a_inputs.id()<<":= X;\n";
   }
   
   /** \internal */
@@ -547,7 +920,7 @@ namespace fftx
     outputType = TypeName<T>::Get();
     for(int i=0; i<COUNT; i++)
       {
-        std::cout<<"var_"<<a_outputs[i].id()<<":= nth(Y,"<<i<<");\n";
+        script()<<"var_"<<a_outputs[i].id()<<":= nth(Y,"<<i<<");\n";
       }
   }
   /** \internal */
@@ -555,25 +928,33 @@ namespace fftx
   void setOutputs(const array_t<DIM, T>& a_outputs)
   {
     outputType = TypeName<T>::Get();
-    std::cout<<"var_"<<a_outputs.id()<<":= Y;\n";
+    script()<<"var_"<<a_outputs.id()<<":= Y;\n";
   }
 
   /** \internal */
   template<int DIM, typename T, std::size_t COUNT>
   void setSymbol(const  std::array<array_t<DIM, T>, COUNT>& a_symbol)
   {
-    std::cout<<"symvar := var(\"sym\", TPtr(TPtr(TReal)));\n";
+    script()<<"symvar := var(\"sym\", TPtr(TPtr(TReal)));\n";
   }
   
-  /** \internal */
+  /** Fourier interpolation of source onto the grid of destination, shifted
+      by shift source cells in each dimension. SPIRAL generates it as one
+      pruned kernel, without storing the padded spectrum.
+  */
   template<int DIM, typename T>
   void resample(const std::array<double, DIM>& shift,
                 array_t<DIM,T>& destination,
                 const array_t<DIM,T>& source)
   {
-    std::cout<<"    TDAGNode(TResample("
+    // the shift is printed in full, unlike other arrays.
+    std::ostringstream os;
+    os<<std::setprecision(17)<<"["<<shift[0];
+    for(int i=1; i<DIM; i++) os<<","<<shift[i];
+    os<<"]";
+    script()<<"    TDAGNode(TResample("
              <<destination.m_domain.extents()<<","
-             <<source.m_domain.extents()<<","<<shift<<"),"
+             <<source.m_domain.extents()<<","<<os.str()<<"),"
              <<"var_"<<destination.id()<<","
              <<"var_"<<source.id()<<"),\n";
   }
@@ -583,14 +964,14 @@ namespace fftx
   //  std::cout<<"conf := FFTXGlobals.defaultWarpXConf();\n";
   //  std::cout<<"opts := FFTXGlobals.getOpts(conf);\n";                                     
   //  std::cout<<"symvar := var(\"sym\", TPtr(TPtr(TReal)));\n";
-    std::cout<<"transform:= TFCall(TDecl(TDAG([\n";
+    script()<<"transform:= TFCall(TDecl(TDAG([\n";
   }
 
   /** \internal */
   inline void openScalarDAG()
   {
-    std::cout<<"symvar := var(\"sym\", TPtr(TReal));\n";
-    std::cout<<"transform:= TFCall(TDecl(TDAG([\n";
+    script()<<"symvar := var(\"sym\", TPtr(TReal));\n";
+    script()<<"transform:= TFCall(TDecl(TDAG([\n";
   }
   
  
@@ -672,18 +1053,18 @@ namespace fftx
    headerFile<<header_text<<"\n";
    headerFile.close();
    
-   std::cout<<"\n]),\n   [";
+   script()<<"\n]),\n   [";
    if(COUNT==0)
      {}
    else
      {
-      std::cout<<"var_"<<(uint64_t)localVars[0].m_data.local();
-      for(int i=1; i<COUNT; i++) std::cout<<", var_"<<(uint64_t)localVars[i].m_data.local();
+      script()<<"var_"<<(uint64_t)localVars[0].m_data.local();
+      for(int i=1; i<COUNT; i++) script()<<", var_"<<(uint64_t)localVars[i].m_data.local();
      }
-     std::cout<<"]\n),\n";
-     std::cout<<"rec(XType:= TPtr(TPtr(TReal)), YType:=TPtr(TPtr(TReal)), fname:=\""<<name<<"_spiral\", params:= [symvar])\n"
+     script()<<"]\n),\n";
+     script()<<"rec(XType:= TPtr(TPtr(TReal)), YType:=TPtr(TPtr(TReal)), fname:=\""<<name<<"_spiral\", params:= [symvar])\n"
               <<");\n";
-     std::cout<<"prefix:=\""<<name<<"\";\n";
+     script()<<"prefix:=\""<<name<<"\";\n";
   }
 
   /** \internal */
@@ -812,18 +1193,18 @@ template<int DIM>
    headerFile<<header_text<<"\n";
    headerFile.close();
 
-   std::cout<<"\n]),\n   [";
+   script()<<"\n]),\n   [";
     // if(COUNT==0){}
     // else
     //   {
     //     std::cout<<"var_"<<(uint64_t)localVars[0].m_data.local();
     //     for(int i=1; i<COUNT; i++) std::cout<<", var_"<<(uint64_t)localVars[i].m_data.local();
     //   }
-   std::cout <<localVarNames;
-   std::cout<<"]\n),\n";
-   std::cout<<"rec(fname:=\""<<name<<"_spiral\", params:= [symvar])\n"
+   script() <<localVarNames;
+   script()<<"]\n),\n";
+   script()<<"rec(fname:=\""<<name<<"_spiral\", params:= [symvar])\n"
             <<");\n";
-   std::cout<<"prefix:=\""<<name<<"\";\n";
+   script()<<"prefix:=\""<<name<<"\";\n";
 } 
  
  
@@ -844,6 +1225,102 @@ template<typename T, typename T2, int DIM, unsigned long COUNT, unsigned long CO
 
   }
 
+  /**
+     Traces a chain of operations, such as transforms, symbols, resample(),
+     zeroEmbedBox(), extractBox() and pointwise operations, into one DAG, so
+     that the whole chain is generated and compiled as a single function
+     with its intermediates allocated once.
+
+     Create the input, the output and each intermediate through the pipeline,
+     in any order, and apply the operations to them as usual; close() then
+     writes the DAG. Constructing a pipeline sets <tt>fftx::tracing</tt>,
+     and destroying it restores the previous value.
+  */
+  template<int DIM>
+  class pipeline_t
+  {
+  public:
+    pipeline_t():m_outer(scriptStream()), m_tracing(tracing)
+    {
+      tracing = true;
+      scriptStream() = &m_nodes;
+    }
+
+    // host code may use forall again once the pipeline is traced.
+    ~pipeline_t()
+    {
+      scriptStream() = m_outer;
+      tracing = m_tracing;
+    }
+    pipeline_t(const pipeline_t&) = delete;
+    pipeline_t& operator=(const pipeline_t&) = delete;
+
+    /** The input of the generated function. */
+    template<typename T>
+    array_t<DIM,T>& input(const box_t<DIM>& a_box) { return declare<T>(a_box, 0); }
+
+    /** The output of the generated function. */
+    template<typename T>
+    array_t<DIM,T>& output(const box_t<DIM>& a_box) { return declare<T>(a_box, 1); }
+
+    /** An intermediate, local to the generated function. */
+    template<typename T>
+    array_t<DIM,T>& temporary(const box_t<DIM>& a_box) { return declare<T>(a_box, 2); }
+
+    /** Writes the traced chain as the DAG of the function name. */
+    void close(const std::string& name)
+    {
+      if(!m_input || !m_output)
+        {
+          std::cout<<"pipeline_t: "<<name<<" needs one input and one output"<<std::endl;
+          exit(-1);
+        }
+      scriptStream() = m_outer;
+      openScalarDAG();
+      script()<<m_nodes.str();
+      closeScalarDAG<DIM>(m_temps, name.c_str());
+    }
+
+  private:
+    template<typename T>
+    array_t<DIM,T>& declare(const box_t<DIM>& a_box, int role)
+    {
+      if((role == 0 && m_input) || (role == 1 && m_output))
+        {
+          std::cout<<"pipeline_t: only one "<<(role == 0 ? "input" : "output")<<" is supported"<<std::endl;
+          exit(-1);
+        }
+      // declarations go ahead of the DAG, whenever they are made.
+      scriptStream() = m_outer;
+      std::shared_ptr<array_t<DIM,T>> a = std::make_shared<array_t<DIM,T>>(a_box);
+      if(role == 0)
+        {
+          setInputs(*a);
+          m_input = true;
+        }
+      else if(role == 1)
+        {
+          setOutputs(*a);
+          m_output = true;
+        }
+      else
+        {
+          m_temps += (m_temps.empty() ? "" : ",") + std::string("var_") + std::to_string(a->id());
+        }
+      scriptStream() = &m_nodes;
+      m_arrays.push_back(a);
+      return *a;
+    }
+
+    std::ostream* m_outer;
+    bool m_tracing;
+    std::ostringstream m_nodes;
+    std::vector<std::shared_ptr<void>> m_arrays;
+    std::string m_temps;
+    bool m_input = false;
+    bool m_output = false;
+  };
+
 /** \relates fftx::box_t
     Returns true if the given <tt>point_t</tt> is contained in the given <tt>box_t</tt>.
 */
@@ -1088,10 +1565,23 @@ template<typename T, typename T2, int DIM, unsigned long COUNT, unsigned long CO
  
   };
   
+  /** \internal
+      The body of a forall is C++, so it can not go into a trace; the message
+      goes to std::cerr because std::cout may be the script being traced. */
+  inline void forallNotTraced()
+  {
+    if(tracing)
+      {
+        std::cerr<<"forall can not be traced; use scale, multiply, conjugate or add"<<std::endl;
+        exit(-1);
+      }
+  }
+
   /** \internal */
   template<int DIM, typename T, typename Func>
   inline void forall(Func f, array_t<DIM, T>& array)
   {
+    forallNotTraced();
     int* lo=array.m_domain.lo.x;
     int* hi=array.m_domain.hi.x;
     point_t<DIM> p = array.m_domain.lo;
@@ -1103,6 +1593,7 @@ template<typename T, typename T2, int DIM, unsigned long COUNT, unsigned long CO
   template<int DIM, typename T1, typename T2, typename Func>
   inline void forall(Func f, array_t<DIM, T1>& array, const array_t<DIM, T2>& array2)
   {
+    forallNotTraced();
     int* lo=array.m_domain.lo.x;
     int* hi=array.m_domain.hi.x;
     point_t<DIM> p = array.m_domain.lo;
@@ -10,6 +10,12 @@
 #include "mddftlib.hpp"
 #include "mdprdftlib.hpp"
 #include "dftbatlib.hpp"
+#include "batch1ddftObj.hpp"
+#include "ibatch1ddftObj.hpp"
+#include "batch3ddftObj.hpp"
+#include "ibatch3ddftObj.hpp"
+#include "batch3dprdftObj.hpp"
+#include "ibatch3dprdftObj.hpp"
 // #include "cudabackend.hpp"
 #if defined FFTX_HIP
 #include "hipbackend.hpp"
@@ -26,6 +32,7 @@
 #include <sys/stat.h>
 #include <fcntl.h>
 #include <memory>
+#include <map>
 
 #if defined(_WIN32) || defined (_WIN64)
   #include <io.h>
@@ -53,6 +60,7 @@ namespace fftx_cuFFT {
 #define CUFFT_FORWARD -1
 #define CUFFT_INVERSE 1
 
+#if defined FFTX_HIP || defined FFTX_CUDA
 typedef struct {
     int x;
     int y;
@@ -60,6 +68,10 @@ typedef struct {
     int batch;
 
 } cufftHandle;
+#else
+// index of a plan made by cufftPlanMany, cufftPlan1d or cufftPlan3d.
+typedef int cufftHandle;
+#endif
 
 typedef enum cufftType_t {
     CUFFT_R2C = 0x2a,  // Real to complex (interleaved)
@@ -165,45 +177,392 @@ void mdprdft(int x, int y, int z, int sign, hipDeviceptr_t Y, hipDeviceptr_t X)
 }
 
 #else
-void mddft(int x, int y, int z, int sign, double * Y, double * X) {
-    if ( DEBUGOUT) std::cout << "Entered mddft fftx cpu api call" << std::endl;
-    std::complex<double> * dsym = new std::complex<double>[1];
-    // hipMalloc((void **)&dsym,  1* sizeof(std::complex<double>));
-    std::vector<void*> args{(void*)Y,(void*)X,(void*)dsym};
-    std::vector<int> sizes{x,y,z};
-    if(stored_mddft_jit.find(std::make_tuple(x,y,z,sign)) != stored_mddft_jit.end()) {
-        if ( DEBUGOUT) std::cout << "running cached instance" << std::endl;
-        Executor e;
-        e.execute(stored_mddft_jit.at(std::make_tuple(x,y,z,sign)));
+typedef std::complex<double> cufftDoubleComplex;
+typedef double cufftDoubleReal;
+typedef double cufftReal;
+
+/** \internal
+    One direction of a plan: a fixed-library transform, or code compiled once
+    at run time and kept loaded in its executor.
+*/
+struct fftxPlanKernel {
+    std::string name;
+    bool ready = false;
+    transformTuple_t *tupl = nullptr;
+    Executor exec;
+};
+
+/** \internal */
+struct fftxPlan {
+    cufftType type;
+    // {x, y, z}, or {x, y, z, batch, read, write} as in BATCH3DDFTProblem.
+    std::vector<int> sizes;
+    // forward, inverse.
+    fftxPlanKernel kernel[2];
+    std::complex<double> sym[1];
+};
+
+/** \internal */
+inline std::vector<fftxPlan*> & fftxPlans() {
+    static std::vector<fftxPlan*> plans;
+    return plans;
+}
+
+/** \internal
+    Plans sharing a fixed-library transform share its init and destroy. Each
+    lookup returns its own copy of the tuple, so they are counted by initfp.
+*/
+inline int fftxLibUsers(transformTuple_t *tupl, int change) {
+    static std::map<initTransformFunc, int> users;
+    return users[tupl->initfp] += change;
+}
+
+/** \internal */
+inline fftxPlan * fftxGetPlan(cufftHandle plan) {
+    if(plan < 0 || plan >= (int) fftxPlans().size())
+        return nullptr;
+    return fftxPlans()[plan];
+}
+
+/** \internal */
+inline std::unique_ptr<FFTXProblem> fftxPlanProblem(const std::string& name, const std::vector<int>& sizes) {
+    std::unique_ptr<FFTXProblem> p;
+    if(name == "mddft")
+        p.reset(new MDDFTProblem(sizes, name));
+    else if(name == "imddft")
+        p.reset(new IMDDFTProblem(sizes, name));
+    else if(name == "mdprdft")
+        p.reset(new MDPRDFTProblem(sizes, name));
+    else if(name == "imdprdft")
+        p.reset(new IMDPRDFTProblem(sizes, name));
+    else if(name == "b1dft")
+        p.reset(new BATCH1DDFTProblem(sizes, name));
+    else if(name == "ib1dft")
+        p.reset(new IBATCH1DDFTProblem(sizes, name));
+    else if(name == "mddftbat")
+        p.reset(new BATCH3DDFTProblem(sizes, name));
+    else if(name == "imddftbat")
+        p.reset(new IBATCH3DDFTProblem(sizes, name));
+    else if(name == "mdprdftbat")
+        p.reset(new BATCH3DPRDFTProblem(sizes, name));
+    else
+        p.reset(new IBATCH3DPRDFTProblem(sizes, name));
+    return p;
+}
+
+/** \internal
+    Gets the code of a transform from the disk cache, or generates it, and
+    builds it in e.
+*/
+inline void fftxPlanBuild(Executor &e, const std::string& name, const std::vector<int>& sizes) {
+    std::string code;
+    std::ifstream ifs ( getFromCache(name, sizes) );
+    if(ifs) {
+        if ( DEBUGOUT) std::cout << "plan " << name << " found on disk" << std::endl;
+        code.assign( ( std::istreambuf_iterator<char>(ifs) ),
+                     ( std::istreambuf_iterator<char>()    ) );
     }
     else {
-        if(sign == -1)
-            MDDFTProblem mdp(args, sizes, "mddft");
-        else 
-            IMDDFTProblem mdp(args, sizes, "imddft");
-        mdp.transform();
-        stored_mddft_jit[std::make_tuple(x,y,z,sign)] = mdp.returnJIT();
+        if ( DEBUGOUT) std::cout << "plan " << name << " generating" << std::endl;
+        code = fftxPlanProblem(name, sizes)->semantics2();
+        printToCache(code, name, sizes);
     }
+    e.execute(code);
 }
-void mdprdft(int x, int y, int z, int sign, double * Y, double * X) {
-    if ( DEBUGOUT) std::cout << "Entered mddft fftx cpu api call" << std::endl;
-    std::complex<double> * dsym = new std::complex<double>[1];
-    // hipMalloc((void **)&dsym,  1* sizeof(std::complex<double>));
-    std::vector<void*> args{(void*)Y,(void*)X,(void*)dsym};
-    std::vector<int> sizes{x,y,z};
-    if(stored_mdprdft_jit.find(std::make_tuple(x,y,z,sign)) != stored_mdprdft_jit.end()) {
-        if ( DEBUGOUT) std::cout << "running cached instance" << std::endl;
-        Executor e;
-        e.execute(stored_mdprdft_jit.at(std::make_tuple(x,y,z,sign)));
+
+/** \internal
+    Looks up the fixed library (unless lib is false), then the disk cache,
+    then generates the code, and leaves the kernel initialized.
+*/
+inline void fftxPlanPrepare(fftxPlanKernel &k, const std::vector<int>& sizes, bool lib = true) {
+    k.tupl = lib ? getLibTransform(k.name, sizes) : nullptr;
+    if(k.tupl != nullptr) {
+        if ( DEBUGOUT) std::cout << "plan " << k.name << " found in fixed library" << std::endl;
+        if(fftxLibUsers(k.tupl, 1) == 1)
+            ( * k.tupl->initfp )();
     }
     else {
-        if(sign == -1)
-            MDPRDFTProblem mdp(args, sizes, "mdprdft");
-        else 
-            IMDPRDFTProblem mdp(args, sizes, "imdprdft");
-        mdp.transform();
-        stored_mdprdft_jit[std::make_tuple(x,y,z,sign)] = mdp.returnJIT();
+        fftxPlanBuild(k.exec, k.name, sizes);
+        k.exec.load(k.name);
+        k.exec.clean();
     }
+    k.ready = true;
+}
+
+/** \internal
+    Prepares kernels of one transform that may run at once from different
+    threads. The code is built once and each kernel loads its own instance of
+    it, with its own temporaries; the fixed library has only one instance.
+*/
+inline void fftxPlanPrepareCopies(std::vector<fftxPlanKernel*> ks, const std::string& name, const std::vector<int>& sizes) {
+    if(ks.empty())
+        return;
+    Executor e;
+    fftxPlanBuild(e, name, sizes);
+    for(fftxPlanKernel *k : ks) {
+        k->name = name;
+        k->tupl = nullptr;
+        k->exec = e;
+        k->exec.load(name);
+        k->exec.clean();
+        k->ready = true;
+    }
+    e.clean();
+}
+
+/** \internal */
+inline void fftxPlanRun(fftxPlanKernel &k, void *out, void *in, void *sym) {
+    if(k.tupl != nullptr) {
+        double *s = isBatchLibTransform(k.name) ? (double*)in : (double*)sym;
+        ( * k.tupl->runfp ) ( (double*)out, (double*)in, s );
+    }
+    else {
+        std::vector<void*> args{out, in, sym};
+        k.exec.run(args);
+    }
+}
+
+/** \internal */
+inline void fftxPlanRelease(fftxPlanKernel &k) {
+    if(!k.ready)
+        return;
+    if(k.tupl == nullptr)
+        k.exec.unload();
+    else {
+        if(fftxLibUsers(k.tupl, -1) == 0)
+            ( * k.tupl->destroyfp )();
+        free(k.tupl);
+        k.tupl = nullptr;
+    }
+    k.ready = false;
+}
+
+/** \internal */
+inline cufftResult fftxPlanExec(cufftHandle plan, int dir, void *out, void *in) {
+    fftxPlan *p = fftxGetPlan(plan);
+    if(p == nullptr)
+        return CUFFT_INVALID_PLAN;
+    fftxPlanKernel &k = p->kernel[dir];
+    if(k.name.empty())
+        return CUFFT_INVALID_VALUE;
+    if(!k.ready)
+        fftxPlanPrepare(k, p->sizes);
+    fftxPlanRun(k, out, in, p->sym);
+    return CUFFT_SUCCESS;
+}
+
+/** \internal
+    Maps one side of a batched layout of rank dimensions to the batch
+    read/write flag: 0 for contiguous arrays, 1 for arrays interleaved element
+    by element. Returns -1 for any other layout.
+*/
+inline int fftxPlanLayout(int rank, const int *embed, const int *dims, int stride, int dist, int batch) {
+    int total = 1;
+    for(int i = 0; i < rank; i++) {
+        if(embed != nullptr && embed[i] != dims[i])
+            return -1;
+        total *= dims[i];
+    }
+    // a single array still has to be contiguous; only its distance is free.
+    if(stride == 1 && (batch == 1 || dist == total))
+        return 0;
+    if(stride == batch && dist == 1)
+        return 1;
+    return -1;
+}
+
+/** Creates a plan for batch 1D FFTs of length n[0], or batch 3D FFTs of size
+    n[0] x n[1] x n[2], n[2] fastest. As in cuFFT, the strides and distances
+    are used only when the embeds are given. 1D complex batches may take any
+    strides and distances that keep the arrays apart (see BatchLayout). 3D
+    batches may too, with embeds equal to the cube and a stride between the
+    elements of each cube, z fastest; real 3D batches must keep the cubes
+    apart. A single 3D FFT must be contiguous. Real-to-complex plans are
+    compiled here; complex-to-complex plans are compiled on the first exec in
+    each direction. Every later exec is a single call.
+*/
+inline cufftResult cufftPlanMany(cufftHandle *plan, int rank, int *n, int *inembed,
+        int istride, int idist, int *onembed, int ostride,
+        int odist, cufftType type, int batch) {
+    if(rank != 1 && rank != 3) {
+        std::cout << "only supports 1d and 3d ffts" << std::endl;
+        return CUFFT_INVALID_SIZE;
+    }
+    for(int i = 0; i < rank; i++)
+        if(n[i] < 1)
+            return CUFFT_INVALID_SIZE;
+    if(batch < 1)
+        return CUFFT_INVALID_SIZE;
+    bool r2c = (type == CUFFT_R2C || type == CUFFT_D2Z);
+    bool c2r = (type == CUFFT_C2R || type == CUFFT_Z2D);
+    std::vector<int> sizes;
+    std::string bat;
+    if(rank == 1) {
+        if(r2c || c2r)
+            return CUFFT_NOT_SUPPORTED;
+        BatchLayout layout;
+        if(inembed != nullptr) {
+            layout.istride = istride;
+            layout.idist = idist;
+            layout.inembed = inembed[0];
+        }
+        if(onembed != nullptr) {
+            layout.ostride = ostride;
+            layout.odist = odist;
+            layout.onembed = onembed[0];
+        }
+        sizes = batchLayoutSizes(n[0], batch, layout);
+        if(sizes.empty())
+            return CUFFT_INVALID_VALUE;
+    }
+    else if(batch > 1) {
+        // embeds that pad a dimension would change the addressing of a cube.
+        int full[3] = {n[0], n[1], n[2]};
+        int half[3] = {n[0], n[1], n[2]/2 + 1};
+        for(int i = 0; i < 3; i++)
+            if((inembed != nullptr && inembed[i] != (c2r ? half : full)[i]) ||
+               (onembed != nullptr && onembed[i] != (r2c ? half : full)[i]))
+                return CUFFT_NOT_SUPPORTED;
+        BatchLayout layout;
+        if(inembed != nullptr) {
+            layout.istride = istride;
+            layout.idist = idist;
+        }
+        if(onembed != nullptr) {
+            layout.ostride = ostride;
+            layout.odist = odist;
+        }
+        sizes = batchLayoutSizes(r2c ? "mdprdftbat" : (c2r ? "imdprdftbat" : "mddftbat"), n[0], n[1], n[2], batch, layout);
+        if(sizes.empty())
+            return CUFFT_NOT_SUPPORTED;
+        bat = "bat";
+    }
+    else {
+        int full[3] = {n[0], n[1], n[2]};
+        int half[3] = {n[0], n[1], n[2]/2 + 1};
+        int read = (inembed == nullptr) ? 0 : fftxPlanLayout(3, inembed, c2r ? half : full, istride, idist, batch);
+        int write = (onembed == nullptr) ? 0 : fftxPlanLayout(3, onembed, r2c ? half : full, ostride, odist, batch);
+        if(read < 0 || write < 0 || ((r2c || c2r) && (read != 0 || write != 0)))
+            return CUFFT_NOT_SUPPORTED;
+        sizes = {n[0], n[1], n[2]};
+    }
+
+    fftxPlan *p = new fftxPlan;
+    p->type = type;
+    p->sizes = sizes;
+    if(rank == 1) {
+        p->kernel[0].name = "b1dft";
+        p->kernel[1].name = "ib1dft";
+    }
+    else if(r2c) {
+        p->kernel[0].name = "mdprdft" + bat;
+        fftxPlanPrepare(p->kernel[0], p->sizes);
+    }
+    else if(c2r) {
+        p->kernel[1].name = "imdprdft" + bat;
+        fftxPlanPrepare(p->kernel[1], p->sizes);
+    }
+    else {
+        p->kernel[0].name = "mddft" + bat;
+        p->kernel[1].name = "imddft" + bat;
+    }
+    fftxPlans().push_back(p);
+    *plan = (cufftHandle) fftxPlans().size() - 1;
+    return CUFFT_SUCCESS;
+}
+
+/** Creates a plan for a batch of packed 1D FFTs of length nx. */
+inline cufftResult cufftPlan1d(cufftHandle *plan, int nx, cufftType type, int batch) {
+    return cufftPlanMany(plan, 1, &nx, nullptr, 1, 0, nullptr, 1, 0, type, batch);
+}
+
+/** Creates a plan for a single 3D FFT of size nx x ny x nz, nz fastest. */
+inline cufftResult cufftPlan3d(cufftHandle *plan, int nx, int ny, int nz, cufftType type) {
+    int n[3] = {nx, ny, nz};
+    return cufftPlanMany(plan, 3, n, nullptr, 1, 0, nullptr, 1, 0, type, 1);
+}
+
+/** Plans are made by cufftPlanMany, cufftPlan1d or cufftPlan3d; this only resets the handle. */
+inline cufftResult cufftCreate(cufftHandle *plan) {
+    *plan = -1;
+    return CUFFT_SUCCESS;
+}
+
+/** Releases the kernels held by the plan. */
+inline cufftResult cufftDestroy(cufftHandle plan) {
+    fftxPlan *p = fftxGetPlan(plan);
+    if(p == nullptr)
+        return CUFFT_INVALID_PLAN;
+    for(fftxPlanKernel &k : p->kernel)
+        fftxPlanRelease(k);
+    delete p;
+    fftxPlans()[plan] = nullptr;
+    return CUFFT_SUCCESS;
+}
+
+/** Complex-to-complex FFT; direction is CUFFT_FORWARD or CUFFT_INVERSE (unnormalized). */
+inline cufftResult cufftExecZ2Z(cufftHandle plan, cufftDoubleComplex *idata,
+        cufftDoubleComplex *odata, int direction) {
+    if(direction != CUFFT_FORWARD && direction != CUFFT_INVERSE)
+        return CUFFT_INVALID_VALUE;
+    return fftxPlanExec(plan, direction == CUFFT_FORWARD ? 0 : 1, odata, idata);
+}
+
+/** Same as cufftExecZ2Z; cufftComplex is double precision here. */
+inline cufftResult cufftExecC2C(cufftHandle plan, cufftComplex *idata,
+        cufftComplex *odata, int direction) {
+    return cufftExecZ2Z(plan, idata, odata, direction);
+}
+
+/** Real-to-complex FFT. */
+inline cufftResult cufftExecD2Z(cufftHandle plan, cufftDoubleReal *idata, cufftDoubleComplex *odata) {
+    return fftxPlanExec(plan, 0, odata, idata);
+}
+
+/** Complex-to-real FFT (unnormalized). */
+inline cufftResult cufftExecZ2D(cufftHandle plan, cufftDoubleComplex *idata, cufftDoubleReal *odata) {
+    return fftxPlanExec(plan, 1, odata, idata);
+}
+
+/** Same as cufftExecD2Z. */
+inline cufftResult cufftExecR2C(cufftHandle plan, cufftReal *idata, cufftComplex *odata) {
+    return cufftExecD2Z(plan, idata, odata);
+}
+
+/** Same as cufftExecZ2D. */
+inline cufftResult cufftExecC2R(cufftHandle plan, cufftComplex *idata, cufftReal *odata) {
+    return cufftExecZ2D(plan, idata, odata);
+}
+
+/** \internal */
+inline cufftHandle fftxCachedPlan(std::map<keys_t, cufftHandle> &plans, int x, int y, int z, int sign, cufftType type) {
+    keys_t key = std::make_tuple(x,y,z,sign);
+    if(plans.find(key) == plans.end()) {
+        cufftHandle plan;
+        if(cufftPlan3d(&plan, x, y, z, type) != CUFFT_SUCCESS) {
+            std::cout << "cannot plan " << x << " x " << y << " x " << z << " fft" << std::endl;
+            exit(-1);
+        }
+        plans[key] = plan;
+    }
+    return plans.at(key);
+}
+
+inline void mddft(int x, int y, int z, int sign, double * Y, double * X) {
+    if ( DEBUGOUT) std::cout << "Entered mddft fftx cpu api call" << std::endl;
+    static std::map<keys_t, cufftHandle> plans;
+    cufftHandle plan = fftxCachedPlan(plans, x, y, z, sign, CUFFT_Z2Z);
+    cufftExecZ2Z(plan, (cufftDoubleComplex*)X, (cufftDoubleComplex*)Y, sign);
+}
+
+inline void mdprdft(int x, int y, int z, int sign, double * Y, double * X) {
+    if ( DEBUGOUT) std::cout << "Entered mdprdft fftx cpu api call" << std::endl;
+    static std::map<keys_t, cufftHandle> plans;
+    cufftHandle plan = fftxCachedPlan(plans, x, y, z, sign, sign == -1 ? CUFFT_D2Z : CUFFT_Z2D);
+    if(sign == -1)
+        cufftExecD2Z(plan, X, (cufftDoubleComplex*)Y);
+    else
+        cufftExecZ2D(plan, (cufftDoubleComplex*)X, Y);
 }
 #endif
 
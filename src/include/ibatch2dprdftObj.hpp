@@ -1,35 +1,56 @@
 using namespace fftx;
 
-static std::string ibatch2dprdft_script = "transform := let(\n\
-         TFCall(TRC(TTensorI(TTensorI(PRDFT(N, sign), b, write, read), B, AVec, AVec)),\n\
+// read seq, write seq
+static std::string ibatch2dprdft_script_0x0 = "transform := let(\n\
+         TFCall(TRC(TTensorI(TTensorI(IPRDFT(N, sign), b, write, read), B, AVec, AVec)),\n\
             rec(fname := name, params := [])));";
 
+// read seq, write strided
+static std::string ibatch2dprdft_script_0x1 = "transform := let(\n\
+    TFCall(TRC(TTensorI(Prm(fTensor(L(IPRDFT1(N, sign).dims()[1]/2 * b, IPRDFT1(N, sign).dims()[1]/2), fId(2))) *\n\
+    TTensorI(IPRDFT1(N, sign), b, APar, read), B, AVec, AVec)),\n\
+    rec(fname := name, params := [])));";
+
+//read strided, write seq
+static std::string ibatch2dprdft_script_1x0 = "transform := let(\n\
+    TFCall(TRC(TTensorI(TTensorI(IPRDFT1(N, sign), b, APar, read) * \n\
+        Prm(fTensor(L(IPRDFT1(N, sign).dims()[2]/2 * b, b), fId(2))), B, AVec, AVec)), \n\
+    rec(fname := name, params := [])));";
+
 class IBATCH2DPRDFTProblem: public FFTXProblem {
 public:
     using FFTXProblem::FFTXProblem;
     void randomProblemInstance() {
     }
     void semantics() {
-        std::cout << "Import(realdft);" << std::endl;
-        std::cout << "N := " << sizes.at(0) << ";" << std::endl;
-        std::cout << "B := " << sizes.at(1) << ";" << std::endl;
-        std::cout << "b := " << sizes.at(2) << ";" << std::endl;
+        fftx::script() << "Import(realdft);" << std::endl;
+        fftx::script() << "N := " << sizes.at(0) << ";" << std::endl;
+        fftx::script() << "B := " << sizes.at(1) << ";" << std::endl;
+        fftx::script() << "b := " << sizes.at(2) << ";" << std::endl;
 
         if(sizes.at(3) == 0) {
-            std::cout << "read := APar;" << std::endl;
+            fftx::script() << "read := APar;" << std::endl;
         }
         else{
-            std::cout << "read := AVec;" << std::endl;
+            fftx::script() << "read := AVec;" << std::endl;
         }
         if(sizes.at(4) == 0) {
-            std::cout << "write := APar;" << std::endl;
+            fftx::script() << "write := APar;" << std::endl;
         }
         else{
-            std::cout << "write := AVec;" << std::endl;
+            fftx::script() << "write := AVec;" << std::endl;
+        }
+        fftx::script() << "sign := 1;" << std::endl;
+        fftx::script() << "name := \""<< name << "_spiral" << "\";" << std::endl;
+        if(sizes.at(3) == 0 && sizes.at(4) == 0)
+            fftx::script() << ibatch2dprdft_script_0x0 << std::endl;
+        else if(sizes.at(3) == 0 && sizes.at(4) == 1)
+            fftx::script() << ibatch2dprdft_script_0x1 << std::endl;
+        else if(sizes.at(3) == 1 && sizes.at(4) == 0)
+            fftx::script() << ibatch2dprdft_script_1x0 << std::endl;
+        else {
+            std::cout << "ibatch2dprdft: read and write can not both be strided" << std::endl;
+            exit(-1);
         }
-        std::cout << "sign := 1;" << std::endl;
-        std::cout << "name := \""<< name << "_spiral" << "\";" << std::endl;
-        std::cout << ibatch2dprdft_script << std::endl;
     }
 };
-
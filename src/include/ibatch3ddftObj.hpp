@@ -0,0 +1,43 @@
+using namespace fftx;
+
+// sizes: {x, y, z, batch, read, write}; read/write 0 for contiguous cubes
+// (APar), 1 for cubes interleaved element by element (AVec), or with
+// explicit strides as from batchLayoutSizes().
+static std::string ibatch3ddft_script = "var_1:= var(\"var_1\", BoxND([0,0,0], TReal));\n\
+symvar := var(\"sym\", TPtr(TReal));\n\
+transform := TFCall(TDecl(TDAG([\n\
+        TDAGNode(TTensorI(MDDFT(szcube, sign), B, write, read), Y, X),\n\
+                ]),\n\
+        [var_1]\n\
+        ),\n\
+    rec(fname:=name, params:= [symvar])\n\
+);";
+
+// explicit strides, see batchLayoutSizes().
+static std::string ibatch3ddft_strided_script = "var_1:= var(\"var_1\", BoxND([0,0,0], TReal));\n\
+symvar := var(\"sym\", TPtr(TReal));\n\
+transform := TFCall(TDecl(TDAG([\n\
+        TDAGNode(TCompose([TScat(wfun), TTensorI(MDDFT(szcube, sign), B, write, read), TGath(rfun)]), Y, X),\n\
+                ]),\n\
+        [var_1]\n\
+        ),\n\
+    rec(fname:=name, params:= [symvar])\n\
+);";
+
+class IBATCH3DDFTProblem: public FFTXProblem {
+public:
+    using FFTXProblem::FFTXProblem;
+    void randomProblemInstance() {
+    }
+    void semantics() {
+        fftx::script() << "szcube := [" << sizes.at(0) << ", " << sizes.at(1) << ", " << sizes.at(2) << "];" << std::endl;
+        fftx::script() << "B := " << sizes.at(3) << ";" << std::endl;
+        checkBatchLayout("imddftbat", sizes);
+        bool strided = sizes.size() > 6;
+        int n = sizes.at(0) * sizes.at(1) * sizes.at(2);
+        printBatchLayout(n, n, &sizes.at(4), strided);
+        fftx::script() << "sign := 1;" << std::endl;
+        fftx::script() << "name := \""<< name << "_spiral" << "\";" << std::endl;
+        fftx::script() << (strided ? ibatch3ddft_strided_script : ibatch3ddft_script) << std::endl;
+    }
+};
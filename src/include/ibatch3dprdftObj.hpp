@@ -0,0 +1,48 @@
+using namespace fftx;
+
+// sizes: {x, y, z, batch, read, write} with read = write = 0 for contiguous
+// cubes (APar), or with explicit strides as from batchLayoutSizes(), which
+// keep the cubes apart. A real cube and its complex half cube cannot share
+// an element-wise interleaving.
+static std::string ibatch3dprdft_script = "var_1:= var(\"var_1\", BoxND([0,0,0], TReal));\n\
+symvar := var(\"sym\", TPtr(TReal));\n\
+transform := TFCall(TDecl(TDAG([\n\
+        TDAGNode(TTensorI(IMDPRDFT(szcube, sign), B, write, read), Y, X),\n\
+                ]),\n\
+        [var_1]\n\
+        ),\n\
+    rec(fname:=name, params:= [symvar])\n\
+);";
+
+// explicit strides, see batchLayoutSizes().
+static std::string ibatch3dprdft_strided_script = "var_1:= var(\"var_1\", BoxND([0,0,0], TReal));\n\
+symvar := var(\"sym\", TPtr(TReal));\n\
+transform := TFCall(TDecl(TDAG([\n\
+        TDAGNode(TCompose([TScat(wfun), TTensorI(IMDPRDFT(szcube, sign), B, write, read), TGath(rfun)]), Y, X),\n\
+                ]),\n\
+        [var_1]\n\
+        ),\n\
+    rec(fname:=name, params:= [symvar])\n\
+);";
+
+class IBATCH3DPRDFTProblem: public FFTXProblem {
+public:
+    using FFTXProblem::FFTXProblem;
+    void randomProblemInstance() {
+    }
+    void semantics() {
+        fftx::script() << "Import(realdft);" << std::endl;
+        fftx::script() << "szcube := [" << sizes.at(0) << ", " << sizes.at(1) << ", " << sizes.at(2) << "];" << std::endl;
+        fftx::script() << "B := " << sizes.at(3) << ";" << std::endl;
+        checkBatchLayout("imdprdftbat", sizes);
+        bool strided = sizes.size() > 6;
+        int full = sizes.at(0) * sizes.at(1) * sizes.at(2);
+        int half = sizes.at(0) * sizes.at(1) * (sizes.at(2)/2 + 1);
+        // the complex side is addressed in complex elements, the code in reals.
+        bool pairs[2] = {true, false};
+        printBatchLayout(half, full, &sizes.at(4), strided, pairs);
+        fftx::script() << "sign := 1;" << std::endl;
+        fftx::script() << "name := \""<< name << "_spiral" << "\";" << std::endl;
+        fftx::script() << (strided ? ibatch3dprdft_strided_script : ibatch3dprdft_script) << std::endl;
+    }
+};
@@ -18,6 +18,7 @@
 #include <sys/stat.h>
 #include <fcntl.h>
 #include <memory>
+#include <mutex>
 
 #if defined(_WIN32) || defined (_WIN64)
   #include <io.h>
@@ -40,22 +41,84 @@
 #else
 #include "cpubackend.hpp"
 #endif
+//  fftx_libs_config.h is written by config-fftx-libs.sh; without it assume the
+//  libraries build-lib-code.sh builds by default
+#if defined __has_include
+#if __has_include("fftx_libs_config.h")
+#include "fftx_libs_config.h"
+#endif
+#endif
+#if !defined FFTX_LIBS_CONFIG_HEADER
+#define FFTX_PMDDFT_LIB
+#define FFTX_MDDFTBAT_LIB
+#define FFTX_MDPRDFTBAT_LIB
+#define FFTX_RESAMPLE_LIB
+#define FFTX_R2R_LIB
+#endif
 #if defined (FFTX_CUDA) || defined(FFTX_HIP)
 #include "fftx_mddft_gpu_public.h"
 #include "fftx_imddft_gpu_public.h"
 #include "fftx_mdprdft_gpu_public.h"
 #include "fftx_imdprdft_gpu_public.h"
 #include "fftx_rconv_gpu_public.h"
+#include "fftx_rconvc_gpu_public.h"
+#if defined FFTX_PMDDFT_LIB
+#include "fftx_pmddft_gpu_public.h"
+#include "fftx_ipmddft_gpu_public.h"
+#endif
+#if defined FFTX_RESAMPLE_LIB
+#include "fftx_resample_gpu_public.h"
+#endif
+#if defined FFTX_R2R_LIB
+#include "fftx_mddct_gpu_public.h"
+#include "fftx_imddct_gpu_public.h"
+#include "fftx_mddst_gpu_public.h"
+#include "fftx_imddst_gpu_public.h"
+#include "fftx_mddct1_gpu_public.h"
+#include "fftx_mddst1_gpu_public.h"
+#endif
 #include "fftx_dftbat_gpu_public.h"
 #include "fftx_idftbat_gpu_public.h"
+#if defined FFTX_MDDFTBAT_LIB
+#include "fftx_mddftbat_gpu_public.h"
+#include "fftx_imddftbat_gpu_public.h"
+#endif
+#if defined FFTX_MDPRDFTBAT_LIB
+#include "fftx_mdprdftbat_gpu_public.h"
+#include "fftx_imdprdftbat_gpu_public.h"
+#endif
 #else
 #include "fftx_mddft_cpu_public.h"
 #include "fftx_imddft_cpu_public.h"
 #include "fftx_mdprdft_cpu_public.h"
 #include "fftx_imdprdft_cpu_public.h"
 #include "fftx_rconv_cpu_public.h"
+#include "fftx_rconvc_cpu_public.h"
+#if defined FFTX_PMDDFT_LIB
+#include "fftx_pmddft_cpu_public.h"
+#include "fftx_ipmddft_cpu_public.h"
+#endif
+#if defined FFTX_RESAMPLE_LIB
+#include "fftx_resample_cpu_public.h"
+#endif
+#if defined FFTX_R2R_LIB
+#include "fftx_mddct_cpu_public.h"
+#include "fftx_imddct_cpu_public.h"
+#include "fftx_mddst_cpu_public.h"
+#include "fftx_imddst_cpu_public.h"
+#include "fftx_mddct1_cpu_public.h"
+#include "fftx_mddst1_cpu_public.h"
+#endif
 #include "fftx_dftbat_cpu_public.h"
 #include "fftx_idftbat_cpu_public.h"
+#if defined FFTX_MDDFTBAT_LIB
+#include "fftx_mddftbat_cpu_public.h"
+#include "fftx_imddftbat_cpu_public.h"
+#endif
+#if defined FFTX_MDPRDFTBAT_LIB
+#include "fftx_mdprdftbat_cpu_public.h"
+#include "fftx_imdprdftbat_cpu_public.h"
+#endif
 #endif
 #pragma once
 
@@ -107,6 +170,239 @@ inline void restore_input(int saved_fd)
     close(saved_fd);
 }
 
+/** \internal
+    Expands the sizes of a pruned 3D DFT to {x, y, z, input box lo and extents,
+    output box lo and extents}, 0-based. Sizes {x, y, z} alone select the
+    pruning of the fixed library: the forward transform keeps the output on
+    [0, n/2) in each dimension, the inverse takes its input on that box.
+*/
+inline std::vector<int> prunedBoxes(bool fwd, const std::vector<int>& sizes) {
+    if(sizes.size() == 15)
+        return sizes;
+    if(sizes.size() != 3) {
+        std::cout << "pruned mddft: sizes must have 3 or 15 entries" << std::endl;
+        exit(-1);
+    }
+    std::vector<int> full = {0, 0, 0, sizes.at(0), sizes.at(1), sizes.at(2)};
+    std::vector<int> half = {0, 0, 0, sizes.at(0)/2, sizes.at(1)/2, sizes.at(2)/2};
+    std::vector<int> ret(sizes.begin(), sizes.end());
+    ret.insert(ret.end(), (fwd ? full : half).begin(), (fwd ? full : half).end());
+    ret.insert(ret.end(), (fwd ? half : full).begin(), (fwd ? half : full).end());
+    return ret;
+}
+
+/** Data layout of a batch of 1D complex arrays, as in <tt>cufftPlanMany</tt>
+    and <tt>fftw_plan_many_dft</tt>: element j of array b is at
+    <tt>b*idist + j*istride</tt> in the input and <tt>b*odist + j*ostride</tt>
+    in the output, counted in complex elements. A distance of 0 means packed
+    arrays, <tt>n*stride</tt> apart. inembed and onembed, when not 0, are the
+    lengths allocated for each array and must be at least n; in 1D they do not
+    change the addressing.
+*/
+struct BatchLayout {
+    int istride = 1;
+    int idist = 0;
+    int ostride = 1;
+    int odist = 0;
+    int inembed = 0;
+    int onembed = 0;
+};
+
+/** \internal
+    Classifies one side of a batch layout: 0 for packed arrays, 1 for arrays
+    interleaved element by element, 2 for other strides that keep the arrays
+    apart, -1 if the arrays overlap.
+*/
+inline int batchLayoutSide(int n, int batch, int stride, int& dist, int embed) {
+    if(dist == 0)
+        dist = n * stride;
+    if(stride < 1 || dist < 1 || (embed != 0 && embed < n))
+        return -1;
+    if(stride == 1 && (dist == n || batch == 1))
+        return 0;
+    if(stride == batch && dist == 1)
+        return 1;
+    if(batch == 1 || dist >= (n-1)*stride + 1 || stride >= (batch-1)*dist + 1)
+        return 2;
+    return -1;
+}
+
+/** Returns the sizes of a batch of <tt>batch</tt> 1D DFTs of length n with the
+    given layout, for <tt>BATCH1DDFTProblem</tt> and <tt>IBATCH1DDFTProblem</tt>.
+    Packed and interleaved layouts give {n, batch, read, write}, with 0 for
+    packed (APar) and 1 for interleaved (AVec), as the \c dftbat libraries
+    take them. Other layouts give
+    {n, batch, read, write, istride, idist, ostride, odist}, with 2 on the
+    strided sides, and are generated at run time. Returns an empty vector if
+    the arrays of either side overlap.
+*/
+inline std::vector<int> batchLayoutSizes(int n, int batch, const BatchLayout& layout) {
+    int idist = layout.idist, odist = layout.odist;
+    int read = batchLayoutSide(n, batch, layout.istride, idist, layout.inembed);
+    int write = batchLayoutSide(n, batch, layout.ostride, odist, layout.onembed);
+    if(read < 0 || write < 0)
+        return {};
+    if(read < 2 && write < 2)
+        return {n, batch, read, write};
+    return {n, batch, read, write, layout.istride, idist, layout.ostride, odist};
+}
+
+/** \internal
+    True if one side of a batch layout, with the flag from batchLayoutSide(),
+    holds arrays of n elements interleaved (AVec) rather than apart (APar).
+*/
+inline bool batchLayoutVec(int n, int flag, int stride, int dist) {
+    // explicit strides either keep the arrays apart or interleave them.
+    return (flag == 1) || (flag == 2 && dist < (n-1)*stride + 1);
+}
+
+/** Returns the sizes of a batch of <tt>batch</tt> 3D DFTs of size x x y x z
+    with the given layout, for the \c mddftbat, \c imddftbat, \c mdprdftbat
+    and \c imdprdftbat problems. Each cube is addressed as one array of its
+    elements, z fastest, so strides, distances and embeds mean what they mean
+    for a batch of 1D arrays. They count reals on the real side of
+    \c mdprdftbat and \c imdprdftbat and complex elements elsewhere; the
+    complex side of a real transform has x*y*(z/2+1) elements. Packed and
+    interleaved layouts give {x, y, z, batch, read, write}, as the batch
+    libraries take them. Other layouts give
+    {x, y, z, batch, read, write, istride, idist, ostride, odist} and are
+    generated at run time. Returns an empty vector if the arrays of either
+    side overlap, or if a real batch is interleaved.
+*/
+inline std::vector<int> batchLayoutSizes(const std::string& name, int x, int y, int z, int batch, const BatchLayout& layout) {
+    bool real = (name == "mdprdftbat" || name == "imdprdftbat");
+    int full = x * y * z, half = x * y * (z/2 + 1);
+    int nin = (name == "imdprdftbat") ? half : full;
+    int nout = (name == "mdprdftbat") ? half : full;
+    int idist = layout.idist, odist = layout.odist;
+    int read = batchLayoutSide(nin, batch, layout.istride, idist, layout.inembed);
+    int write = batchLayoutSide(nout, batch, layout.ostride, odist, layout.onembed);
+    if(read < 0 || write < 0)
+        return {};
+    // a real cube and its complex half cube cannot share one interleaving.
+    if(real && (batchLayoutVec(nin, read, layout.istride, idist) || batchLayoutVec(nout, write, layout.ostride, odist)))
+        return {};
+    if(read < 2 && write < 2)
+        return {x, y, z, batch, read, write};
+    return {x, y, z, batch, read, write, layout.istride, idist, layout.ostride, odist};
+}
+
+/** \internal
+    Exits with a message unless the sizes of a 3D batch problem are
+    {x, y, z, batch, read, write} with flags the batch libraries take (0 or 1
+    for complex batches, 0 for real ones), or sizes from batchLayoutSizes()
+    with explicit strides.
+*/
+inline void checkBatchLayout(const std::string& name, const std::vector<int>& sizes) {
+    bool real = (name == "mdprdftbat" || name == "imdprdftbat");
+    bool ok = false;
+    if(sizes.size() == 6) {
+        int top = real ? 0 : 1;
+        ok = sizes.at(4) >= 0 && sizes.at(4) <= top && sizes.at(5) >= 0 && sizes.at(5) <= top;
+    }
+    else if(sizes.size() == 10) {
+        BatchLayout layout;
+        layout.istride = sizes.at(6);
+        layout.idist = sizes.at(7);
+        layout.ostride = sizes.at(8);
+        layout.odist = sizes.at(9);
+        ok = batchLayoutSizes(name, sizes.at(0), sizes.at(1), sizes.at(2), sizes.at(3), layout) == sizes;
+    }
+    if(!ok) {
+        std::cout << name << ": unsupported batch layout, sizes must be {x, y, z, batch, read, write} with read and write "
+                  << (real ? "0" : "0 or 1") << ", or come from batchLayoutSizes()" << std::endl;
+        exit(-1);
+    }
+}
+
+/** \internal
+    Prints the SPIRAL read and write tags of a batch of B arrays of nin input
+    and nout output elements. layout points to the read and write flags of
+    sizes from batchLayoutSizes(), followed, if strided, by
+    {istride, idist, ostride, odist}. With explicit strides it also prints
+    rfun and wfun, the gather and scatter around the tensor. A side with
+    pairs set holds complex elements seen as pairs of reals, so its map is
+    tensored with fId(2).
+*/
+inline void printBatchLayout(int nin, int nout, const int *layout, bool strided, const bool *pairs = nullptr) {
+    for(int i = 0; i < 2; i++) {
+        int n = (i == 0) ? nin : nout;
+        int flag = layout[i];
+        int stride = strided ? layout[2+2*i] : 1;
+        int dist = strided ? layout[3+2*i] : n;
+        bool avec = batchLayoutVec(n, flag, stride, dist);
+        fftx::script() << (i == 0 ? "read" : "write") << " := " << (avec ? "AVec" : "APar") << ";" << std::endl;
+        if(!strided)
+            continue;
+        std::ostringstream f;
+        if(flag != 2)
+            f << "fId(" << n << "*B)";
+        else if(avec)
+            f << "fTensor(fId(" << n << "), H(" << stride << ", B, 0, " << dist << "))";
+        else
+            f << "fTensor(fId(B), H(" << dist << ", " << n << ", 0, " << stride << "))";
+        bool pair = (pairs != nullptr) && pairs[i];
+        fftx::script() << (i == 0 ? "rfun" : "wfun") << " := "
+                       << (pair ? "fTensor(" + f.str() + ", fId(2))" : f.str()) << ";" << std::endl;
+    }
+}
+
+/** \internal
+    Prints the SPIRAL read and write tags of a batch of 1D DFTs with sizes
+    from batchLayoutSizes(). With explicit strides it also prints rfun and
+    wfun, the gather and scatter around the tensor, and returns true.
+*/
+inline bool printBatchLayout(const std::vector<int>& sizes) {
+    bool strided = sizes.size() > 4;
+    printBatchLayout(sizes.at(0), sizes.at(0), &sizes.at(2), strided);
+    return strided;
+}
+
+/** \internal
+    True for the batch libraries, whose run functions take no symbol.
+*/
+inline bool isBatchLibTransform(const std::string& name) {
+    return name == "dftbat" || name == "b1dft" || name == "idftbat" || name == "ib1dft" ||
+           name == "mddftbat" || name == "imddftbat" || name == "mdprdftbat" || name == "imdprdftbat";
+}
+
+/** \internal
+    Expands the sizes of a resampling to {output extents, input extents,
+    shift numerators, shift denominator}, with the shift in input cells.
+    Sizes {x, y, z} alone select the fixed library: Fourier interpolation
+    from the grid n/2 in each dimension onto the cube n, with no shift.
+*/
+inline std::vector<int> resampleSizes(const std::vector<int>& sizes) {
+    if(sizes.size() == 3)
+        return {sizes.at(0), sizes.at(1), sizes.at(2),
+                sizes.at(0)/2, sizes.at(1)/2, sizes.at(2)/2, 0, 0, 0, 1};
+    if(sizes.size() != 10 || sizes.at(9) <= 0) {
+        std::cout << "resample: sizes must have 3 entries, or 10 with a positive shift denominator" << std::endl;
+        exit(-1);
+    }
+    return sizes;
+}
+
+/** \internal
+    The kind of real-to-real transform along each dimension. It is set by the
+    name for "mddct", "imddct", "mddst", "imddst", "mddct1" and "mddst1" with
+    sizes {x, y, z}, and by sizes {x, y, z, kind x, kind y, kind z}, as
+    fftx::r2r_t values, for "mdr2r".
+*/
+inline std::array<fftx::r2r_t, 3> r2rKinds(const std::string& name, const std::vector<int>& sizes) {
+    static const std::map<std::string, fftx::r2r_t> kinds = {
+        {"mddct", fftx::DCT2}, {"imddct", fftx::DCT3}, {"mddct1", fftx::DCT1},
+        {"mddst", fftx::DST2}, {"imddst", fftx::DST3}, {"mddst1", fftx::DST1}};
+    if(name == "mdr2r" && sizes.size() == 6)
+        return {{(fftx::r2r_t) sizes.at(3), (fftx::r2r_t) sizes.at(4), (fftx::r2r_t) sizes.at(5)}};
+    auto it = kinds.find(name);
+    if(it == kinds.end() || sizes.size() != 3) {
+        std::cout << "r2r: " << name << " needs sizes {x, y, z}, or \"mdr2r\" {x, y, z, kinds}" << std::endl;
+        exit(-1);
+    }
+    return {{it->second, it->second, it->second}};
+}
+
 inline transformTuple_t * getLibTransform(std::string name, std::vector<int> sizes) {
     if(name == "mddft") {
         return fftx_mddft_Tuple(fftx::point_t<3>({{sizes.at(0), sizes.at(1), sizes.at(2)}}));
@@ -123,12 +419,82 @@ inline transformTuple_t * getLibTransform(std::string name, std::vector<int> siz
     else if(name == "rconv") {
         return fftx_rconv_Tuple(fftx::point_t<3>({{sizes.at(0), sizes.at(1), sizes.at(2)}}));
     }
+    else if(name == "rconvc") {
+        return fftx_rconvc_Tuple(fftx::point_t<3>({{sizes.at(0), sizes.at(1), sizes.at(2)}}));
+    }
+    else if(name == "pmddft" || name == "ipmddft") {
+        // only the library's own pruning is precompiled.
+        bool fwd = (name == "pmddft");
+        if(prunedBoxes(fwd, sizes) != prunedBoxes(fwd, {sizes.at(0), sizes.at(1), sizes.at(2)}))
+            return nullptr;
+#if defined FFTX_PMDDFT_LIB
+        fftx::point_t<3> sz({{sizes.at(0), sizes.at(1), sizes.at(2)}});
+        return fwd ? fftx_pmddft_Tuple(sz) : fftx_ipmddft_Tuple(sz);
+#else
+        return nullptr;
+#endif
+    }
+    else if(name == "resample") {
+        // only 2x refinement without shift is precompiled.
+        std::vector<int> r = resampleSizes(sizes);
+        std::vector<int> lib = resampleSizes({sizes.at(0), sizes.at(1), sizes.at(2)});
+        if(!std::equal(lib.begin(), lib.begin() + 6, r.begin()) || r[6] != 0 || r[7] != 0 || r[8] != 0)
+            return nullptr;
+#if defined FFTX_RESAMPLE_LIB
+        return fftx_resample_Tuple(fftx::point_t<3>({{sizes.at(0), sizes.at(1), sizes.at(2)}}));
+#else
+        return nullptr;
+#endif
+    }
+    else if(name == "mddct" || name == "imddct" || name == "mddst" || name == "imddst" || name == "mddct1" || name == "mddst1") {
+#if defined FFTX_R2R_LIB
+        fftx::point_t<3> sz({{sizes.at(0), sizes.at(1), sizes.at(2)}});
+        if(name == "mddct")
+            return fftx_mddct_Tuple(sz);
+        else if(name == "imddct")
+            return fftx_imddct_Tuple(sz);
+        else if(name == "mddst")
+            return fftx_mddst_Tuple(sz);
+        else if(name == "imddst")
+            return fftx_imddst_Tuple(sz);
+        else if(name == "mddct1")
+            return fftx_mddct1_Tuple(sz);
+        else
+            return fftx_mddst1_Tuple(sz);
+#else
+        return nullptr;
+#endif
+    }
+    else if((name == "dftbat" || name == "b1dft" || name == "idftbat" || name == "ib1dft") && sizes.size() > 4) {
+        // explicit strides are only generated at run time.
+        return nullptr;
+    }
     else if(name == "dftbat" || name == "b1dft") {
         return fftx_dftbat_Tuple(fftx::point_t<4>({{sizes.at(0), sizes.at(1), sizes.at(2), sizes.at(3)}}));
     }
     else if(name == "idftbat" || name == "ib1dft") {
         return fftx_idftbat_Tuple(fftx::point_t<4>({{sizes.at(0), sizes.at(1), sizes.at(2), sizes.at(3)}}));
     }
+    else if((name == "mddftbat" || name == "imddftbat" || name == "mdprdftbat" || name == "imdprdftbat") && sizes.size() > 6) {
+        // explicit strides are only generated at run time.
+        return nullptr;
+    }
+    else if(name == "mddftbat" || name == "imddftbat" || name == "mdprdftbat" || name == "imdprdftbat") {
+        fftx::point_t<6> req({{sizes.at(0), sizes.at(1), sizes.at(2), sizes.at(3), sizes.at(4), sizes.at(5)}});
+#if defined FFTX_MDDFTBAT_LIB
+        if(name == "mddftbat")
+            return fftx_mddftbat_Tuple(req);
+        else if(name == "imddftbat")
+            return fftx_imddftbat_Tuple(req);
+#endif
+#if defined FFTX_MDPRDFTBAT_LIB
+        if(name == "mdprdftbat")
+            return fftx_mdprdftbat_Tuple(req);
+        else if(name == "imdprdftbat")
+            return fftx_imdprdftbat_Tuple(req);
+#endif
+        return nullptr;
+    }
     else {
         if(DEBUGOUT)
             std::cout << "non-supported fixed library transform" << std::endl; 
@@ -136,6 +502,15 @@ inline transformTuple_t * getLibTransform(std::string name, std::vector<int> siz
     }
 }
 
+/** \internal
+    Guards FFTXProblem::executors and FFTXProblem::res against threads calling
+    transform() at once.
+*/
+inline std::mutex & fftxExecutorsLock() {
+    static std::mutex lock;
+    return lock;
+}
+
 inline std::string getFFTX() {
      const char * tmp2 = std::getenv("FFTX_HOME");
     std::string tmp(tmp2 ? tmp2 : "");
@@ -158,6 +533,38 @@ inline std::string getSPIRAL() {
     return tmp;
 }
 
+/** \internal
+    Runs SPIRAL on script and returns what it prints. The script goes through
+    a file of its own instead of stdin, so threads can run SPIRAL at once.
+*/
+inline std::string runSPIRAL(const std::string& spiral, const std::string& script) {
+#if defined(_WIN32) || defined (_WIN64)
+    char buf[L_tmpnam_s];
+    bool ok = (tmpnam_s(buf, L_tmpnam_s) == 0);
+    std::string fname(ok ? buf : "");
+#else
+    const char *dir = std::getenv("TMPDIR");
+    std::string path = std::string(dir ? dir : "/tmp") + "/fftx_spiral_XXXXXX";
+    std::vector<char> buf(path.begin(), path.end());
+    buf.push_back('\0');
+    int fd = mkstemp(buf.data());
+    bool ok = (fd >= 0);
+    if(ok)
+        close(fd);
+    std::string fname(buf.data());
+#endif
+    if(!ok) {
+        std::cout << "cannot create a file for the SPIRAL script" << std::endl;
+        exit(-1);
+    }
+    std::ofstream f(fname);
+    f << script;
+    f.close();
+    std::string result = exec((spiral + " < \"" + fname + "\"").c_str());
+    std::remove(fname.c_str());
+    return result;
+}
+
 inline std::string getFromCache(std::string name, std::vector<int> sizes) {
     std::ostringstream oss;
     std::string tmp = getFFTX();
@@ -175,6 +582,21 @@ inline std::string getFromCache(std::string name, std::vector<int> sizes) {
     return oss.str();
 }
 
+/** \internal
+    FNV-1a hash of a traced script, in hex, to tell apart cached code of
+    scripts traced under one name.
+*/
+inline std::string scriptHash(const std::string& text) {
+    uint64_t h = 14695981039346656037ULL;
+    for(unsigned char c : text) {
+        h ^= c;
+        h *= 1099511628211ULL;
+    }
+    std::ostringstream oss;
+    oss << std::hex << h;
+    return oss.str();
+}
+
 inline void printToCache(std::string spiral_out, std::string name, std::vector<int> sizes) {
     std::ofstream cached_file;
     std::string file_name;
@@ -189,7 +611,16 @@ inline void printToCache(std::string spiral_out, std::string name, std::vector<i
     #else
         file_name.append("_CPU.txt");
     #endif
-    cached_file.open(file_name);
+    // written aside and renamed, so a concurrent getFromCache never sees part of it.
+    std::string part = file_name;
+    #if !defined(_WIN32) && !defined (_WIN64)
+        part += ".XXXXXX";
+        int fd = mkstemp(&part[0]);
+        if(fd < 0)
+            return;
+        close(fd);
+    #endif
+    cached_file.open(part);
     while(spiral_out.back() != '}') {
         spiral_out.pop_back();
     }
@@ -200,33 +631,34 @@ inline void printToCache(std::string spiral_out, std::string name, std::vector<i
     #endif
     cached_file << spiral_out;
     cached_file.close();
-
+    if(part != file_name && std::rename(part.c_str(), file_name.c_str()) != 0)
+        std::remove(part.c_str());
 }
 
 inline void getImportAndConf() {
-    std::cout << "Load(fftx);\nImportAll(fftx);\n";
+    fftx::script() << "Load(fftx);\nImportAll(fftx);\n";
     #if (defined FFTX_HIP || FFTX_CUDA)
-    std::cout << "ImportAll(simt);\nLoad(jit);\nImport(jit);\n";
+    fftx::script() << "ImportAll(simt);\nLoad(jit);\nImport(jit);\n";
     #endif
     #if defined FFTX_HIP 
-    std::cout << "conf := FFTXGlobals.defaultHIPConf();\n";
+    fftx::script() << "conf := FFTXGlobals.defaultHIPConf();\n";
     #elif defined FFTX_CUDA 
-    std::cout << "conf := LocalConfig.fftx.confGPU();\n";
+    fftx::script() << "conf := LocalConfig.fftx.confGPU();\n";
     #else
-    std::cout << "conf := LocalConfig.fftx.defaultConf();\n";
+    fftx::script() << "conf := LocalConfig.fftx.defaultConf();\n";
     #endif
 }
 
 inline void printJITBackend(std::string name, std::vector<int> sizes) {
     std::string tmp = getFFTX();
-    std::cout << "if 1 = 1 then opts:=conf.getOpts(transform);\ntt:= opts.tagIt(transform);\nif(IsBound(fftx_includes)) then opts.includes:=fftx_includes;fi;\nc:=opts.fftxGen(tt);\n fi;\n";
-    std::cout << "GASMAN(\"collect\");\n";
+    fftx::script() << "if 1 = 1 then opts:=conf.getOpts(transform);\ntt:= opts.tagIt(transform);\nif(IsBound(fftx_includes)) then opts.includes:=fftx_includes;fi;\nc:=opts.fftxGen(tt);\n fi;\n";
+    fftx::script() << "GASMAN(\"collect\");\n";
     #if defined FFTX_HIP
-        std::cout << "PrintHIPJIT(c,opts);" << std::endl;
+        fftx::script() << "PrintHIPJIT(c,opts);" << std::endl;
     #elif defined FFTX_CUDA 
-        std::cout << "PrintJIT2(c,opts);" << std::endl;
+        fftx::script() << "PrintJIT2(c,opts);" << std::endl;
     #else
-        std::cout << "opts.prettyPrint(c);" << std::endl;
+        fftx::script() << "opts.prettyPrint(c);" << std::endl;
     #endif
 }
 
@@ -258,8 +690,21 @@ public:
     - \c "mdprdft":  real-to-complex 3D FFT
     - \c "imdprdft":  complex-to-real 3D FFT
     - \c "rconv":  real 3D convolution
+    - \c "rconvbat":  real 3D convolutions of one input with several symbols
+    - \c "rconvc":  real 3D convolution with a complex symbol
+    - \c "rconvsep":  real 3D convolution with a separable complex symbol generated in the kernel
+    - \c "pmddft":  forward complex-to-complex 3D FFT, pruned input and/or output
+    - \c "ipmddft":  inverse complex-to-complex 3D FFT, pruned input and/or output
     - \c "b1dft" or \c "dftbat":  forward 1D batch FFT
     - \c "ib1dft" or \c "idftbat":  inverse 1D batch FFT
+    - \c "mddftbat", \c "imddftbat":  forward and inverse complex-to-complex 3D batch FFT
+    - \c "mdprdftbat", \c "imdprdftbat":  real-to-complex and complex-to-real 3D batch FFT
+    - \c "resample":  Fourier interpolation of a real 3D field onto another grid, with a shift
+    - \c "mddct", \c "imddct":  real-to-real 3D DCT-II and DCT-III
+    - \c "mddst", \c "imddst":  real-to-real 3D DST-II and DST-III
+    - \c "mddct1", \c "mddst1":  real-to-real 3D DCT-I and DST-I
+    - \c "mdr2r":  real-to-real 3D DCT or DST with a kind per dimension
+    - any other name for a <tt>PIPELINEProblem</tt>, generated at run time
   */
     std::string name;
 
@@ -339,6 +784,10 @@ public:
   /** Returns time taken by the GPU to perform the transform, in milliseconds. */
     float getTime();
 
+  /** \internal
+      Name that keys the code cache on disk, with the sizes. */
+    virtual std::string cacheName() { return name; }
+
   /** Destructor. */
     ~FFTXProblem(){}
 
@@ -358,39 +807,15 @@ inline void FFTXProblem::setName(std::string name1) {
 
 inline std::string FFTXProblem::semantics2() {
     std::string tmp = getSPIRAL();
-    int p[2];
-
-#if defined(_WIN32) || defined (_WIN64)
-    if ( _pipe ( p, 4096, _O_BINARY ) == -1 )
-#define WRSIZECAST (unsigned int)
-#else
-    if(pipe(p) < 0)
-#define WRSIZECAST
-#endif
-        std::cout << "pipe failed\n";
-    std::stringstream out; 
-    std::streambuf *coutbuf = std::cout.rdbuf(out.rdbuf()); //save old buf
+    fftx::ScriptBuilder builder;
     getImportAndConf();
     semantics();
     printJITBackend(name, sizes);
-    std::cout.rdbuf(coutbuf);
-    std::string script = out.str();
-    int res = write(p[1], script.c_str(), WRSIZECAST script.size() );
-    close(p[1]);
-    int save_stdin = redirect_input(p[0]);
-    std::string result = exec(tmp.c_str());
-    restore_input(save_stdin);
-
-    #if defined(_WIN32) || defined (_WIN64)
-        // Crashes on windows if close p[0], so no-op
-    #else
-        close(p[0]);
-    #endif
+    std::string result = runSPIRAL(tmp, builder.str());
     while(result.back() != '}') {
         result.pop_back();
     }
     return result;
-    // return nullptr;
 }
 
 
@@ -409,12 +834,12 @@ inline void FFTXProblem::transform(){
             auto start = std::chrono::high_resolution_clock::now();
         #endif
             #if defined FFTX_CUDA
-            if(name != "dftbat" && name != "b1dft" && name != "idftbat" && name != "ib1dft")
+            if(!isBatchLibTransform(name))
                 ( * tupl->runfp ) ( *((double**)args.at(0)), *((double**)args.at(1)), (*(double**)args.at(2)) );
             else
                 ( * tupl->runfp ) ( *((double**)args.at(0)), *((double**)args.at(1)), *((double**)args.at(1)) );    
             #else
-            if(name != "dftbat" && name != "b1dft" && name != "idftbat" && name != "ib1dft")
+            if(!isBatchLibTransform(name))
                 ( * tupl->runfp ) ( (double*)args.at(0), (double*)args.at(1), (double*)args.at(2) );
             else
                 ( * tupl->runfp ) ( (double*)args.at(0), (double*)args.at(1), (double*)args.at(1) );
@@ -432,33 +857,43 @@ inline void FFTXProblem::transform(){
         //end time
     }
     else { // use RTC
-        if(executors.find(sizes) != executors.end()) { //check in memory cache
+        // executors is only touched under the lock; code is generated and built
+        // outside it, so threads planning other sizes do not wait.
+        Executor e;
+        bool cached;
+        {
+            std::lock_guard<std::mutex> guard(fftxExecutorsLock());
+            auto it = executors.find(sizes);
+            cached = (it != executors.end());
+            if(cached)
+                e = it->second;
+        }
+        if(cached) { //check in memory cache
             if ( DEBUGOUT) std::cout << "cached size found, running cached instance\n";
-            run(executors.at(sizes));
+            run(e);
+            return;
+        }
+        std::string code;
+        std::string file_name = getFromCache(cacheName(), sizes);
+        std::ifstream ifs ( file_name );
+        if(ifs) { //check filesystem cache
+            if ( DEBUGOUT) std::cout << "found cached file on disk\n";
+            code.assign( ( std::istreambuf_iterator<char>(ifs) ),
+                         ( std::istreambuf_iterator<char>()    ) );
+        }
+        else { //generate code at runtime
+            if ( DEBUGOUT) std::cout << "haven't seen size, generating\n";
+            code = semantics2();
+            printToCache(code, cacheName(), sizes);
         }
-        else { //check filesystem cache
-            std::string file_name = getFromCache(name, sizes);
-            std::ifstream ifs ( file_name );
-            if(ifs) {
-                if ( DEBUGOUT) std::cout << "found cached file on disk\n";
-                std::string fcontent ( ( std::istreambuf_iterator<char>(ifs) ),
-                                       ( std::istreambuf_iterator<char>()    ) );
-                res = fcontent;
-                Executor e;
-                e.execute(fcontent);
-                executors.insert(std::make_pair(sizes, e));
-                run(e);
-            } 
-            else { //generate code at runtime
-                if ( DEBUGOUT) std::cout << "haven't seen size, generating\n";
-                res = semantics2();
-                Executor e;
-                e.execute(res);
-                executors.insert(std::make_pair(sizes, e));
-                run(e);
-                printToCache(res, name, sizes);
-            }
+        e.execute(code);
+        {
+            std::lock_guard<std::mutex> guard(fftxExecutorsLock());
+            res = code;
+            // another thread may have built the same size meanwhile; keep theirs.
+            e = executors.insert(std::make_pair(sizes, e)).first->second;
         }
+        run(e);
     }
 }
 
@@ -0,0 +1,16 @@
+#include "pmddftObj.hpp"
+
+/** Inverse 3D DFT with pruned input and/or output. sizes is {x, y, z}, which
+    takes the input on [0, n/2) in each dimension and zero elsewhere, or
+    {x, y, z, input lo and extents, output lo and extents} with 0-based boxes.
+    Set the name to \c "ipmddft".
+*/
+class IPMDDFTProblem: public FFTXProblem {
+public:
+    using FFTXProblem::FFTXProblem;
+    void randomProblemInstance() {
+    }
+    void semantics() {
+        prunedMDDFTSemantics(1, sizes, name);
+    }
+};
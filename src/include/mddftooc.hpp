@@ -0,0 +1,169 @@
+#ifndef FFTX_MDDFT_OOC_HEADER
+#define FFTX_MDDFT_OOC_HEADER
+
+//  Copyright (c) 2018-2022, Carnegie Mellon University
+//  See LICENSE for details
+
+#include <complex>
+#include <vector>
+#include <string>
+#include <future>
+#include <functional>
+#include <iostream>
+#include <cstdlib>
+#include <cstring>
+
+#include <sys/types.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#if defined(FFTX_CUDA) || defined(FFTX_HIP)
+#error "mddftooc.hpp streams through host memory and needs the CPU backend"
+#endif
+
+#include "fftxfft.hpp"
+
+/** \internal
+    Reads or writes count complex values at element offset off of fd, in full.
+*/
+inline void fftx_ooc_io(int fd, std::complex<double> *buf, size_t count, size_t off, bool write) {
+    char *p = (char *) buf;
+    size_t bytes = count * sizeof(std::complex<double>);
+    off_t pos = (off_t) (off * sizeof(std::complex<double>));
+    while (bytes > 0) {
+        ssize_t n = write ? pwrite(fd, p, bytes, pos) : pread(fd, p, bytes, pos);
+        if (n <= 0) {
+            std::cout << "mddft_ooc: " << (write ? "write" : "read") << " failed at offset " << pos << std::endl;
+            exit(-1);
+        }
+        p += n;
+        bytes -= n;
+        pos += n;
+    }
+}
+
+/** \internal
+    Moves one slab between buf, laid out as [rows, chunk], and the file, where
+    row i starts at element base + i*stride.
+*/
+inline void fftx_ooc_slab(int fd, std::complex<double> *buf, size_t rows, size_t chunk, size_t base, size_t stride, bool write) {
+    for (size_t i = 0; i < rows; i++)
+        fftx_ooc_io(fd, buf + i * chunk, chunk, base + i * stride, write);
+}
+
+/** \internal
+    Batched 1D DFT of one stage. It is built and loaded when constructed, in
+    its own executor, and released when it goes out of scope.
+*/
+struct fftx_ooc_kernel {
+    fftx_cuFFT::fftxPlanKernel k;
+    fftx_ooc_kernel(const char *name, const std::vector<int> &sizes) {
+        k.name = name;
+        fftx_cuFFT::fftxPlanPrepare(k, sizes);
+    }
+    fftx_ooc_kernel(const fftx_ooc_kernel &) = delete;
+    ~fftx_ooc_kernel() {
+        fftx_cuFFT::fftxPlanRelease(k);
+    }
+    void run(std::complex<double> *out, std::complex<double> *in) {
+        fftx_cuFFT::fftxPlanRun(k, out, in, nullptr);
+    }
+};
+
+/** \internal
+    Largest divisor of n no greater than cap, or 0 if cap < 1.
+*/
+inline int fftx_ooc_divisor(int n, size_t cap) {
+    for (int d = n; d > 0; d--)
+        if (n % d == 0 && (size_t) d <= cap)
+            return d;
+    return 0;
+}
+
+/** \internal
+    One pass over the file in slabs s of [rows, chunk] at base s*chunk. Slab
+    s + 1 is read and slab s - 1 written in the background while slab s is
+    transformed, so three slab buffers are in use at a time.
+*/
+inline void fftx_ooc_pass(
+    int fd, std::complex<double> **buf, int slabs, size_t rows, size_t chunk, size_t stride,
+    const std::function<void(std::complex<double> *)> &compute
+) {
+    std::future<void> rd, wr[3];
+    rd = std::async(std::launch::async, fftx_ooc_slab, fd, buf[0], rows, chunk, (size_t) 0, stride, false);
+    for (int s = 0; s < slabs; s++) {
+        rd.get();
+        if (s + 1 < slabs) {
+            // the buffer of slab s + 1 was last written out as slab s - 2.
+            if (wr[(s+1)%3].valid())
+                wr[(s+1)%3].get();
+            rd = std::async(std::launch::async, fftx_ooc_slab, fd, buf[(s+1)%3], rows, chunk, (s+1) * chunk, stride, false);
+        }
+        compute(buf[s%3]);
+        wr[s%3] = std::async(std::launch::async, fftx_ooc_slab, fd, buf[s%3], rows, chunk, s * chunk, stride, true);
+    }
+    for (int i = 0; i < 3; i++)
+        if (wr[i].valid())
+            wr[i].get();
+}
+
+/** \internal */
+inline void fftx_ooc_mddft(int x, int y, int z, int fd, size_t mem_bytes, const char *name) {
+    size_t plane = (size_t) y * z;
+    // three slabs in flight plus one scratch slab.
+    size_t slab_max = mem_bytes / (4 * sizeof(std::complex<double>));
+    int xb = fftx_ooc_divisor(x, slab_max / plane);
+    int yb = fftx_ooc_divisor(y, slab_max / ((size_t) x * z));
+    if (xb == 0 || yb == 0) {
+        std::cout << "mddft_ooc: " << mem_bytes << " bytes cannot hold four slabs of "
+                  << x << " x " << y << " x " << z << std::endl;
+        exit(-1);
+    }
+    size_t slab = std::max((size_t) xb * plane, (size_t) x * yb * z);
+    std::vector<std::complex<double>> mem(4 * slab);
+    std::complex<double> *buf[3] = {mem.data(), mem.data() + slab, mem.data() + 2 * slab};
+    std::complex<double> *scratch = mem.data() + 3 * slab;
+
+    // each stage has its own sizes, so each keeps its own kernel loaded.
+    fftx_ooc_kernel fz(name, {z, xb * y, 0, 0});
+    fftx_ooc_kernel fy(name, {y, z, 1, 1});
+    fftx_ooc_kernel fx(name, {x, yb * z, 1, 1});
+
+    // pass 1: slabs of xb contiguous planes, 2D DFT of each plane.
+    fftx_ooc_pass(fd, buf, x / xb, 1, (size_t) xb * plane, 0, [&](std::complex<double> *b) {
+        fz.run(scratch, b);
+        for (int i = 0; i < xb; i++)
+            fy.run(b + i * plane, scratch + i * plane);
+    });
+
+    // pass 2: slabs of yb rows from every plane, read as [x, yb z], DFT along x.
+    fftx_ooc_pass(fd, buf, y / yb, x, (size_t) yb * z, plane, [&](std::complex<double> *b) {
+        fx.run(scratch, b);
+        memcpy(b, scratch, (size_t) x * yb * z * sizeof(std::complex<double>));
+    });
+}
+
+/** Computes an in-place 3D complex DFT of size x*y*z, z fastest, on an array
+    of <tt>std::complex<double></tt> that lives in the file open as fd (for
+    instance a memory-mapped or scratch file larger than RAM). The transform
+    takes two passes over the file in slabs, and uses about mem_bytes of memory.
+    Reads ahead and writes behind run in the background while a slab is
+    transformed. sign is -1 for the forward and 1 for the unnormalized inverse
+    transform.
+*/
+inline void mddft_ooc(int x, int y, int z, int sign, int fd, size_t mem_bytes) {
+    fftx_ooc_mddft(x, y, z, fd, mem_bytes, sign == -1 ? "b1dft" : "ib1dft");
+}
+
+/** Same as above, on the file at path, which must hold x*y*z complex values. */
+inline void mddft_ooc(int x, int y, int z, int sign, const std::string &path, size_t mem_bytes) {
+    int fd = open(path.c_str(), O_RDWR);
+    if (fd < 0) {
+        std::cout << "mddft_ooc: cannot open " << path << std::endl;
+        exit(-1);
+    }
+    mddft_ooc(x, y, z, sign, fd, mem_bytes);
+    close(fd);
+}
+
+#endif            //  FFTX_MDDFT_OOC_HEADER
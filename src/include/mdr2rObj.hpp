@@ -0,0 +1,35 @@
+#ifndef FFTX_MDR2R_OBJ_HEADER
+#define FFTX_MDR2R_OBJ_HEADER
+
+using namespace fftx;
+
+/** Real-to-real 3D DCT or DST, for Poisson problems with Dirichlet or Neumann
+    boundaries without embedding into a doubled periodic domain. The name sets
+    one kind for all dimensions: \c "mddct" (DCT-II), \c "imddct" (DCT-III),
+    \c "mddst" (DST-II), \c "imddst" (DST-III), \c "mddct1" (DCT-I) or
+    \c "mddst1" (DST-I), with sizes {x, y, z}. With the name \c "mdr2r",
+    sizes is {x, y, z, kind x, kind y, kind z}, as fftx::r2r_t values.
+    The transforms are unnormalized.
+*/
+class MDR2RProblem: public FFTXProblem {
+public:
+    using FFTXProblem::FFTXProblem;
+    void randomProblemInstance() {
+    }
+    void semantics() {
+        std::array<r2r_t,3> kinds = r2rKinds(name, sizes);
+        box_t<3> domain(point_t<3>({{1,1,1}}), point_t<3>({{sizes.at(0), sizes.at(1), sizes.at(2)}}));
+
+        tracing = true;
+        array_t<3,double> inputs(domain);
+        array_t<3,double> outputs(domain);
+        setInputs(inputs);
+        setOutputs(outputs);
+
+        openScalarDAG();
+        R2R<3>(kinds, outputs, inputs);
+        closeScalarDAG<3>("", name.c_str());
+    }
+};
+
+#endif            //  FFTX_MDR2R_OBJ_HEADER
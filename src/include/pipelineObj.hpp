@@ -0,0 +1,48 @@
+#ifndef FFTX_PIPELINE_OBJ_HEADER
+#define FFTX_PIPELINE_OBJ_HEADER
+
+#include <functional>
+
+using namespace fftx;
+
+/** A chain of operations traced with <tt>fftx::pipeline_t</tt> and generated
+    at run time as one function, in place of a call per stage. trace(sizes, name)
+    builds the pipeline and closes it under name. The code cache is keyed by
+    the name, the sizes and a hash of the traced script, so pipelines traced
+    under one name do not share code.
+    args are {output, input, symbol} as for the other problems.
+*/
+class PIPELINEProblem: public FFTXProblem {
+public:
+    typedef std::function<void(const std::vector<int>&, const std::string&)> trace_t;
+
+    PIPELINEProblem(std::string name1, trace_t trace1): FFTXProblem(name1), trace(trace1) {
+    }
+    PIPELINEProblem(const std::vector<void*>& args1, const std::vector<int>& sizes1,
+                    std::string name1, trace_t trace1):
+        FFTXProblem(args1, sizes1, name1), trace(trace1) {
+    }
+    void randomProblemInstance() {
+    }
+    void semantics() {
+        trace(sizes, name);
+    }
+
+    // traced with the variable counter at 1, so the hash is the same in every run.
+    std::string cacheName() {
+        uint64_t id = fftx::ID;
+        fftx::ID = 1;
+        std::string traced;
+        {
+            fftx::ScriptBuilder builder;
+            trace(sizes, name);
+            traced = builder.str();
+        }
+        fftx::ID = id;
+        return name + "_" + scriptHash(traced);
+    }
+
+    trace_t trace;
+};
+
+#endif            //  FFTX_PIPELINE_OBJ_HEADER
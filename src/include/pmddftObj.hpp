@@ -0,0 +1,45 @@
+#ifndef FFTX_PMDDFT_OBJ_HEADER
+#define FFTX_PMDDFT_OBJ_HEADER
+
+using namespace fftx;
+
+/** \internal
+    Traces a 3D DFT whose input is nonzero only on one sub-box and whose output
+    is needed only on another, as one pruned DFT node. The sizes are laid out
+    as in prunedBoxes().
+*/
+inline void prunedMDDFTSemantics(int sign, const std::vector<int>& sizes, const std::string& name) {
+    std::vector<int> b = prunedBoxes(sign == -1, sizes);
+    point_t<3> extents({{b[0], b[1], b[2]}});
+    box_t<3> inBox(point_t<3>({{b[3], b[4], b[5]}}),
+                   point_t<3>({{b[3]+b[6]-1, b[4]+b[7]-1, b[5]+b[8]-1}}));
+    box_t<3> outBox(point_t<3>({{b[9], b[10], b[11]}}),
+                    point_t<3>({{b[9]+b[12]-1, b[10]+b[13]-1, b[11]+b[14]-1}}));
+
+    tracing = true;
+    array_t<3,std::complex<double>> inputs(inBox);
+    array_t<3,std::complex<double>> outputs(outBox);
+    setInputs(inputs);
+    setOutputs(outputs);
+
+    openScalarDAG();
+    prunedMDDFT(extents, sign, outputs, inputs);
+    closeScalarDAG<3>("", name.c_str());
+}
+
+/** Forward 3D DFT with pruned input and/or output. sizes is {x, y, z}, which
+    keeps the output on [0, n/2) in each dimension, or
+    {x, y, z, input lo and extents, output lo and extents} with 0-based boxes.
+    Set the name to \c "pmddft".
+*/
+class PMDDFTProblem: public FFTXProblem {
+public:
+    using FFTXProblem::FFTXProblem;
+    void randomProblemInstance() {
+    }
+    void semantics() {
+        prunedMDDFTSemantics(-1, sizes, name);
+    }
+};
+
+#endif            //  FFTX_PMDDFT_OBJ_HEADER
@@ -0,0 +1,60 @@
+#ifndef FFTX_RCONVBAT_OBJ_HEADER
+#define FFTX_RCONVBAT_OBJ_HEADER
+
+using namespace fftx;
+
+/** Real 3D convolutions of one input with S real symbols, in one generated
+    function that runs the forward transform once and the S inverse transforms
+    as a batch. sizes is {x, y, z, S}. The S symbols, each on the half-size
+    spectrum as for rconv, are stored one after another in the symbol
+    argument, and the S results one after another in the output.
+    Set the name to \c "rconvbat".
+*/
+class RCONVBATProblem: public FFTXProblem {
+public:
+    using FFTXProblem::FFTXProblem;
+    void randomProblemInstance() {
+    }
+    void semantics() {
+        if(sizes.size() != 4 || sizes.at(3) < 1) {
+            std::cout << "rconvbat: sizes must be {x, y, z, number of symbols}" << std::endl;
+            exit(-1);
+        }
+        const int count = sizes.at(3);
+        #if FFTX_COMPLEX_TRUNC_LAST
+        const int fx = sizes.at(0);
+        const int fy = sizes.at(1);
+        const int fz = sizes.at(2)/2 + 1;
+        #else
+        const int fx = sizes.at(0)/2 + 1;
+        const int fy = sizes.at(1);
+        const int fz = sizes.at(2);
+        #endif
+
+        box_t<3> domain(point_t<3>({{1,1,1}}), point_t<3>({{sizes.at(0), sizes.at(1), sizes.at(2)}}));
+        box_t<3> fdomain(point_t<3>({{1,1,1}}), point_t<3>({{fx, fy, fz}}));
+        // the S spectra and results are stacked along the slowest dimension.
+        box_t<3> domains(point_t<3>({{1,1,1}}), point_t<3>({{count*sizes.at(0), sizes.at(1), sizes.at(2)}}));
+        box_t<3> fdomains(point_t<3>({{1,1,1}}), point_t<3>({{count*fx, fy, fz}}));
+
+        tracing = true;
+
+        std::array<array_t<3,std::complex<double>>,2> intermediates {{fdomain, fdomains}};
+        array_t<3,double> inputs(domain);
+        array_t<3,double> outputs(domains);
+        array_t<3,double> symbol(fdomain);
+
+        setInputs(inputs);
+        setOutputs(outputs);
+
+        openScalarDAG();
+
+        PRDFT(domain.extents(), intermediates[0], inputs);
+        kernels(count, symbol, intermediates[1], intermediates[0]);
+        IPRDFT(domain.extents(), count, outputs, intermediates[1]);
+
+        closeScalarDAG(intermediates, name.c_str());
+    }
+};
+
+#endif            //  FFTX_RCONVBAT_OBJ_HEADER
@@ -0,0 +1,49 @@
+#ifndef FFTX_RCONVC_OBJ_HEADER
+#define FFTX_RCONVC_OBJ_HEADER
+
+using namespace fftx;
+
+/** Real 3D convolution with a complex symbol on the half-size spectrum, as
+    for rconv, for derivatives and shifts, which are not real in frequency
+    space. sizes is {x, y, z}. Set the name to \c "rconvc".
+*/
+class RCONVCProblem: public FFTXProblem {
+public:
+    using FFTXProblem::FFTXProblem;
+    void randomProblemInstance() {
+    }
+    void semantics() {
+        #if FFTX_COMPLEX_TRUNC_LAST
+        const int fx = sizes.at(0);
+        const int fy = sizes.at(1);
+        const int fz = sizes.at(2)/2 + 1;
+        #else
+        const int fx = sizes.at(0)/2 + 1;
+        const int fy = sizes.at(1);
+        const int fz = sizes.at(2);
+        #endif
+
+        box_t<3> domain(point_t<3>({{1,1,1}}), point_t<3>({{sizes.at(0), sizes.at(1), sizes.at(2)}}));
+        box_t<3> fdomain(point_t<3>({{1,1,1}}), point_t<3>({{fx, fy, fz}}));
+
+        tracing = true;
+
+        std::array<array_t<3,std::complex<double>>,2> intermediates {{fdomain, fdomain}};
+        array_t<3,double> inputs(domain);
+        array_t<3,double> outputs(domain);
+        array_t<3,std::complex<double>> symbol(fdomain);
+
+        setInputs(inputs);
+        setOutputs(outputs);
+
+        openScalarDAG();
+
+        PRDFT(domain.extents(), intermediates[0], inputs);
+        kernel(symbol, intermediates[1], intermediates[0]);
+        IPRDFT(domain.extents(), outputs, intermediates[1]);
+
+        closeScalarDAG(intermediates, name.c_str());
+    }
+};
+
+#endif            //  FFTX_RCONVC_OBJ_HEADER
@@ -0,0 +1,52 @@
+#ifndef FFTX_RCONVSEP_OBJ_HEADER
+#define FFTX_RCONVSEP_OBJ_HEADER
+
+using namespace fftx;
+
+/** Real 3D convolution with a separable complex symbol
+    f_x(i) * f_y(j) * f_z(k) on the half-size spectrum, generated in the
+    kernel from the factors instead of read from a full-size array.
+    sizes is {x, y, z}. The symbol argument holds the factors, as complex
+    values: f_x at each index of the spectrum in x, then f_y, then f_z.
+    Set the name to \c "rconvsep".
+*/
+class RCONVSEPProblem: public FFTXProblem {
+public:
+    using FFTXProblem::FFTXProblem;
+    void randomProblemInstance() {
+    }
+    void semantics() {
+        #if FFTX_COMPLEX_TRUNC_LAST
+        const int fx = sizes.at(0);
+        const int fy = sizes.at(1);
+        const int fz = sizes.at(2)/2 + 1;
+        #else
+        const int fx = sizes.at(0)/2 + 1;
+        const int fy = sizes.at(1);
+        const int fz = sizes.at(2);
+        #endif
+
+        box_t<3> domain(point_t<3>({{1,1,1}}), point_t<3>({{sizes.at(0), sizes.at(1), sizes.at(2)}}));
+        box_t<3> fdomain(point_t<3>({{1,1,1}}), point_t<3>({{fx, fy, fz}}));
+
+        tracing = true;
+
+        std::array<array_t<3,std::complex<double>>,2> intermediates {{fdomain, fdomain}};
+        array_t<3,double> inputs(domain);
+        array_t<3,double> outputs(domain);
+        array_t<1,std::complex<double>> factors(box_t<1>(point_t<1>({{1}}), point_t<1>({{fx + fy + fz}})));
+
+        setInputs(inputs);
+        setOutputs(outputs);
+
+        openScalarDAG();
+
+        PRDFT(domain.extents(), intermediates[0], inputs);
+        separableKernel(factors, intermediates[1], intermediates[0]);
+        IPRDFT(domain.extents(), outputs, intermediates[1]);
+
+        closeScalarDAG(intermediates, name.c_str());
+    }
+};
+
+#endif            //  FFTX_RCONVSEP_OBJ_HEADER
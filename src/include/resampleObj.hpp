@@ -0,0 +1,35 @@
+#ifndef FFTX_RESAMPLE_OBJ_HEADER
+#define FFTX_RESAMPLE_OBJ_HEADER
+
+using namespace fftx;
+
+/** Fourier interpolation of a real 3D field onto a grid of another size,
+    with a sub-cell shift, generated as one fused kernel. sizes is {x, y, z},
+    which resamples from the grid {x/2, y/2, z/2} onto {x, y, z} without shift,
+    or {output extents, input extents, shift numerators, shift denominator},
+    with the shift in input cells. Set the name to \c "resample".
+*/
+class RESAMPLEProblem: public FFTXProblem {
+public:
+    using FFTXProblem::FFTXProblem;
+    void randomProblemInstance() {
+    }
+    void semantics() {
+        std::vector<int> r = resampleSizes(sizes);
+        box_t<3> outBox(point_t<3>({{1,1,1}}), point_t<3>({{r[0], r[1], r[2]}}));
+        box_t<3> inBox(point_t<3>({{1,1,1}}), point_t<3>({{r[3], r[4], r[5]}}));
+        std::array<double,3> shift = {{r[6] / (double) r[9], r[7] / (double) r[9], r[8] / (double) r[9]}};
+
+        tracing = true;
+        array_t<3,double> inputs(inBox);
+        array_t<3,double> outputs(outBox);
+        setInputs(inputs);
+        setOutputs(outputs);
+
+        openScalarDAG();
+        resample<3>(shift, outputs, inputs);
+        closeScalarDAG<3>("", name.c_str());
+    }
+};
+
+#endif            //  FFTX_RESAMPLE_OBJ_HEADER
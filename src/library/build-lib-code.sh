@@ -72,13 +72,19 @@ else
     echo "./build-lib-code-options.sh file does not exist - assign default values"
     DFTBAT_LIB=true
     PRDFTBAT_LIB=true
+    MDDFTBAT_LIB=true
+    MDPRDFTBAT_LIB=true
     MDDFT_LIB=true
     MDPRDFT_LIB=true
     RCONV_LIB=true
+    PMDDFT_LIB=true
+    RESAMPLE_LIB=true
+    R2R_LIB=true
     PSATD_LIB=false
     CPU_SIZES_FILE="cube-sizes-cpu.txt"
     GPU_SIZES_FILE="cube-sizes-gpu.txt"
     DFTBAT_SIZES_FILE="dftbatch-sizes.txt"
+    MDDFTBAT_SIZES_FILE="mddftbatch-sizes.txt"
     PSATD_SIZES_FILE="cube-psatd.txt"
 fi
 
@@ -99,6 +105,16 @@ if [ $build_type = "CPU" ]; then
 	$pyexe gen_dftbat.py fftx_prdftbat $DFTBAT_SIZES_FILE $build_type true &
 	$pyexe gen_dftbat.py fftx_prdftbat $DFTBAT_SIZES_FILE $build_type false &
     fi
+    if [ "$MDDFTBAT_LIB" = true ]; then
+	waitspiral=true
+	$pyexe gen_dftbat.py fftx_mddftbat $MDDFTBAT_SIZES_FILE $build_type true &
+	$pyexe gen_dftbat.py fftx_mddftbat $MDDFTBAT_SIZES_FILE $build_type false &
+    fi
+    if [ "$MDPRDFTBAT_LIB" = true ]; then
+	waitspiral=true
+	$pyexe gen_dftbat.py fftx_mdprdftbat $MDDFTBAT_SIZES_FILE $build_type true &
+	$pyexe gen_dftbat.py fftx_mdprdftbat $MDDFTBAT_SIZES_FILE $build_type false &
+    fi
     if [ "$waitspiral" = true ]; then
 	wait		##  wait for the child processes to complete
     fi
@@ -116,6 +132,25 @@ if [ $build_type = "CPU" ]; then
     if [ "$RCONV_LIB" = true ]; then
 	waitspiral=true
 	$pyexe gen_files.py fftx_rconv $CPU_SIZES_FILE $build_type true &
+	$pyexe gen_files.py fftx_rconvc $CPU_SIZES_FILE $build_type true &
+    fi
+    if [ "$PMDDFT_LIB" = true ]; then
+	waitspiral=true
+	$pyexe gen_files.py fftx_pmddft $CPU_SIZES_FILE $build_type true &
+	$pyexe gen_files.py fftx_pmddft $CPU_SIZES_FILE $build_type false &
+    fi
+    if [ "$RESAMPLE_LIB" = true ]; then
+	waitspiral=true
+	$pyexe gen_files.py fftx_resample $CPU_SIZES_FILE $build_type true &
+    fi
+    if [ "$R2R_LIB" = true ]; then
+	waitspiral=true
+	$pyexe gen_files.py fftx_mddct $CPU_SIZES_FILE $build_type true &
+	$pyexe gen_files.py fftx_mddct $CPU_SIZES_FILE $build_type false &
+	$pyexe gen_files.py fftx_mddst $CPU_SIZES_FILE $build_type true &
+	$pyexe gen_files.py fftx_mddst $CPU_SIZES_FILE $build_type false &
+	$pyexe gen_files.py fftx_mddct1 $CPU_SIZES_FILE $build_type true &
+	$pyexe gen_files.py fftx_mddst1 $CPU_SIZES_FILE $build_type true &
     fi
     if [ "$waitspiral" = true ]; then
 	wait		##  wait for the child processes to complete
@@ -138,6 +173,16 @@ if [[ $build_type = "CUDA" || $build_type = "HIP" ]]; then
 	$pyexe gen_dftbat.py fftx_prdftbat $DFTBAT_SIZES_FILE $build_type true &
 	$pyexe gen_dftbat.py fftx_prdftbat $DFTBAT_SIZES_FILE $build_type false &
     fi
+    if [ "$MDDFTBAT_LIB" = true ]; then
+	waitspiral=true
+	$pyexe gen_dftbat.py fftx_mddftbat $MDDFTBAT_SIZES_FILE $build_type true &
+	$pyexe gen_dftbat.py fftx_mddftbat $MDDFTBAT_SIZES_FILE $build_type false &
+    fi
+    if [ "$MDPRDFTBAT_LIB" = true ]; then
+	waitspiral=true
+	$pyexe gen_dftbat.py fftx_mdprdftbat $MDDFTBAT_SIZES_FILE $build_type true &
+	$pyexe gen_dftbat.py fftx_mdprdftbat $MDDFTBAT_SIZES_FILE $build_type false &
+    fi
     if [ "$MDDFT_LIB" = true ]; then
 	waitspiral=true
 	$pyexe gen_files.py fftx_mddft $GPU_SIZES_FILE $build_type true &
@@ -151,6 +196,25 @@ if [[ $build_type = "CUDA" || $build_type = "HIP" ]]; then
     if [ "$RCONV_LIB" = true ]; then
 	waitspiral=true
 	$pyexe gen_files.py fftx_rconv $GPU_SIZES_FILE $build_type true &
+	$pyexe gen_files.py fftx_rconvc $GPU_SIZES_FILE $build_type true &
+    fi
+    if [ "$PMDDFT_LIB" = true ]; then
+	waitspiral=true
+	$pyexe gen_files.py fftx_pmddft $GPU_SIZES_FILE $build_type true &
+	$pyexe gen_files.py fftx_pmddft $GPU_SIZES_FILE $build_type false &
+    fi
+    if [ "$RESAMPLE_LIB" = true ]; then
+	waitspiral=true
+	$pyexe gen_files.py fftx_resample $GPU_SIZES_FILE $build_type true &
+    fi
+    if [ "$R2R_LIB" = true ]; then
+	waitspiral=true
+	$pyexe gen_files.py fftx_mddct $GPU_SIZES_FILE $build_type true &
+	$pyexe gen_files.py fftx_mddct $GPU_SIZES_FILE $build_type false &
+	$pyexe gen_files.py fftx_mddst $GPU_SIZES_FILE $build_type true &
+	$pyexe gen_files.py fftx_mddst $GPU_SIZES_FILE $build_type false &
+	$pyexe gen_files.py fftx_mddct1 $GPU_SIZES_FILE $build_type true &
+	$pyexe gen_files.py fftx_mddst1 $GPU_SIZES_FILE $build_type true &
     fi
     if [ "$PSATD_LIB" = true ]; then
 	waitspiral=true
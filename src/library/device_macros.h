@@ -135,6 +135,24 @@
         }                                                       \
     } while(0)
 
+#elif defined(MPI_VERSION)
+// neither CUDA nor HIP, with mpi.h included first: host memory stands in for
+// device memory, so the CPU slab plan and its callers can use the same calls.
+#include <cstdlib>
+#include <cstring>
+
+#define DEVICE_SUCCESS 0
+#define DEVICE_ERROR_T int
+#define DEVICE_MALLOC(ptr, size) ((*((void **) (ptr)) = malloc(size)) == NULL)
+#define DEVICE_FREE free
+#define DEVICE_MEM_COPY(dst, src, size, kind) (memcpy((dst), (src), (size)), DEVICE_SUCCESS)
+#define DEVICE_SYNCHRONIZE() ((void)0)
+#define MEM_COPY_DEVICE_TO_DEVICE 0
+#define MEM_COPY_DEVICE_TO_HOST 1
+#define MEM_COPY_HOST_TO_DEVICE 2
+#define DEVICE_FFT_HANDLE int
+#define DEVICE_FFT_FORWARD -1
+#define DEVICE_FFT_INVERSE 1
 #else
 // neither CUDA nor HIP
 #define DEVICE_SUCCESS 0
@@ -0,0 +1,81 @@
+
+##  Copyright (c) 2018-2022, Carnegie Mellon University
+##  See LICENSE for details
+
+# 3D DCT, type II and III
+
+##  Script to generate code, will be driven by a size specification and will write the
+##  CUDA/HIP/CPU code to a file.  The forward transform is the unnormalized DCT-II
+##  in each dimension, the inverse the DCT-III, as defined by SPIRAL DCT2 and DCT3.
+
+Load(fftx);
+ImportAll(fftx);
+ImportAll(simt);
+
+##  If the variable createJIT is defined and set true then load the jit module
+if ( IsBound(createJIT) and createJIT ) then
+    Load(jit);
+    Import(jit);
+fi;
+
+if codefor = "CUDA" then
+    conf := LocalConfig.fftx.confGPU();
+elif codefor = "HIP" then
+    conf := FFTXGlobals.defaultHIPConf();
+elif codefor = "CPU" then
+    conf := LocalConfig.fftx.defaultConf();
+fi;
+
+if fwd then
+    prefix := "fftx_mddct_";
+    jitpref := "cache_mddct_";
+    xfm := DCT2;
+else
+    prefix := "fftx_imddct_";
+    jitpref := "cache_imddct_";
+    xfm := DCT3;
+fi;
+
+if 1 = 1 then
+    name := prefix::StringInt(szcube[1])::ApplyFunc(ConcatenationString, List(Drop(szcube, 1), s->"x"::StringInt(s)));
+    name := name::"_"::codefor;
+    jitname := jitpref::StringInt(szcube[1])::ApplyFunc(ConcatenationString, List(Drop(szcube, 1), s->"x"::StringInt(s)));
+    jitname := jitname::"_"::codefor::".txt";
+    
+    PrintLine("fftx_mddct-frame: name = ", name, ", cube = ", szcube, ", jitname = ", jitname, ";\t\t##PICKME##");
+
+    ##  the 1D transform along each dimension, the last dimension fastest
+    factors := List([1..3], d -> TTensorI(TTensorI(xfm(szcube[d]), Product(szcube{[d+1..3]}), AVec, AVec),
+                                          Product(szcube{[1..d-1]}), APar, APar));
+    var_1:= X;
+    var_2:= Y;
+    symvar := var("sym", TPtr(TReal));
+    t := TFCall(TDecl(TDAG([
+            TDAGNode(TCompose(factors), var_2,var_1),
+        ]), []),
+        rec(fname:=name, params:= [symvar])
+    );
+    
+    opts := conf.getOpts(t);
+    if not IsBound ( libdir ) then
+        libdir := "srcs";
+    fi;
+
+    ##  We need the Spiral functions wrapped in 'extern C' for adding to a library
+    opts.wrapCFuncs := true;
+    tt := opts.tagIt(t);
+    if(IsBound(fftx_includes)) then opts.includes:=fftx_includes; fi;
+    c := opts.fftxGen(tt);
+    ##  opts.prettyPrint(c);
+    PrintTo(libdir::"/"::name::file_suffix, opts.prettyPrint(c));
+
+    ##  If the variable createJIT is defined and set true then output the JIT code to a file
+    if ( IsBound(createJIT) and createJIT ) then
+	cachedir := GetEnv("FFTX_HOME");
+	if (cachedir = "") then cachedir := "../.."; fi;
+        cachedir := cachedir::"/cache_jit_files/";
+        if ( codefor = "HIP" ) then PrintTo ( cachedir::jitname, PrintHIPJIT ( c, opts ) ); fi;
+        if ( codefor = "CUDA" ) then PrintTo ( cachedir::jitname, PrintJIT2 ( c, opts ) ); fi;
+        if ( codefor = "CPU" ) then PrintTo ( cachedir::jitname, opts.prettyPrint ( c ) ); fi;
+    fi;
+fi;
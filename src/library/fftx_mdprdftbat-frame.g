@@ -0,0 +1,96 @@
+##  Copyright (c) 2018-2023, Carnegie Mellon University
+##  See LICENSE for details
+
+##  batch of 3D real DFTs (real to complex forward, complex to real inverse)
+
+##  Parameters expected to be defined ahead of this code:
+##  szcube -- size of each 3D DFT, [x, y, z]
+##  nbatch -- batch size
+##  rdstride -- read stride type { APar }
+##  wrstride -- write stride type { APar }
+##  codefor -- which architecture to generate code for { CUDA | CPU | HIP }
+##  fwd -- Transform direction { true | false }
+##  libdir -- name of directory in which to write files
+##  file_suffix -- suffix part of output file name
+
+##  APar: cubes are contiguous, one after the other
+##  Only APar is supported: a real cube and its complex half cube differ in size,
+##  so they cannot be interleaved element-wise with the same stride.
+
+Load(fftx);
+ImportAll(fftx);
+ImportAll(realdft);
+ImportAll(simt);
+
+##  If the variable createJIT is defined and set true then load the jit module
+if ( IsBound(createJIT) and createJIT ) then
+    Load(jit);
+    Import(jit);
+fi;
+
+if codefor = "CUDA" then
+    conf := LocalConfig.fftx.confGPU();
+elif codefor = "CPU" then
+    conf := LocalConfig.fftx.defaultConf();
+else    
+    conf := FFTXGlobals.defaultHIPConf();
+fi;
+
+if fwd then
+    prefix := "fftx_mdprdftbat_";
+    jitpref := "cache_mdprdftbat_";
+    sign   := -1;
+else
+    prefix := "fftx_imdprdftbat_";
+    jitpref := "cache_imdprdftbat_";
+    sign   := 1;
+fi;
+
+if 1 = 1 then
+    cubestr := StringInt(szcube[1])::ApplyFunc(ConcatenationString, List(Drop(szcube, 1), s->"x"::StringInt(s)));
+    name := prefix::cubestr::"_bat_"::StringInt(nbatch)::"_"::wrstride::"_"::rdstride::"_"::codefor;
+    jitname := jitpref::cubestr::"_bat_"::StringInt(nbatch)::"_"::wrstride::"_"::rdstride::"_"::codefor::".txt";
+
+    PrintLine("fftx_mdprdftbat: name = ", name, " cube = ", szcube, " bat = ", nbatch, " write stride: ", wrstride,
+              " read stride: ", rdstride );
+
+    _wr := APar;
+    _rd := APar;
+    if rdstride <> "APar" or wrstride <> "APar" then
+        Error("fftx_mdprdftbat: only APar read and write strides are supported");
+    fi;
+    dft := When ( fwd, MDPRDFT, IMDPRDFT );
+
+    var_1:= var("var_1", BoxND([0,0,0], TReal));
+    symvar := var("sym", TPtr(TReal));
+    t := TFCall(TDecl(TDAG([
+           TDAGNode(TTensorI(dft(szcube,sign),nbatch,_wr,_rd), Y,X),
+                  ]),
+            [var_1]
+            ),
+        rec(fname:=name, params:= [symvar])
+    );
+
+    opts := conf.getOpts(t);
+    if not IsBound ( libdir ) then
+        libdir := "srcs";
+    fi;
+
+    ##  We need the Spiral functions wrapped in 'extern C' for adding to a library
+    opts.wrapCFuncs := true;
+    tt := opts.tagIt(t);
+    if(IsBound(fftx_includes)) then opts.includes:=fftx_includes; fi;
+    c := opts.fftxGen(tt);
+    ##  opts.prettyPrint(c);
+    PrintTo ( libdir::"/"::name::file_suffix, opts.prettyPrint(c) );
+fi;
+
+##  If the variable createJIT is defined and set true then output the JIT code to a file
+if ( IsBound(createJIT) and createJIT ) then
+    cachedir := GetEnv("FFTX_HOME");
+    if (cachedir = "") then cachedir := "../.."; fi;
+    cachedir := cachedir::"/cache_jit_files/";
+    if ( codefor = "HIP" ) then PrintTo ( cachedir::jitname, PrintHIPJIT ( c, opts ) ); fi;
+    if ( codefor = "CUDA" ) then PrintTo ( cachedir::jitname, PrintJIT2 ( c, opts ) ); fi;
+    if ( codefor = "CPU" ) then PrintTo ( cachedir::jitname, opts.prettyPrint ( c ) ); fi;
+fi;
@@ -0,0 +1,91 @@
+
+##  Copyright (c) 2018-2022, Carnegie Mellon University
+##  See LICENSE for details
+
+# Pruned 3D complex DFTs
+
+##  Script to generate code, will be driven by a size specification and will write the
+##  CUDA/HIP/CPU code to a file.  The forward transform computes the output only on the
+##  low corner [0, n/2) in each dimension; the inverse reads its input only on that box
+##  and treats the rest as zero.
+
+Load(fftx);
+ImportAll(fftx);
+ImportAll(simt);
+
+##  If the variable createJIT is defined and set true then load the jit module
+if ( IsBound(createJIT) and createJIT ) then
+    Load(jit);
+    Import(jit);
+fi;
+
+if codefor = "CUDA" then
+    conf := LocalConfig.fftx.confGPU();
+elif codefor = "HIP" then
+    conf := FFTXGlobals.defaultHIPConf();
+elif codefor = "CPU" then
+    conf := LocalConfig.fftx.defaultConf();
+fi;
+
+if fwd then
+    prefix := "fftx_pmddft_";
+    jitpref := "cache_pmddft_";
+    sign   := -1;
+else
+    prefix := "fftx_ipmddft_";
+    jitpref := "cache_ipmddft_";
+    sign   := 1;
+fi;
+
+if 1 = 1 then
+    name := prefix::StringInt(szcube[1])::ApplyFunc(ConcatenationString, List(Drop(szcube, 1), s->"x"::StringInt(s)));
+    name := name::"_"::codefor;
+    jitname := jitpref::StringInt(szcube[1])::ApplyFunc(ConcatenationString, List(Drop(szcube, 1), s->"x"::StringInt(s)));
+    jitname := jitname::"_"::codefor::".txt";
+    
+    PrintLine("fftx_pmddft-frame: name = ", name, ", cube = ", szcube, ", jitname = ", jitname, ";\t\t##PICKME##");
+
+    szpruned := List(szcube, s->Int(s/2));
+    ranges := List(szpruned, s->[0..s-1]);
+    var_2:= X;
+    var_3:= Y;
+    symvar := var("sym", TPtr(TReal));
+    ##  one node, so the box is gathered or scattered in the first or last stage
+    ##  of the DFT and no full-size temporary is kept
+    if fwd then
+        ##  full input, output on the low corner only
+        xfm := TCompose([ExtractBox(szcube, ranges), TTensorI(MDDFT(szcube,sign),1,APar, APar)]);
+    else
+        ##  input on the low corner only, full output
+        xfm := TCompose([TTensorI(MDDFT(szcube,sign),1,APar, APar), ZeroEmbedBox(szcube, ranges)]);
+    fi;
+    dag := [
+        TDAGNode(xfm, var_3,var_2),
+    ];
+    t := TFCall(TDecl(TDAG(dag), []),
+        rec(fname:=name, params:= [symvar])
+    );
+    
+    opts := conf.getOpts(t);
+    if not IsBound ( libdir ) then
+        libdir := "srcs";
+    fi;
+
+    ##  We need the Spiral functions wrapped in 'extern C' for adding to a library
+    opts.wrapCFuncs := true;
+    tt := opts.tagIt(t);
+    if(IsBound(fftx_includes)) then opts.includes:=fftx_includes; fi;
+    c := opts.fftxGen(tt);
+    ##  opts.prettyPrint(c);
+    PrintTo(libdir::"/"::name::file_suffix, opts.prettyPrint(c));
+
+    ##  If the variable createJIT is defined and set true then output the JIT code to a file
+    if ( IsBound(createJIT) and createJIT ) then
+	cachedir := GetEnv("FFTX_HOME");
+	if (cachedir = "") then cachedir := "../.."; fi;
+        cachedir := cachedir::"/cache_jit_files/";
+        if ( codefor = "HIP" ) then PrintTo ( cachedir::jitname, PrintHIPJIT ( c, opts ) ); fi;
+        if ( codefor = "CUDA" ) then PrintTo ( cachedir::jitname, PrintJIT2 ( c, opts ) ); fi;
+        if ( codefor = "CPU" ) then PrintTo ( cachedir::jitname, opts.prettyPrint ( c ) ); fi;
+    fi;
+fi;
@@ -56,6 +56,7 @@ SP_TRANSFORM_MDDFT      = 'MDDFT'
 SP_TRANSFORM_MDRCONV    = 'MDRCONV'
 SP_TRANSFORM_MDRFSCONV  = 'MDRFSCONV'
 SP_TRANSFORM_MDPRDFT    = 'MDPRDFT'
+SP_TRANSFORM_BATMDPRDFT = 'BATMDPRDFT'
 SP_TRANSFORM_UNKNOWN    = 'UNKNOWN'
 
 SP_KEY_BATCHSIZE        = 'BatchSize'
@@ -103,6 +104,19 @@ if re.match ( '^.*_.*_', _file_stem ):
     _xform_name = _xform_name + '_'
     _xform_pref = _xform_pref + '_'
 
+##  Batches of 3D transforms are keyed by point_t<6>: { x, y, z, #batches, read stride, write stride }
+_npts = 4
+if _xform_root == 'mddftbat':
+    _npts = 6
+    _xform_sp_type = SP_TRANSFORM_BATMDDFT
+elif _xform_root == 'mdprdftbat':
+    _npts = 6
+    _xform_sp_type = SP_TRANSFORM_BATMDPRDFT
+
+_pt     = 'fftx::point_t<' + str ( _npts ) + '>'
+_sztab  = 'AllSizes' + str ( _npts ) + '_'
+_rszcpy = '    ' + '  '.join ( [ 'rsz[' + str(i) + '] = req[' + str(i) + '];' for i in range ( _npts ) ] ) + '\n'
+
 _orig_file_stem = _file_stem
 
 _sizesfil = sys.argv[2]
@@ -196,6 +210,7 @@ def start_header_file ( type, codefor ):
 
 ##  When generating batch FFT we have 4 parameters: length, # batches, read-stride and write-stride types.
 ##  Use point_t<4> to hold the arguments (length, nbatch, read-stride and write-stride).
+##  Batches of 3D transforms use point_t<6> (x, y, z, nbatch, read-stride and write-stride).
 
 def body_public_header ( codefor ):
     "Add the body details for the public header file"
@@ -203,17 +218,17 @@ def body_public_header ( codefor ):
     _str =        '//  Query the list of sizes available from the library; returns a pointer to an\n'
     _str = _str + '//  array of length N + 1, where N is the number of unique instances of the\n'
     _str = _str + '//  transform in the library.  Each element is a struct of type\n'
-    _str = _str + '//  fftx::point_t<4> specifying FFT length, # batches, read-stride type and write-stride type\n\n'
+    _str = _str + '//  ' + _pt + ' specifying FFT size, # batches, read-stride type and write-stride type\n\n'
 
-    _str = _str + 'fftx::point_t<4> * ' + _file_stem + codefor + 'QuerySizes ();\n'
+    _str = _str + _pt + ' * ' + _file_stem + codefor + 'QuerySizes ();\n'
     _str = _str + '#define ' + _file_stem + 'QuerySizes ' + _file_stem + codefor + 'QuerySizes\n\n'
 
     _str = _str + '//  Run an ' + _file_stem + ' transform once: run the init functions, run the,\n'
     _str = _str + '//  transform and finally tear down by calling the destroy function.\n'
-    _str = _str + '//  Accepts fftx::point_t<4> specifying size, and pointers to the output\n'
+    _str = _str + '//  Accepts ' + _pt + ' specifying size, and pointers to the output\n'
     _str = _str + '//  (returned) data and the input data.\n\n'
 
-    _str = _str + 'void ' + _file_stem + codefor + 'Run ( fftx::point_t<4> req, double * output, double * input );\n'
+    _str = _str + 'void ' + _file_stem + codefor + 'Run ( ' + _pt + ' req, double * output, double * input );\n'
     _str = _str + '#define ' + _file_stem + 'Run ' + _file_stem + codefor + 'Run\n\n'
 
     _str = _str + '//  Get a transform tuple -- a set of pointers to the init, destroy, and run\n'
@@ -221,7 +236,7 @@ def body_public_header ( codefor ):
     _str = _str + '//  information the user may call the init function to setup for the transform,\n'
     _str = _str + '//  then run the transform repeatedly, and finally tear down (using destroy function).\n\n'
 
-    _str = _str + 'transformTuple_t * ' + _file_stem + codefor + 'Tuple ( fftx::point_t<4> req );\n'
+    _str = _str + 'transformTuple_t * ' + _file_stem + codefor + 'Tuple ( ' + _pt + ' req );\n'
     _str = _str + '#define ' + _file_stem + 'Tuple ' + _file_stem + codefor + 'Tuple\n\n'
 
     _str = _str + '//  The metadata table is compiled into the library (and thus readable by scanning file,\n'
@@ -263,14 +278,14 @@ def library_api ( mkvers, decor, type ):
         _str = _str + '#define checkLastHipError(str)   { hipError_t err = hipGetLastError();   if (err != hipSuccess) {  printf("%s(%i) : %s: %s\\n", __FILE__, __LINE__, (str), hipGetErrorString(err) );  /* exit(-1); */ } }\n\n'
 
     _str = _str + '//  Query the list of sizes available from the library; returns a pointer to an\n'
-    _str = _str + '//  array of size <N+1>, each element is a struct of type fftx::point_t<4> specifying\n'
+    _str = _str + '//  array of size <N+1>, each element is a struct of type ' + _pt + ' specifying\n'
     _str = _str + '//  the number of batches and the transform dimension.  The final entry in the list\n'
     _str = _str + '//  is a zero entry.\n\n'
 
-    _str = _str + 'fftx::point_t<4> * ' + _file_stem + decor + 'QuerySizes ()\n{\n'
-    _str = _str + '    fftx::point_t<4> *wp = (fftx::point_t<4> *) malloc ( sizeof ( AllSizes4_' + type + ' ) );\n'
+    _str = _str + _pt + ' * ' + _file_stem + decor + 'QuerySizes ()\n{\n'
+    _str = _str + '    ' + _pt + ' *wp = (' + _pt + ' *) malloc ( sizeof ( ' + _sztab + type + ' ) );\n'
     _str = _str + '    if ( wp != NULL)\n'
-    _str = _str + '        memcpy ( (void *) wp, (const void *) AllSizes4_' + type + ', sizeof ( AllSizes4_' + type + ' ) );\n\n'
+    _str = _str + '        memcpy ( (void *) wp, (const void *) ' + _sztab + type + ', sizeof ( ' + _sztab + type + ' ) );\n\n'
     _str = _str + '    return wp;\n'
     _str = _str + '}\n\n'
 
@@ -280,17 +295,15 @@ def library_api ( mkvers, decor, type ):
     _str = _str + '//  then run the transform repeatedly, and finally tear down (using the destroy\n'
     _str = _str + '//  function).  Returns NULL if requested size is not found\n\n'
 
-    _str = _str + 'transformTuple_t * ' + _file_stem + decor + 'Tuple ( fftx::point_t<4> req )\n'
+    _str = _str + 'transformTuple_t * ' + _file_stem + decor + 'Tuple ( ' + _pt + ' req )\n'
     _str = _str + '{\n'
     _str = _str + '    int indx;\n'
-    _str = _str + '    int numentries = sizeof ( AllSizes4_' + type + ' ) / sizeof ( fftx::point_t<4> ) - 1;    // last entry is { 0, 0 }\n'
+    _str = _str + '    int numentries = sizeof ( ' + _sztab + type + ' ) / sizeof ( ' + _pt + ' ) - 1;    // last entry is { 0, 0 }\n'
     _str = _str + '    transformTuple_t *wp = NULL;\n\n'
 
     _str = _str + '    for ( indx = 0; indx < numentries; indx++ ) {\n'
-    _str = _str + '        if ( req[0] == AllSizes4_' + type + '[indx][0] &&\n'
-    _str = _str + '             req[1] == AllSizes4_' + type + '[indx][1] &&\n'
-    _str = _str + '             req[2] == AllSizes4_' + type + '[indx][2] &&\n'
-    _str = _str + '             req[3] == AllSizes4_' + type + '[indx][3] ) {\n'
+    _match = [ 'req[' + str(i) + '] == ' + _sztab + type + '[indx][' + str(i) + ']' for i in range ( _npts ) ]
+    _str = _str + '        if ( ' + ' &&\n             '.join ( _match ) + ' ) {\n'
     _str = _str + '            // found a match\n'
     _str = _str + '            wp = (transformTuple_t *) malloc ( sizeof ( transformTuple_t ) );\n'
     _str = _str + '            if ( wp != NULL) {\n'
@@ -305,10 +318,10 @@ def library_api ( mkvers, decor, type ):
 
     _str = _str + '//  Run an ' + _file_stem + ' transform once: run the init functions, run the\n'
     _str = _str + '//  transform and finally tear down by calling the destroy function.\n'
-    _str = _str + '//  Accepts fftx::point_t<4> specifying size, and pointers to the output\n'
+    _str = _str + '//  Accepts ' + _pt + ' specifying size, and pointers to the output\n'
     _str = _str + '//  (returned) data and the input data.\n\n'
 
-    _str = _str + 'void ' + _file_stem + decor + 'Run ( fftx::point_t<4> req, double * output, double * input )\n'
+    _str = _str + 'void ' + _file_stem + decor + 'Run ( ' + _pt + ' req, double * output, double * input )\n'
     _str = _str + '{\n'
     _str = _str + '    transformTuple_t *wp = ' + _file_stem + decor + 'Tuple ( req );\n'
     _str = _str + '    if ( wp == NULL )\n'
@@ -351,8 +364,8 @@ def python_cuda_api ( mkvers, decor, type, xfm ):
 
     _str = _str + 'int  ' + _file_stem + decor + 'python_init_wrapper ( int * req )\n{\n'
     _str = _str + '    //  Get the tuple for the requested size\n'
-    _str = _str + '    fftx::point_t<4> rsz;\n'
-    _str = _str + '    rsz[0] = req[0];  rsz[1] = req[1];  rsz[2] = req[2];  rsz[3] = req[3];\n'
+    _str = _str + '    ' + _pt + ' rsz;\n'
+    _str = _str + _rszcpy
     _str = _str + '    transformTuple_t *wp = ' + _file_stem + decor + 'Tuple ( rsz );\n'
     _str = _str + '    if ( wp == NULL )\n'
     _str = _str + '        //  Requested size not found -- return false\n'
@@ -381,7 +394,8 @@ def python_cuda_api ( mkvers, decor, type, xfm ):
         ##                     nbatch * ((len/2) + 1) * 2 doubles (for R2C, output)
         ##     IPRDFTBAT:      nbatch * ((len/2) + 1) * 2 doubles (for C2R, input)
         ##                     nbatch * len     doubles (for C2R, output)
-        ##  Note: req[0] is FFT length; req[1] is batch size
+        ##     MDDFTBAT etc.:  as above with len = x * y * z (z halved for the complex side)
+        ##  Note: req[0] is FFT length; req[1] is batch size (3D: req[0..2] are x, y, z; req[3] is batch size)
         if xfm == 'dftbat' or xfm == 'idftbat':
             _str = _str + '    int ndoubin  = (int)(req[1] * req[0] * 2);\n'
             _str = _str + '    int ndoubout = (int)(req[1] * req[0] * 2);\n'
@@ -391,6 +405,15 @@ def python_cuda_api ( mkvers, decor, type, xfm ):
         elif xfm == 'iprdftbat':
             _str = _str + '    int ndoubin  = (int)(req[1] * ((int)(req[0]/2) + 1) * 2);\n'
             _str = _str + '    int ndoubout = (int)(req[1] * req[0] );\n'
+        elif xfm == 'mddftbat' or xfm == 'imddftbat':
+            _str = _str + '    int ndoubin  = (int)(req[3] * req[0] * req[1] * req[2] * 2);\n'
+            _str = _str + '    int ndoubout = (int)(req[3] * req[0] * req[1] * req[2] * 2);\n'
+        elif xfm == 'mdprdftbat':
+            _str = _str + '    int ndoubin  = (int)(req[3] * req[0] * req[1] * req[2] );\n'
+            _str = _str + '    int ndoubout = (int)(req[3] * req[0] * req[1] * ((int)(req[2]/2) + 1) * 2);\n'
+        elif xfm == 'imdprdftbat':
+            _str = _str + '    int ndoubin  = (int)(req[3] * req[0] * req[1] * ((int)(req[2]/2) + 1) * 2);\n'
+            _str = _str + '    int ndoubout = (int)(req[3] * req[0] * req[1] * req[2] );\n'
 
         _str = _str + '    if ( ndoubin  == 0 )\n        return 0;\n\n'
         _str = _str + '    ' + _mmalloc + ' ( &dev_in,  sizeof(double) * ndoubin  );\n'
@@ -406,8 +429,8 @@ def python_cuda_api ( mkvers, decor, type, xfm ):
 
     _str = _str + 'void ' + _file_stem + decor + 'python_run_wrapper ( int * req, double * output, double * input )\n{\n'
     _str = _str + '    //  Get the tuple for the requested size\n'
-    _str = _str + '    fftx::point_t<4> rsz;\n'
-    _str = _str + '    rsz[0] = req[0];  rsz[1] = req[1];  rsz[2] = req[2];  rsz[3] = req[3];\n'
+    _str = _str + '    ' + _pt + ' rsz;\n'
+    _str = _str + _rszcpy
     _str = _str + '    transformTuple_t *wp = ' + _file_stem + decor + 'Tuple ( rsz );\n'
     _str = _str + '    if ( wp == NULL )\n'
     _str = _str + '        //  Requested size not found -- just return\n'
@@ -423,6 +446,15 @@ def python_cuda_api ( mkvers, decor, type, xfm ):
         elif xfm == 'iprdftbat':
             _str = _str + '    int ndoubin  = (int)(req[1] * ((int)(req[0]/2) + 1) * 2);\n'
             _str = _str + '    int ndoubout = (int)(req[1] * req[0] );\n'
+        elif xfm == 'mddftbat' or xfm == 'imddftbat':
+            _str = _str + '    int ndoubin  = (int)(req[3] * req[0] * req[1] * req[2] * 2);\n'
+            _str = _str + '    int ndoubout = (int)(req[3] * req[0] * req[1] * req[2] * 2);\n'
+        elif xfm == 'mdprdftbat':
+            _str = _str + '    int ndoubin  = (int)(req[3] * req[0] * req[1] * req[2] );\n'
+            _str = _str + '    int ndoubout = (int)(req[3] * req[0] * req[1] * ((int)(req[2]/2) + 1) * 2);\n'
+        elif xfm == 'imdprdftbat':
+            _str = _str + '    int ndoubin  = (int)(req[3] * req[0] * req[1] * ((int)(req[2]/2) + 1) * 2);\n'
+            _str = _str + '    int ndoubout = (int)(req[3] * req[0] * req[1] * req[2] );\n'
 
         _str = _str + '    if ( ndoubin  == 0 )\n        return;\n\n'
         _str = _str + '    ' + _mmemcpy + ' ( dev_in, input, sizeof(double) * ndoubin, ' + _cph2dev + ' );\n\n'
@@ -439,8 +471,8 @@ def python_cuda_api ( mkvers, decor, type, xfm ):
 
     _str = _str + 'void ' + _file_stem + decor + 'python_destroy_wrapper ( int * req )\n{\n'
     _str = _str + '    //  Get the tuple for the requested size\n'
-    _str = _str + '    fftx::point_t<4> rsz;\n'
-    _str = _str + '    rsz[0] = req[0];  rsz[1] = req[1];  rsz[2] = req[2];  rsz[3] = req[3];\n'
+    _str = _str + '    ' + _pt + ' rsz;\n'
+    _str = _str + _rszcpy
     _str = _str + '    transformTuple_t *wp = ' + _file_stem + decor + 'Tuple ( rsz );\n'
     _str = _str + '    if ( wp == NULL )\n'
     _str = _str + '        //  Requested size not found -- just return\n'
@@ -533,8 +565,8 @@ def cmake_library ( decor, type ):
 
 
 _extern_decls  = ''
-_all_sizes     = '//  Entries in AllSizes4 table:  { FFT length, #batches, read stride type, write stride type },\n\n'
-_all_sizes    += 'static fftx::point_t<4> AllSizes4_' + _code_type + '[] = {\n'
+_all_sizes     = '//  Entries in ' + _sztab[:-1] + ' table:  { FFT size, #batches, read stride type, write stride type },\n\n'
+_all_sizes    += 'static ' + _pt + ' ' + _sztab + _code_type + '[] = {\n'
 _tuple_funcs   = 'static transformTuple_t ' + _file_stem + _code_type + '_Tuples[] = {\n'
 
 _metadata      = 'static char ' + _file_stem + 'MetaData[] = \"' + SP_METADATA_START + '\\\n{\\\n'
@@ -570,6 +602,12 @@ with open ( _sizesfil, 'r' ) as fil:
         segs = re.split ( ';', line )                   ## expect 4 segments
         _dims = re.split ( '=', segs[0] )
         _nsize = _dims[1]
+        _nlist = _nsize
+        if _npts == 6:
+            ##  3D batches give szcube := [x,y,z]
+            _nlist = re.sub ( '[\[\]]', '', _nsize )
+            _nsize = re.sub ( ',', 'x', _nlist )
+            _nlist = re.sub ( ',', ', ', _nlist )
 
         _dims = re.split ( '=', segs[1] )
         _nbat = _dims[1]
@@ -580,6 +618,10 @@ with open ( _sizesfil, 'r' ) as fil:
         _dims = re.split ( '=', segs[3] )
         _wrstridetype = _dims[1]
 
+        ##  real 3D batches are only generated for contiguous cubes
+        if re.match ( 'i?mdprdftbat', _xform_root ) and ( _rdstridetype != 'APar' or _wrstridetype != 'APar' ):
+            continue
+
         ##  Assume gap file is named {_orig_file_stem}-frame.g
         ##  Generate the SPIRAL script: cat testscript_$pid.g & {transform}-frame.g
         _frame_file = re.sub ( '_$', '', _orig_file_stem ) + '-frame' + '.g'
@@ -632,11 +674,11 @@ with open ( _sizesfil, 'r' ) as fil:
             ##  Identify transform by FFT len, # batches, read stride type and write stride type
             _rd = 0 if _rdstridetype == 'APar' else 1
             _wr = 0 if _wrstridetype == 'APar' else 1
-            _all_sizes = _all_sizes + '    { ' + _nsize + ', ' + _nbat + ', ' + str(_rd) + ', ' + str(_wr) + ' },\n'
+            _all_sizes = _all_sizes + '    { ' + _nlist + ', ' + _nbat + ', ' + str(_rd) + ', ' + str(_wr) + ' },\n'
             _tuple_funcs = _tuple_funcs + '    { init_' + _func_stem + ', destroy_' + _func_stem + ', '
             _tuple_funcs = _tuple_funcs + _func_stem + ' },\n'
 
-            _metadata += '        {    \\"' + SP_KEY_DIMENSIONS + '\\": [ ' + _nsize + ' ],\\\n'
+            _metadata += '        {    \\"' + SP_KEY_DIMENSIONS + '\\": [ ' + _nlist + ' ],\\\n'
             _metadata += '             \\"' + SP_KEY_BATCHSIZE + '\\": ' + _nbat + ',\\\n'
             _metadata += '             \\"' + SP_KEY_DIRECTION + '\\": \\"'
             if _fwd == 'true':
@@ -678,7 +720,7 @@ with open ( _sizesfil, 'r' ) as fil:
     _header_fil.write ( _filebody )
     _header_fil.write ( _extern_decls )
     _header_fil.write ( _tuple_funcs + '    { NULL, NULL, NULL }\n};\n\n' )
-    _header_fil.write ( _all_sizes + '    { 0, 0, 0, 0 }\n};\n\n' )
+    _header_fil.write ( _all_sizes + '    { ' + ', '.join ( [ '0' ] * _npts ) + ' }\n};\n\n' )
     _header_fil.write ( '#endif\n\n' )
     _header_fil.close ()
 
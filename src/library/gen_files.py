@@ -54,6 +54,7 @@ SP_TRANSFORM_MDDFT      = 'MDDFT'
 SP_TRANSFORM_MDRCONV    = 'MDRCONV'
 SP_TRANSFORM_MDRFSCONV  = 'MDRFSCONV'
 SP_TRANSFORM_MDPRDFT    = 'MDPRDFT'
+SP_TRANSFORM_RESAMPLE   = 'RESAMPLE'
 SP_TRANSFORM_UNKNOWN    = 'UNKNOWN'
 
 SP_KEY_BATCHSIZE        = 'BatchSize'
@@ -100,6 +101,8 @@ if re.match ( '^.*_.*_', _file_stem ):
     _xform_pref = _xform_pref + '_'
     if _xform_name == 'rconv':
         _xform_sw_type = SP_TRANSFORM_MDRCONV
+    elif _xform_name == 'resample':
+        _xform_sw_type = SP_TRANSFORM_RESAMPLE
     else:
         _xform_sw_type = _xform_name.upper()
 
@@ -402,15 +405,31 @@ def python_cuda_api ( mkvers, decor, type, xfm ):
         ##                     x * y * ((z/2) + 1) * 2 doubles (for R2C, output)
         ##     IMDPRDFT:       x * y * ((z/2) + 1) * 2 doubles (for C2R, input)
         ##                     x * y * z     doubles (for C2R, output)
+        ##     PMDDFT:         x * y * z * 2 doubles (input), (x/2) * (y/2) * (z/2) * 2 (output)
+        ##     IPMDDFT:        (x/2) * (y/2) * (z/2) * 2 doubles (input), x * y * z * 2 (output)
+        ##     RESAMPLE:       (x/2) * (y/2) * (z/2) doubles (input), x * y * z (output)
+        ##     MDDCT/MDDST:    x * y * z     doubles (real to real, both input & output)
         if xfm == 'mddft' or xfm == 'imddft':
             _str = _str + '    int ndoubin  = (int)(req[0] * req[1] * req[2] * 2);\n'
             _str = _str + '    int ndoubout = (int)(req[0] * req[1] * req[2] * 2);\n'
         elif xfm == 'mdprdft':
             _str = _str + '    int ndoubin  = (int)(req[0] * req[1] * req[2] );\n'
             _str = _str + '    int ndoubout = (int)(req[0] * req[1] * ((int)(req[2]/2) + 1) * 2);\n'
-        elif xfm == 'imdprdft' or xfm == 'rconv':
+        elif xfm == 'imdprdft' or xfm == 'rconv' or xfm == 'rconvc':
             _str = _str + '    int ndoubin  = (int)(req[0] * req[1] * ((int)(req[2]/2) + 1) * 2);\n'
             _str = _str + '    int ndoubout = (int)(req[0] * req[1] * req[2] );\n'
+        elif xfm == 'pmddft':
+            _str = _str + '    int ndoubin  = (int)(req[0] * req[1] * req[2] * 2);\n'
+            _str = _str + '    int ndoubout = (int)((req[0]/2) * (req[1]/2) * (req[2]/2) * 2);\n'
+        elif xfm == 'ipmddft':
+            _str = _str + '    int ndoubin  = (int)((req[0]/2) * (req[1]/2) * (req[2]/2) * 2);\n'
+            _str = _str + '    int ndoubout = (int)(req[0] * req[1] * req[2] * 2);\n'
+        elif xfm == 'resample':
+            _str = _str + '    int ndoubin  = (int)((req[0]/2) * (req[1]/2) * (req[2]/2));\n'
+            _str = _str + '    int ndoubout = (int)(req[0] * req[1] * req[2]);\n'
+        elif re.match ( 'i?mdd[cs]t1?$', xfm ):
+            _str = _str + '    int ndoubin  = (int)(req[0] * req[1] * req[2]);\n'
+            _str = _str + '    int ndoubout = (int)(req[0] * req[1] * req[2]);\n'
         elif xfm == 'psatd':
             _str = _str + '    int ndoubin  = (int)(req[0] * req[1] * req[2] );\n'
             _str = _str + '    int ndoubout = (int)(req[0] * req[1] * ((int)(req[2]/2) + 1) * 2);\n'
@@ -449,9 +468,21 @@ def python_cuda_api ( mkvers, decor, type, xfm ):
         elif xfm == 'mdprdft':
             _str = _str + '    int ndoubin  = (int)(req[0] * req[1] * req[2] );\n'
             _str = _str + '    int ndoubout = (int)(req[0] * req[1] * ((int)(req[2]/2) + 1) * 2);\n'
-        elif xfm == 'imdprdft' or xfm == 'rconv':
+        elif xfm == 'imdprdft' or xfm == 'rconv' or xfm == 'rconvc':
             _str = _str + '    int ndoubin  = (int)(req[0] * req[1] * ((int)(req[2]/2) + 1) * 2);\n'
             _str = _str + '    int ndoubout = (int)(req[0] * req[1] * req[2] );\n'
+        elif xfm == 'pmddft':
+            _str = _str + '    int ndoubin  = (int)(req[0] * req[1] * req[2] * 2);\n'
+            _str = _str + '    int ndoubout = (int)((req[0]/2) * (req[1]/2) * (req[2]/2) * 2);\n'
+        elif xfm == 'ipmddft':
+            _str = _str + '    int ndoubin  = (int)((req[0]/2) * (req[1]/2) * (req[2]/2) * 2);\n'
+            _str = _str + '    int ndoubout = (int)(req[0] * req[1] * req[2] * 2);\n'
+        elif xfm == 'resample':
+            _str = _str + '    int ndoubin  = (int)((req[0]/2) * (req[1]/2) * (req[2]/2));\n'
+            _str = _str + '    int ndoubout = (int)(req[0] * req[1] * req[2]);\n'
+        elif re.match ( 'i?mdd[cs]t1?$', xfm ):
+            _str = _str + '    int ndoubin  = (int)(req[0] * req[1] * req[2]);\n'
+            _str = _str + '    int ndoubout = (int)(req[0] * req[1] * req[2]);\n'
         elif xfm == 'psatd':
             _str = _str + '    int ndoubin  = (int)(req[0] * req[1] * req[2] );\n'
             _str = _str + '    int ndoubout = (int)(req[0] * req[1] * ((int)(req[2]/2) + 1) * 2);\n'
@@ -618,6 +649,10 @@ with open ( _sizesfil, 'r' ) as fil:
         if re.match ( 'rconv', _xform_root ) and _code_type == 'CPU' and int ( _dimx ) > 260:
             continue
 
+        ##  the pruned box (or the coarse grid, for resample) is half the cube in each dimension
+        if re.match ( 'i?pmddft|resample', _xform_root ) and ( int ( _dimx ) % 2 or int ( _dimy ) % 2 or int ( _dimz ) % 2 ):
+            continue
+
         ##  Assume gap file is named {_orig_file_stem}-frame.g
         ##  Generate the SPIRAL script: cat testscript_$pid.g & {transform}-frame.g
         _frame_file = re.sub ( '_$', '', _orig_file_stem ) + '-frame' + '.g'
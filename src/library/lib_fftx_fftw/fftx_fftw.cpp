@@ -0,0 +1,268 @@
+#include <complex>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <chrono>
+#include <vector>
+#include <iostream>
+
+#include "fftx_fftw3.h"
+#include "interface.hpp"
+#include "fftxfft.hpp"
+
+using namespace std;
+using fftx_cuFFT::fftxPlanKernel;
+
+// timed runs of each candidate under FFTW_MEASURE.
+#define FFTX_FFTW_TRIALS 3
+
+enum fftx_fftw_kind { FFTX_FFTW_C2C, FFTX_FFTW_R2C, FFTX_FFTW_C2R };
+
+struct fftw_plan_s {
+  fftxPlanKernel kernel;
+  vector<int> sizes;
+  fftx_fftw_kind kind;
+  void *in;
+  void *out;
+  // complex output of an in-place transform, copied back after the run.
+  vector<complex<double>> scratch;
+  // strided output leaves elements between the arrays untouched.
+  bool gaps;
+  complex<double> sym[1];
+};
+
+static void fftx_fftw_run(fftw_plan p, fftxPlanKernel &k, void *in, void *out) {
+  if (in != out) {
+    fftx_cuFFT::fftxPlanRun(k, out, in, p->sym);
+    return;
+  }
+  if (p->gaps)
+    memcpy(p->scratch.data(), out, p->scratch.size() * sizeof(complex<double>));
+  fftx_cuFFT::fftxPlanRun(k, p->scratch.data(), in, p->sym);
+  memcpy(out, p->scratch.data(), p->scratch.size() * sizeof(complex<double>));
+}
+
+// fastest of a few runs of k on the plan's arrays, in ms.
+static double fftx_fftw_time(fftw_plan p, fftxPlanKernel &k) {
+  double best = 0.0;
+  for (int i = 0; i < FFTX_FFTW_TRIALS; i++) {
+    auto start = chrono::high_resolution_clock::now();
+    fftx_fftw_run(p, k, p->in, p->out);
+    chrono::duration<double, milli> t = chrono::high_resolution_clock::now() - start;
+    if (i == 0 || t.count() < best)
+      best = t.count();
+  }
+  return best;
+}
+
+// the fixed-size library against code generated for this plan; keeps the faster.
+// releasing the library kernel only drops this plan's use of it, so other plans
+// of the same size keep it initialized.
+static void fftx_fftw_tune(fftw_plan p) {
+  fftx_cuFFT::fftxPlanPrepare(p->kernel, p->sizes);
+  if (p->kernel.tupl == nullptr || p->in == nullptr || p->out == nullptr)
+    return;
+  fftxPlanKernel rtc;
+  rtc.name = p->kernel.name;
+  fftx_cuFFT::fftxPlanPrepare(rtc, p->sizes, false);
+  double tlib = fftx_fftw_time(p, p->kernel);
+  double trtc = fftx_fftw_time(p, rtc);
+  if (DEBUGOUT)
+    cout << "fftx_fftw: " << p->kernel.name << " library " << tlib << " ms, generated " << trtc << " ms" << endl;
+  if (trtc < tlib) {
+    fftx_cuFFT::fftxPlanRelease(p->kernel);
+    p->kernel = rtc;
+  }
+  else {
+    fftx_cuFFT::fftxPlanRelease(rtc);
+  }
+}
+
+static fftw_plan fftx_fftw_plan(
+  fftx_fftw_kind kind, int rank, const int *n, int howmany,
+  void *in, const int *inembed, int istride, int idist,
+  void *out, const int *onembed, int ostride, int odist,
+  int sign, unsigned flags
+) {
+  if ((rank != 1 && rank != 3) || (rank == 1 && kind != FFTX_FFTW_C2C) || howmany < 1) {
+    fprintf(stderr, "fftx_fftw: only complex 1D and 3D transforms, or real 3D transforms, are supported\n");
+    return NULL;
+  }
+  if (sign != FFTW_FORWARD && sign != FFTW_BACKWARD)
+    return NULL;
+  if (kind != FFTX_FFTW_C2C && in != NULL && in == out) {
+    fprintf(stderr, "fftx_fftw: in-place real transforms are not supported\n");
+    return NULL;
+  }
+
+  // the complex side of a real transform keeps n[2]/2 + 1 in the last dimension.
+  fftw_plan p = new fftw_plan_s;
+  p->kind = kind;
+  p->in = in;
+  p->out = out;
+  p->gaps = false;
+  string bat = (howmany > 1) ? "bat" : "";
+  // complex elements up to the last output element, for in-place runs.
+  size_t extent = (size_t) n[0] * howmany;
+  if (rank == 1) {
+    BatchLayout layout;
+    layout.istride = istride;
+    layout.idist = idist;
+    layout.ostride = ostride;
+    layout.odist = odist;
+    p->sizes = batchLayoutSizes(n[0], howmany, layout);
+    if (p->sizes.empty()) {
+      fprintf(stderr, "fftx_fftw: the arrays of a batch overlap\n");
+      delete p;
+      return NULL;
+    }
+    p->kernel.name = (sign == FFTW_FORWARD) ? "b1dft" : "ib1dft";
+    if (p->sizes.size() > 4) {
+      extent = (size_t) (howmany-1) * p->sizes[7] + (size_t) (n[0]-1) * p->sizes[6] + 1;
+      p->gaps = true;
+    }
+  }
+  else {
+    int full[3] = {n[0], n[1], n[2]};
+    int half[3] = {n[0], n[1], n[2]/2 + 1};
+    int read = fftx_cuFFT::fftxPlanLayout(3, inembed, kind == FFTX_FFTW_C2R ? half : full, istride, idist, howmany);
+    int write = fftx_cuFFT::fftxPlanLayout(3, onembed, kind == FFTX_FFTW_R2C ? half : full, ostride, odist, howmany);
+    if (read < 0 || write < 0 || (kind != FFTX_FFTW_C2C && (read != 0 || write != 0))) {
+      fprintf(stderr, "fftx_fftw: 3D arrays must be contiguous, or interleaved for complex batches\n");
+      delete p;
+      return NULL;
+    }
+    extent = (size_t) n[0] * n[1] * n[2] * howmany;
+    if (kind == FFTX_FFTW_C2C)
+      p->kernel.name = ((sign == FFTW_FORWARD) ? "mddft" : "imddft") + bat;
+    else
+      p->kernel.name = ((kind == FFTX_FFTW_R2C) ? "mdprdft" : "imdprdft") + bat;
+    p->sizes = {n[0], n[1], n[2]};
+    if (howmany > 1)
+      p->sizes.insert(p->sizes.end(), {howmany, read, write});
+  }
+  if (kind == FFTX_FFTW_C2C)
+    p->scratch.resize(extent);
+
+  if (flags & FFTW_WISDOM_ONLY) {
+    // only the fixed-size library counts as wisdom; the probe is a copy.
+    transformTuple_t *tupl = getLibTransform(p->kernel.name, p->sizes);
+    if (tupl == nullptr) {
+      delete p;
+      return NULL;
+    }
+    free(tupl);
+    fftx_cuFFT::fftxPlanPrepare(p->kernel, p->sizes);
+  }
+  else if (flags & FFTW_ESTIMATE) {
+    fftx_cuFFT::fftxPlanPrepare(p->kernel, p->sizes);
+  }
+  else {
+    fftx_fftw_tune(p);
+  }
+  return p;
+}
+
+extern "C" {
+
+fftw_plan fftw_plan_many_dft(int rank, const int *n, int howmany,
+                             fftw_complex *in, const int *inembed, int istride, int idist,
+                             fftw_complex *out, const int *onembed, int ostride, int odist,
+                             int sign, unsigned flags) {
+  return fftx_fftw_plan(FFTX_FFTW_C2C, rank, n, howmany, in, inembed, istride, idist,
+                        out, onembed, ostride, odist, sign, flags);
+}
+
+fftw_plan fftw_plan_dft(int rank, const int *n, fftw_complex *in, fftw_complex *out, int sign, unsigned flags) {
+  return fftw_plan_many_dft(rank, n, 1, in, NULL, 1, 0, out, NULL, 1, 0, sign, flags);
+}
+
+fftw_plan fftw_plan_dft_1d(int n, fftw_complex *in, fftw_complex *out, int sign, unsigned flags) {
+  return fftw_plan_dft(1, &n, in, out, sign, flags);
+}
+
+fftw_plan fftw_plan_dft_3d(int n0, int n1, int n2, fftw_complex *in, fftw_complex *out, int sign, unsigned flags) {
+  int n[3] = {n0, n1, n2};
+  return fftw_plan_dft(3, n, in, out, sign, flags);
+}
+
+fftw_plan fftw_plan_many_dft_r2c(int rank, const int *n, int howmany,
+                                 double *in, const int *inembed, int istride, int idist,
+                                 fftw_complex *out, const int *onembed, int ostride, int odist,
+                                 unsigned flags) {
+  return fftx_fftw_plan(FFTX_FFTW_R2C, rank, n, howmany, in, inembed, istride, idist,
+                        out, onembed, ostride, odist, FFTW_FORWARD, flags);
+}
+
+fftw_plan fftw_plan_many_dft_c2r(int rank, const int *n, int howmany,
+                                 fftw_complex *in, const int *inembed, int istride, int idist,
+                                 double *out, const int *onembed, int ostride, int odist,
+                                 unsigned flags) {
+  return fftx_fftw_plan(FFTX_FFTW_C2R, rank, n, howmany, in, inembed, istride, idist,
+                        out, onembed, ostride, odist, FFTW_BACKWARD, flags);
+}
+
+fftw_plan fftw_plan_dft_r2c_3d(int n0, int n1, int n2, double *in, fftw_complex *out, unsigned flags) {
+  int n[3] = {n0, n1, n2};
+  return fftw_plan_many_dft_r2c(3, n, 1, in, NULL, 1, 0, out, NULL, 1, 0, flags);
+}
+
+fftw_plan fftw_plan_dft_c2r_3d(int n0, int n1, int n2, fftw_complex *in, double *out, unsigned flags) {
+  int n[3] = {n0, n1, n2};
+  return fftw_plan_many_dft_c2r(3, n, 1, in, NULL, 1, 0, out, NULL, 1, 0, flags);
+}
+
+void fftw_execute(const fftw_plan p) {
+  fftx_fftw_run(p, p->kernel, p->in, p->out);
+}
+
+void fftw_execute_dft(const fftw_plan p, fftw_complex *in, fftw_complex *out) {
+  fftx_fftw_run(p, p->kernel, in, out);
+}
+
+void fftw_execute_dft_r2c(const fftw_plan p, double *in, fftw_complex *out) {
+  fftx_fftw_run(p, p->kernel, in, out);
+}
+
+void fftw_execute_dft_c2r(const fftw_plan p, fftw_complex *in, double *out) {
+  fftx_fftw_run(p, p->kernel, in, out);
+}
+
+void fftw_destroy_plan(fftw_plan p) {
+  if (p == NULL)
+    return;
+  fftx_cuFFT::fftxPlanRelease(p->kernel);
+  delete p;
+}
+
+void *fftw_malloc(size_t n) {
+#if defined(_WIN32) || defined (_WIN64)
+  return _aligned_malloc(n, 64);
+#else
+  void *p = NULL;
+  if (posix_memalign(&p, 64, n) != 0)
+    return NULL;
+  return p;
+#endif
+}
+
+void fftw_free(void *p) {
+#if defined(_WIN32) || defined (_WIN64)
+  _aligned_free(p);
+#else
+  free(p);
+#endif
+}
+
+double *fftw_alloc_real(size_t n) {
+  return (double *) fftw_malloc(n * sizeof(double));
+}
+
+fftw_complex *fftw_alloc_complex(size_t n) {
+  return (fftw_complex *) fftw_malloc(n * sizeof(fftw_complex));
+}
+
+void fftw_cleanup(void) {
+}
+
+}
@@ -0,0 +1,80 @@
+#ifndef FFTX_FFTW3_H
+#define FFTX_FFTW3_H
+
+//  Copyright (c) 2018-2022, Carnegie Mellon University
+//  See LICENSE for details
+
+// The double-precision FFTW3 entry points most codes use, computed by FFTX on
+// the host. Types and constants match fftw3.h, so code built against FFTW
+// relinks against fftx_fftw unchanged.
+//
+// Supported: complex 1D (batched, from the dftbat libraries) and complex,
+// real-to-complex and complex-to-real 3D (single or batched) transforms. 1D
+// batches may use any strides and distances that keep the arrays apart; 3D
+// batches must be contiguous, or interleaved element by element for complex
+// transforms, and a single 3D array must have stride 1. Planning anything else
+// returns NULL.
+//
+// FFTW_ESTIMATE takes the fixed-size library if it has the size, else code
+// generated at run time. FFTW_MEASURE (the default) and above time both and
+// keep the faster, overwriting in and out as FFTW does. FFTW_WISDOM_ONLY
+// takes the library only, and returns NULL if it does not have the size.
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef double fftw_complex[2];
+typedef struct fftw_plan_s *fftw_plan;
+
+#define FFTW_FORWARD (-1)
+#define FFTW_BACKWARD (+1)
+
+#define FFTW_MEASURE (0U)
+#define FFTW_DESTROY_INPUT (1U << 0)
+#define FFTW_UNALIGNED (1U << 1)
+#define FFTW_CONSERVE_MEMORY (1U << 2)
+#define FFTW_EXHAUSTIVE (1U << 3)
+#define FFTW_PRESERVE_INPUT (1U << 4)
+#define FFTW_PATIENT (1U << 5)
+#define FFTW_ESTIMATE (1U << 6)
+#define FFTW_WISDOM_ONLY (1U << 21)
+
+fftw_plan fftw_plan_dft_1d(int n, fftw_complex *in, fftw_complex *out, int sign, unsigned flags);
+fftw_plan fftw_plan_dft_3d(int n0, int n1, int n2, fftw_complex *in, fftw_complex *out, int sign, unsigned flags);
+fftw_plan fftw_plan_dft(int rank, const int *n, fftw_complex *in, fftw_complex *out, int sign, unsigned flags);
+fftw_plan fftw_plan_many_dft(int rank, const int *n, int howmany,
+                             fftw_complex *in, const int *inembed, int istride, int idist,
+                             fftw_complex *out, const int *onembed, int ostride, int odist,
+                             int sign, unsigned flags);
+
+fftw_plan fftw_plan_dft_r2c_3d(int n0, int n1, int n2, double *in, fftw_complex *out, unsigned flags);
+fftw_plan fftw_plan_dft_c2r_3d(int n0, int n1, int n2, fftw_complex *in, double *out, unsigned flags);
+fftw_plan fftw_plan_many_dft_r2c(int rank, const int *n, int howmany,
+                                 double *in, const int *inembed, int istride, int idist,
+                                 fftw_complex *out, const int *onembed, int ostride, int odist,
+                                 unsigned flags);
+fftw_plan fftw_plan_many_dft_c2r(int rank, const int *n, int howmany,
+                                 fftw_complex *in, const int *inembed, int istride, int idist,
+                                 double *out, const int *onembed, int ostride, int odist,
+                                 unsigned flags);
+
+void fftw_execute(const fftw_plan p);
+void fftw_execute_dft(const fftw_plan p, fftw_complex *in, fftw_complex *out);
+void fftw_execute_dft_r2c(const fftw_plan p, double *in, fftw_complex *out);
+void fftw_execute_dft_c2r(const fftw_plan p, fftw_complex *in, double *out);
+void fftw_destroy_plan(fftw_plan p);
+
+void *fftw_malloc(size_t n);
+void fftw_free(void *p);
+double *fftw_alloc_real(size_t n);
+fftw_complex *fftw_alloc_complex(size_t n);
+void fftw_cleanup(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif            //  FFTX_FFTW3_H
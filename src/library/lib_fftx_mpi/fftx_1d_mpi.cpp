@@ -21,7 +21,7 @@ inline size_t ceil_div(size_t a, size_t b) {
   return (a + b - 1) / b;
 }
 
-void init_1d_comms(fftx_plan plan, int pp, int M, int N, int K) {
+void init_1d_comms(fftx_plan plan, int pp, int M, int N, int K, MPI_Comm comm) {
   // can selectively do this for real fwd or inv.
   size_t M0 = ceil_div(M, pp);
   size_t M1 = pp;
@@ -30,6 +30,22 @@ void init_1d_comms(fftx_plan plan, int pp, int M, int N, int K) {
   size_t K1 = pp;
 
   size_t max_size = (((size_t)M0)*((size_t)M1)*((size_t)N)*((size_t)K0)*((size_t)K1)*((size_t)(plan->is_embed ? 8 : 1))/(plan->r)) * plan->b;
+  plan->a2a_size  = max_size;
+  plan->workspace = 2 * max_size * sizeof(complex<double>);
+  plan->is_timed  = false;
+  fftx_plan_timers_reset(plan);
+  plan->pipeline_depth = 0;
+  plan->pipe_send = plan->pipe_recv = NULL;
+  plan->pipe_req  = NULL;
+  plan->stages    = NULL;
+
+  int comm_size;
+  MPI_Comm_size(comm, &comm_size);
+  if (comm_size != pp) {
+    fprintf(stderr, "1D plan needs %d ranks but the communicator has %d ranks\n", pp, comm_size);
+    exit(-1);
+  }
+  MPI_Comm_dup(comm, &(plan->plan_comm));
 #if CUDA_AWARE_MPI
   DEVICE_MALLOC(&(plan->send_buffer), max_size * sizeof(complex<double>));
   DEVICE_MALLOC(&(plan->recv_buffer), max_size * sizeof(complex<double>));
@@ -39,8 +55,32 @@ void init_1d_comms(fftx_plan plan, int pp, int M, int N, int K) {
 #endif
 }
 
+// complex values sent to each rank, whole batch; only stages 1 and 4 exchange.
+size_t fftx_mpi_a2a_count_1d(fftx_plan plan, int stage) {
+  size_t e = plan->is_embed ? 2 : 1;
+  switch (stage) {
+    case FFTX_MPI_EMBED_1:
+      return plan->shape[0] * plan->shape[4] * plan->shape[3] * plan->shape[2] * plan->b;
+    case FFTX_MPI_EMBED_4:
+      if (plan->is_embed)
+        return plan->shape[0] * ceil_div(plan->K*e, plan->r) * plan->N*e * plan->b;
+      return plan->shape[0] * plan->shape[4] * plan->shape[3] * plan->shape[2] * plan->b;
+    default:
+      return 0;
+  }
+}
+
+void init_1d_alltoalls(fftx_plan plan) {
+  plan->a2a_req[FFTX_MPI_EMBED_2-1] = MPI_REQUEST_NULL;
+  plan->a2a_req[FFTX_MPI_EMBED_3-1] = MPI_REQUEST_NULL;
+  fftx_mpi_alltoall_init(plan, FFTX_MPI_EMBED_1, fftx_mpi_a2a_count_1d(plan, FFTX_MPI_EMBED_1), plan->plan_comm);
+  fftx_mpi_alltoall_init(plan, FFTX_MPI_EMBED_4, fftx_mpi_a2a_count_1d(plan, FFTX_MPI_EMBED_4), plan->plan_comm);
+}
+
 void destroy_1d_comms(fftx_plan plan) {
   if (plan) {
+    fftx_mpi_alltoall_free(plan);
+    MPI_Comm_free(&(plan->plan_comm));
 #if CUDA_AWARE_MPI
     DEVICE_FREE(plan->send_buffer);
     DEVICE_FREE(plan->recv_buffer);
@@ -53,20 +93,18 @@ void destroy_1d_comms(fftx_plan plan) {
 
 fftx_plan fftx_plan_distributed_1d(
   int p, int M, int N, int K,
-  int batch, bool is_embedded, bool is_complex) {
-  fftx_plan plan;
+  int batch, bool is_embedded, bool is_complex, MPI_Comm comm) {
+  fftx_plan plan = fftx_plan_cache_lookup(p, 0, M, N, K, batch, is_embedded, is_complex, 0, comm);
+  if (plan)
+    return plan;
 #if FORCE_VENDOR_LIB
-  {
+  plan = fftx_plan_distributed_1d_default(p, M, N, K, batch, is_embedded, is_complex, comm);
+  plan->use_fftx = false;
 #else
-  if(is_complex || (!is_complex && batch == 1)) {
-    plan = fftx_plan_distributed_1d_spiral(p, M, N, K, batch, is_embedded, is_complex);
-    plan->use_fftx = true;
-  } else {
+  plan = fftx_plan_distributed_1d_spiral(p, M, N, K, batch, is_embedded, is_complex, comm);
+  plan->use_fftx = true;
 #endif
-    std::cout << "configuration not supported, using vendor backend" << std::endl;
-    plan = fftx_plan_distributed_1d_default(p, M, N, K, batch, is_embedded, is_complex);
-    plan->use_fftx = false;
-  }
+  fftx_plan_cache_insert(plan, p, 0, M, N, K, batch, is_embedded, is_complex, 0, comm);
   return plan;
 }
 
@@ -75,7 +113,7 @@ void fftx_mpi_rcperm_1d(
 ) {
   size_t e = is_embedded ? 2 : 1;
   int rank;
-  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  MPI_Comm_rank(plan->plan_comm, &rank);
 
   switch (stage) {
     case FFTX_MPI_EMBED_1:
@@ -91,10 +129,10 @@ void fftx_mpi_rcperm_1d(
           // TODO: change this to be acceptable for C2C, not just R2C.
           // size_t buffer_size = (plan->M*e/2+1) * plan->shape[4] * plan->shape[2] * plan->b;
           size_t buffer_size = plan->shape[1] * plan->shape[0] * plan->shape[4] * plan->shape[3] * plan->shape[2] * plan->b;
-          size_t sendSize    =                  plan->shape[0] * plan->shape[4] * plan->shape[3] * plan->shape[2] * plan->b;
-          size_t recvSize    = sendSize;
+          size_t sendSize    = fftx_mpi_a2a_count_1d(plan, stage);
 
-          DEVICE_MEM_COPY(
+          FFTX_MPI_COPY(
+            plan,
             plan->send_buffer, X,
             buffer_size * sizeof(complex<double>),
             MEM_COPY_DEVICE_TO_HOST
@@ -102,17 +140,12 @@ void fftx_mpi_rcperm_1d(
           // TODO: make sure buffer is padded out before send?
 
           // [pz, X'/px, Z/pz, Y] <= [X', Z/pz, Y]
-          MPI_Alltoall(
-            plan->send_buffer, sendSize,
-            MPI_DOUBLE_COMPLEX,
-            plan->recv_buffer, recvSize,
-            MPI_DOUBLE_COMPLEX,
-            MPI_COMM_WORLD
-          );
+          fftx_mpi_alltoall(plan, stage, sendSize, plan->plan_comm);
           //      [ceil(X'/px), pz, Z/pz, Y] <= [pz, ceil(X'/px), Z/pz, Y]
           // i.e. [ceil(X'/px),        Z, Y]
           if (is_embedded) {
-            DEVICE_MEM_COPY(
+            FFTX_MPI_COPY(
+              plan,
               Y, plan->recv_buffer,
               sizeof(complex<double>) * plan->shape[5] * plan->shape[0] * plan->shape[4] * plan->shape[2] * plan->b,
               MEM_COPY_HOST_TO_DEVICE
@@ -125,6 +158,7 @@ void fftx_mpi_rcperm_1d(
               plan->shape[5],
               false
             );
+            double t = fftx_mpi_tic(plan);
             embed(
               (complex<double> *) Y, (complex<double> *) X,
               plan->shape[2], // faster
@@ -132,8 +166,11 @@ void fftx_mpi_rcperm_1d(
               plan->shape[0] * plan->shape[5] * plan->shape[4], // slower
               plan->b // copy size
             );
+            fftx_mpi_toc(plan, FFTX_MPI_TIMER_PACK, t,
+              sizeof(complex<double>) * plan->shape[2] * plan->shape[0] * plan->shape[5] * plan->shape[4] * plan->b * 2);
           } else {
-            DEVICE_MEM_COPY(
+            FFTX_MPI_COPY(
+              plan,
               X, plan->recv_buffer,
               sizeof(complex<double>) * plan->shape[5] * plan->shape[0] * plan->shape[4] * plan->shape[2] * plan->b,
               MEM_COPY_HOST_TO_DEVICE
@@ -163,6 +200,7 @@ void fftx_mpi_rcperm_1d(
           //   plan->N*e * plan->shape[0] // slower dim
           // );
 
+          double t = fftx_mpi_tic(plan);
           embed(
             (complex<double> *) Y, (complex<double> *) X,
             plan->K, // fastest dim, to be doubled and embedded
@@ -170,6 +208,8 @@ void fftx_mpi_rcperm_1d(
             plan->N*e * plan->shape[0], // slower dim
             plan->b
           );
+          fftx_mpi_toc(plan, FFTX_MPI_TIMER_PACK, t,
+            sizeof(complex<double>) * (K1 * K0 + 2 * plan->K) * plan->N*e * plan->shape[0] * plan->b);
 
 
         } else {
@@ -202,6 +242,7 @@ void fftx_mpi_rcperm_1d(
           size_t K1 = plan->r;
           // arg size isn't supposed to be padded in the dim that it's going to be padded in.
           {
+            double t = fftx_mpi_tic(plan);
             pack(
               (complex<double> *) Y, (complex<double> *) X,
               plan->shape[0],
@@ -212,13 +253,13 @@ void fftx_mpi_rcperm_1d(
               plan->shape[0] * K0 * plan->N*e * plan->b,
               K0 * plan->N*e * plan->b
             );
-
+            fftx_mpi_toc(plan, FFTX_MPI_TIMER_UNPACK, t,
+              2 * sizeof(complex<double>) * plan->shape[0] * K1 * K0 * plan->N*e * plan->b);
           }
 
-          // size_t sendSize = plan->shape[0] * plan->shape[4]*e * plan->N*e * plan->b;
-          size_t sendSize = plan->shape[0] * K0 * plan->N*e * plan->b;
-          size_t recvSize = sendSize;
-          DEVICE_MEM_COPY(
+          size_t sendSize = fftx_mpi_a2a_count_1d(plan, stage);
+          FFTX_MPI_COPY(
+            plan,
             plan->send_buffer, Y,
             sizeof(complex<double>) * K1 * sendSize,
             MEM_COPY_DEVICE_TO_HOST
@@ -228,17 +269,12 @@ void fftx_mpi_rcperm_1d(
           // [px*ceil(X'/px), Z/pz, Y] <=                      (reshape)
           // kind of automatically strip the excess since X is slowest dim.
           // [X', Z/pz, Y] <=                      (reshape)
-          MPI_Alltoall(
-            plan->send_buffer,  sendSize,
-            MPI_DOUBLE_COMPLEX,
-            plan->recv_buffer, recvSize,
-            MPI_DOUBLE_COMPLEX,
-            MPI_COMM_WORLD
-          );
+          fftx_mpi_alltoall(plan, stage, sendSize, plan->plan_comm);
 
-          DEVICE_MEM_COPY(
+          FFTX_MPI_COPY(
+            plan,
             Y, plan->recv_buffer,
-            sizeof(complex<double>) * plan->shape[1] * recvSize,
+            sizeof(complex<double>) * plan->shape[1] * sendSize,
             MEM_COPY_HOST_TO_DEVICE
           );
         } else {
@@ -246,17 +282,19 @@ void fftx_mpi_rcperm_1d(
             size_t a = plan->shape[4] * plan->shape[3] * plan->shape[2] * plan->b;
             size_t b = plan->shape[5];
             size_t c = plan->shape[0];
+            double t = fftx_mpi_tic(plan);
             pack(
               (complex<double> *) Y, (complex<double> *) X,
               b,   a, c*a,
               c, b*a,   a,
               a
             );
+            fftx_mpi_toc(plan, FFTX_MPI_TIMER_UNPACK, t, 2 * sizeof(complex<double>) * a * b * c);
           }
 
-          size_t sendSize = plan->shape[0] * plan->shape[4] * plan->shape[3] * plan->shape[2] * plan->b;
-          size_t recvSize = sendSize;
-          DEVICE_MEM_COPY(
+          size_t sendSize = fftx_mpi_a2a_count_1d(plan, stage);
+          FFTX_MPI_COPY(
+            plan,
             plan->send_buffer, Y,
             sizeof(complex<double>) * plan->shape[5] * sendSize,
             MEM_COPY_DEVICE_TO_HOST
@@ -264,17 +302,12 @@ void fftx_mpi_rcperm_1d(
 
           // [px, X'/px, Z/pz, Y] <= [pz, X'/px, Z/pz, Y] (all2all)
           // [       X', Z/pz, Y] <=                      (reshape)
-          MPI_Alltoall(
-            plan->send_buffer,  sendSize,
-            MPI_DOUBLE_COMPLEX,
-            plan->recv_buffer, recvSize,
-            MPI_DOUBLE_COMPLEX,
-            MPI_COMM_WORLD
-          );
+          fftx_mpi_alltoall(plan, stage, sendSize, plan->plan_comm);
 
-          DEVICE_MEM_COPY(
+          FFTX_MPI_COPY(
+            plan,
             Y, plan->recv_buffer,
-            sizeof(complex<double>) * plan->shape[5] * recvSize,
+            sizeof(complex<double>) * plan->shape[5] * sendSize,
             MEM_COPY_HOST_TO_DEVICE
           );
         }
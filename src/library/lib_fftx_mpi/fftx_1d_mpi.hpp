@@ -14,10 +14,14 @@
 
 using namespace std;
 
-void init_1d_comms(fftx_plan plan, int pp, int M, int N, int K);
+void init_1d_comms(fftx_plan plan, int pp, int M, int N, int K, MPI_Comm comm = MPI_COMM_WORLD);
 void destroy_1d_comms(fftx_plan plan);
+// sets up the stage all-to-alls; call once the plan shape is known.
+void init_1d_alltoalls(fftx_plan plan);
+size_t fftx_mpi_a2a_count_1d(fftx_plan plan, int stage);
 
-fftx_plan  fftx_plan_distributed_1d(int p, int M, int N, int K, int batch, bool is_embedded, bool is_complex);
+// the p ranks of the slab decomposition are the ranks of comm.
+fftx_plan  fftx_plan_distributed_1d(int p, int M, int N, int K, int batch, bool is_embedded, bool is_complex, MPI_Comm comm = MPI_COMM_WORLD);
 void fftx_execute_1d(fftx_plan plan, double* out_buffer, double*in_buffer, int direction);
 
 void fftx_mpi_rcperm_1d(fftx_plan plan, double * Y, double *X, int stage, bool is_embedded);
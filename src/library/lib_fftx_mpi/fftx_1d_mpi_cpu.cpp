@@ -0,0 +1,346 @@
+#include <complex>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include <mpi.h>
+#include <iostream>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "device_macros.h"
+#include "fftx_util.h"
+#include "fftx_mpi.hpp"
+#include "fftx_1d_mpi_cpu.hpp"
+
+#include "fftxfft.hpp"
+
+using namespace std;
+using fftx_cuFFT::fftxPlanKernel;
+
+// local FFT stages: M, then N, then K after the exchange.
+#define FFTX_1D_CPU_STAGE_M 0
+#define FFTX_1D_CPU_STAGE_N 1
+#define FFTX_1D_CPU_STAGE_K 2
+
+// one kernel per thread and stage, each over a contiguous run of pencils. The
+// threads' runs have the same length except the last, so a stage builds at
+// most two kernels at plan time; each thread loads its own instance.
+struct fftx_1d_cpu_stages {
+  int threads;
+  size_t len[3];
+  vector<size_t> first[3];
+  vector<fftxPlanKernel> fwd[3];
+  vector<fftxPlanKernel> inv[3];
+};
+
+// [A, B, C, D] -> [A, C, B, D], slowest to fastest, D elements copied at a time.
+// dst_a and src_a are the distances between A blocks, B*C*D when 0.
+static void fftx_1d_cpu_swap(
+  fftx_plan plan, complex<double> *dst, complex<double> *src,
+  size_t A, size_t B, size_t C, size_t D, int timer,
+  size_t dst_a = 0, size_t src_a = 0
+) {
+  double t = fftx_mpi_tic(plan);
+  int threads = ((fftx_1d_cpu_stages *) plan->stages)->threads;
+  size_t n = B*C*D;
+  if (dst_a == 0)
+    dst_a = n;
+  if (src_a == 0)
+    src_a = n;
+  if (B == 1 || C == 1) {
+    // nothing to permute: one contiguous copy per A block.
+    #pragma omp parallel for num_threads(threads)
+    for (size_t a = 0; a < A; a++)
+      memcpy(dst + a*dst_a, src + a*src_a, n * sizeof(complex<double>));
+  } else if (D == 1) {
+    #pragma omp parallel for collapse(2) num_threads(threads)
+    for (size_t a = 0; a < A; a++) {
+      for (size_t c = 0; c < C; c++) {
+        for (size_t b = 0; b < B; b++) {
+          dst[a*dst_a + c*B + b] = src[a*src_a + b*C + c];
+        }
+      }
+    }
+  } else {
+    #pragma omp parallel for collapse(2) num_threads(threads)
+    for (size_t a = 0; a < A; a++) {
+      for (size_t c = 0; c < C; c++) {
+        for (size_t b = 0; b < B; b++) {
+          memcpy(dst + a*dst_a + (c*B + b)*D, src + a*src_a + (b*C + c)*D, D * sizeof(complex<double>));
+        }
+      }
+    }
+  }
+  fftx_mpi_toc(plan, timer, t, 2 * A*n * sizeof(complex<double>));
+}
+
+// [R, M, N] -> [p, R, M0 N] when to_blocks, else back. Block j holds rows j M0
+// up to M; the rows that pad the last blocks out to M0 are not copied.
+static void fftx_1d_cpu_blocks(
+  fftx_plan plan, complex<double> *blocks, complex<double> *rows,
+  size_t R, size_t M, size_t M0, size_t N, size_t p, bool to_blocks, int timer
+) {
+  double t = fftx_mpi_tic(plan);
+  int threads = ((fftx_1d_cpu_stages *) plan->stages)->threads;
+  #pragma omp parallel for collapse(2) num_threads(threads)
+  for (size_t j = 0; j < p; j++) {
+    for (size_t r = 0; r < R; r++) {
+      size_t m0 = j * M0;
+      if (m0 >= M)
+        continue;
+      size_t bytes = min(M0, M - m0) * N * sizeof(complex<double>);
+      complex<double> *blk = blocks + (j*R + r)*M0*N;
+      complex<double> *row = rows + (r*M + m0)*N;
+      if (to_blocks)
+        memcpy(blk, row, bytes);
+      else
+        memcpy(row, blk, bytes);
+    }
+  }
+  fftx_mpi_toc(plan, timer, t, 2 * R*M*N * sizeof(complex<double>));
+}
+
+// batched 1D FFTs over contiguous pencils, split across the threads. The
+// kernels are already loaded, so the threads only call into them.
+static void fftx_1d_cpu_fft(
+  fftx_plan plan, vector<fftxPlanKernel> &stage, vector<size_t> &first, size_t len,
+  double *out, double *in, int timer
+) {
+  double t = fftx_mpi_tic(plan);
+  int threads = (int) stage.size();
+  #pragma omp parallel for num_threads(threads)
+  for (int i = 0; i < threads; i++) {
+    double *o = out + 2 * first[i] * len;
+    double *x = in  + 2 * first[i] * len;
+    fftx_cuFFT::fftxPlanRun(stage[i], o, x, nullptr);
+  }
+  fftx_mpi_toc(plan, timer, t, 0);
+}
+
+// generated kernels keep their temporaries in statics, so the threads of a
+// stage each run a private instance of one build. Only a single thread, or the
+// shorter last run, uses the fixed library, which has one instance.
+static void fftx_1d_cpu_stage_init(
+  vector<fftxPlanKernel> &stage, vector<size_t> &first, int threads,
+  size_t len, size_t pencils, const char *name
+) {
+  size_t chunk = (pencils + threads - 1) / threads;
+  // no thread is left without pencils.
+  threads = (int) ((pencils + chunk - 1) / chunk);
+  first.resize(threads + 1);
+  for (int i = 0; i <= threads; i++)
+    first[i] = min(i * chunk, pencils);
+  stage.resize(threads);
+  size_t last = first[threads] - first[threads-1];
+  vector<fftxPlanKernel *> copies;
+  for (int i = 0; i < threads; i++) {
+    stage[i].name = name;
+    if (i < threads - 1 || (threads > 1 && last == chunk))
+      copies.push_back(&stage[i]);
+  }
+  fftx_cuFFT::fftxPlanPrepareCopies(copies, name, {(int) len, (int) chunk, 0, 0});
+  if (copies.size() < stage.size())
+    fftx_cuFFT::fftxPlanPrepare(stage[threads-1], {(int) len, (int) last, 0, 0});
+}
+
+fftx_plan fftx_plan_distributed_1d_cpu(
+  int p, int M, int N, int K,
+  int batch, bool is_embedded, bool is_complex, int threads, MPI_Comm comm
+) {
+  if (is_embedded || !is_complex) {
+    fprintf(stderr, "CPU slab plans need complex, non-embedded transforms\n");
+    exit(-1);
+  }
+#ifdef _OPENMP
+  if (threads <= 0)
+    threads = omp_get_max_threads();
+#else
+  threads = 1;
+#endif
+  // MPI is only called outside of the threaded regions.
+  int provided;
+  MPI_Query_thread(&provided);
+  if (threads > 1 && provided < MPI_THREAD_FUNNELED) {
+    fprintf(stderr, "CPU slab plans with threads need MPI_Init_thread with MPI_THREAD_FUNNELED\n");
+    exit(-1);
+  }
+  int comm_size;
+  MPI_Comm_size(comm, &comm_size);
+  if (comm_size != p) {
+    fprintf(stderr, "1D plan needs %d ranks but the communicator has %d ranks\n", p, comm_size);
+    exit(-1);
+  }
+
+  fftx_plan plan = (fftx_plan) malloc(sizeof(fftx_plan_t));
+  plan->M = M;
+  plan->N = N;
+  plan->K = K;
+  plan->r = p;
+  plan->c = 0;
+  plan->b = batch;
+  plan->is_complex = true;
+  plan->is_embed   = false;
+  plan->is_low_memory = false;
+  plan->is_float_transport = false;
+  plan->use_fftx = true;
+  plan->is_timed = false;
+  fftx_plan_timers_reset(plan);
+  plan->pipeline_depth = 0;
+  plan->pipe_send = plan->pipe_recv = NULL;
+  plan->pipe_req  = NULL;
+  for (int i = 0; i != 4; ++i)
+    plan->a2a_req[i] = MPI_REQUEST_NULL;
+
+  // sizes that do not divide p are padded out to p blocks of M0 and K0.
+  size_t M0 = (M + p - 1) / p;
+  size_t K0 = (K + p - 1) / p;
+  plan->shape[0] = M0;
+  plan->shape[1] = p;
+  plan->shape[2] = N;
+  plan->shape[3] = 1;
+  plan->shape[4] = K0;
+  plan->shape[5] = p;
+
+  MPI_Comm_dup(comm, &(plan->plan_comm));
+
+  // every stage holds the whole local slab, with M or K padded to p blocks.
+  size_t buff_size = K0 * N * M0 * p * batch;
+  plan->buffer_size = buff_size;
+  plan->a2a_size    = buff_size;
+  plan->Q3 = (double *) malloc(buff_size * sizeof(complex<double>));
+  plan->Q4 = (double *) malloc(buff_size * sizeof(complex<double>));
+  plan->send_buffer = (complex<double> *) malloc(buff_size * sizeof(complex<double>));
+  plan->recv_buffer = (complex<double> *) malloc(buff_size * sizeof(complex<double>));
+  plan->workspace = 4 * buff_size * sizeof(complex<double>);
+
+  fftx_1d_cpu_stages *stages = new fftx_1d_cpu_stages;
+  stages->threads = threads;
+  stages->len[FFTX_1D_CPU_STAGE_M] = M;
+  stages->len[FFTX_1D_CPU_STAGE_N] = N;
+  stages->len[FFTX_1D_CPU_STAGE_K] = K;
+  plan->stages = stages;
+
+  // every build has its own directory, so the ranks of a node prepare their
+  // kernels at once.
+  size_t pencils[3] = {batch * K0 * N, batch * K0 * M, batch * M0 * N};
+  for (int s = 0; s != 3; ++s) {
+    fftx_1d_cpu_stage_init(stages->fwd[s], stages->first[s], threads, stages->len[s], pencils[s], "b1dft");
+    fftx_1d_cpu_stage_init(stages->inv[s], stages->first[s], threads, stages->len[s], pencils[s], "ib1dft");
+  }
+  return plan;
+}
+
+static void fftx_1d_cpu_alltoall(fftx_plan plan, size_t count) {
+  double t = fftx_mpi_tic(plan);
+  MPI_Alltoall(
+    plan->send_buffer, (int) count,
+    MPI_DOUBLE_COMPLEX,
+    plan->recv_buffer, (int) count,
+    MPI_DOUBLE_COMPLEX,
+    plan->plan_comm
+  );
+  fftx_mpi_toc(plan, FFTX_MPI_TIMER_A2A, t, count * plan->r * sizeof(complex<double>));
+}
+
+void fftx_execute_1d_cpu(
+  fftx_plan plan,
+  double * out_buffer, double * in_buffer,
+  int direction )
+{
+  fftx_1d_cpu_stages *st = (fftx_1d_cpu_stages *) plan->stages;
+  size_t p  = plan->r;
+  size_t b  = plan->b;
+  size_t M  = plan->M;
+  size_t N  = plan->N;
+  size_t K  = plan->K;
+  size_t M0 = plan->shape[0];
+  size_t K0 = plan->shape[4];
+  complex<double> *in  = (complex<double> *) in_buffer;
+  complex<double> *out = (complex<double> *) out_buffer;
+  complex<double> *Q3  = (complex<double> *) plan->Q3;
+  complex<double> *Q4  = (complex<double> *) plan->Q4;
+  // each rank sends one block of its slab to every rank.
+  size_t count = b * K0 * M0 * N;
+
+  if (direction == DEVICE_FFT_FORWARD) {
+    // [K0, N, M, b] -> [b, K0, N, M], then FFT along M.
+    fftx_1d_cpu_swap(plan, Q3, in, 1, K0*N*M, b, 1, FFTX_MPI_TIMER_COPY);
+    fftx_1d_cpu_fft(plan, st->fwd[FFTX_1D_CPU_STAGE_M], st->first[FFTX_1D_CPU_STAGE_M], M, (double *) Q4, (double *) Q3, FFTX_MPI_TIMER_FFT1);
+
+    // [b K0, N, M] -> [b K0, M, N], then FFT along N.
+    fftx_1d_cpu_swap(plan, Q3, Q4, b*K0, N, M, 1, FFTX_MPI_TIMER_UNPACK);
+    fftx_1d_cpu_fft(plan, st->fwd[FFTX_1D_CPU_STAGE_N], st->first[FFTX_1D_CPU_STAGE_N], N, (double *) Q4, (double *) Q3, FFTX_MPI_TIMER_FFT2);
+
+    // [b K0, M, N] -> [p, b K0, M0 N], one block of M0 rows per destination rank.
+    fftx_1d_cpu_blocks(plan, plan->send_buffer, Q4, b*K0, M, M0, N, p, true, FFTX_MPI_TIMER_UNPACK);
+    fftx_1d_cpu_alltoall(plan, count);
+
+    // [p, b, K0, M0 N] -> [b, p K0, M0 N] -> [b, M0 N, K], dropping the planes
+    // that pad K to p K0, then FFT along K.
+    fftx_1d_cpu_swap(plan, Q4, plan->recv_buffer, 1, p, b, K0*M0*N, FFTX_MPI_TIMER_PACK);
+    fftx_1d_cpu_swap(plan, Q3, Q4, b, K, M0*N, 1, FFTX_MPI_TIMER_PACK, 0, p*K0*M0*N);
+    fftx_1d_cpu_fft(plan, st->fwd[FFTX_1D_CPU_STAGE_K], st->first[FFTX_1D_CPU_STAGE_K], K, (double *) Q4, (double *) Q3, FFTX_MPI_TIMER_FFT3);
+
+    // [b, M0, N, K] -> [M0, N, K, b]
+    fftx_1d_cpu_swap(plan, out, Q4, 1, b, M0*N*K, 1, FFTX_MPI_TIMER_COPY);
+  } else if (direction == DEVICE_FFT_INVERSE) {
+    // [M0, N, K, b] -> [b, M0, N, K], then inverse FFT along K.
+    fftx_1d_cpu_swap(plan, Q3, in, 1, M0*N*K, b, 1, FFTX_MPI_TIMER_COPY);
+    fftx_1d_cpu_fft(plan, st->inv[FFTX_1D_CPU_STAGE_K], st->first[FFTX_1D_CPU_STAGE_K], K, (double *) Q4, (double *) Q3, FFTX_MPI_TIMER_FFT3);
+
+    // [b, M0 N, K] -> [b, p K0, M0 N] -> [p, b, K0 M0 N]; the planes that pad
+    // K to p K0 are sent but never read.
+    fftx_1d_cpu_swap(plan, Q3, Q4, b, M0*N, K, 1, FFTX_MPI_TIMER_UNPACK, p*K0*M0*N, 0);
+    fftx_1d_cpu_swap(plan, plan->send_buffer, Q3, 1, b, p, K0*M0*N, FFTX_MPI_TIMER_UNPACK);
+    fftx_1d_cpu_alltoall(plan, count);
+
+    // [p, b K0, M0 N] -> [b K0, M, N], then inverse FFT along N.
+    fftx_1d_cpu_blocks(plan, plan->recv_buffer, Q3, b*K0, M, M0, N, p, false, FFTX_MPI_TIMER_PACK);
+    fftx_1d_cpu_fft(plan, st->inv[FFTX_1D_CPU_STAGE_N], st->first[FFTX_1D_CPU_STAGE_N], N, (double *) Q4, (double *) Q3, FFTX_MPI_TIMER_FFT2);
+
+    // [b K0, M, N] -> [b K0, N, M], then inverse FFT along M.
+    fftx_1d_cpu_swap(plan, Q3, Q4, b*K0, M, N, 1, FFTX_MPI_TIMER_PACK);
+    fftx_1d_cpu_fft(plan, st->inv[FFTX_1D_CPU_STAGE_M], st->first[FFTX_1D_CPU_STAGE_M], M, (double *) Q4, (double *) Q3, FFTX_MPI_TIMER_FFT1);
+
+    // [b, K0, N, M] -> [K0, N, M, b]
+    fftx_1d_cpu_swap(plan, out, Q4, 1, b, K0*N*M, 1, FFTX_MPI_TIMER_COPY);
+  }
+}
+
+void fftx_plan_destroy_1d_cpu(fftx_plan plan) {
+  if (plan) {
+    fftx_1d_cpu_stages *st = (fftx_1d_cpu_stages *) plan->stages;
+    for (int s = 0; s != 3; ++s) {
+      for (size_t i = 0; i != st->fwd[s].size(); ++i) {
+        fftx_cuFFT::fftxPlanRelease(st->fwd[s][i]);
+        fftx_cuFFT::fftxPlanRelease(st->inv[s][i]);
+      }
+    }
+    delete st;
+    MPI_Comm_free(&(plan->plan_comm));
+    free(plan->send_buffer);
+    free(plan->recv_buffer);
+    free(plan->Q3);
+    free(plan->Q4);
+    free(plan);
+  }
+}
+
+// host builds have only the slab plan, so the generic calls go to it.
+void fftx_execute(fftx_plan plan, double* out_buffer, double*in_buffer, int direction) {
+  fftx_execute_1d_cpu(plan, out_buffer, in_buffer, direction);
+}
+
+void fftx_plan_destroy(fftx_plan plan) {
+  fftx_plan_destroy_1d_cpu(plan);
+}
+
+// slab plans are not cached.
+bool fftx_plan_is_shared(fftx_plan plan) {
+  return false;
+}
+
+size_t fftx_plan_workspace(fftx_plan plan) {
+  return plan ? plan->workspace : 0;
+}
@@ -0,0 +1,26 @@
+#ifndef __FFTX_1D_MPI_CPU__
+#define __FFTX_1D_MPI_CPU__
+
+#include <complex>
+#include <cstdio>
+#include <vector>
+#include <mpi.h>
+#include <iostream>
+
+#include "device_macros.h"
+#include "fftx_util.h"
+#include "fftx_mpi.hpp"
+
+using namespace std;
+
+// host slab plan over the p ranks of comm, with threads host threads per rank
+// (0 for the OpenMP default). complex and non-embedded.
+// forward: [K0, N, M, b] -> [M0, N, K, b], slowest to fastest, with
+// K0 = ceil(K/p) and M0 = ceil(M/p); inverse swaps them. When p does not divide
+// K or M, the planes or rows that pad the last ranks are ignored on input and
+// undefined on output. fftx_execute and fftx_plan_destroy also take this plan.
+fftx_plan  fftx_plan_distributed_1d_cpu(int p, int M, int N, int K, int batch, bool is_embedded, bool is_complex, int threads = 0, MPI_Comm comm = MPI_COMM_WORLD);
+void fftx_execute_1d_cpu(fftx_plan plan, double* out_buffer, double*in_buffer, int direction);
+void fftx_plan_destroy_1d_cpu(fftx_plan plan);
+
+#endif
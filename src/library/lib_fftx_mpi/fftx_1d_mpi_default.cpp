@@ -21,7 +21,7 @@ inline int ceil_div(int a, int b) {
 
 fftx_plan fftx_plan_distributed_1d_default(
   int p, int M, int N, int K,
-  int batch, bool is_embedded, bool is_complex
+  int batch, bool is_embedded, bool is_complex, MPI_Comm comm
 ) {
   fftx_plan plan   = (fftx_plan) malloc(sizeof(fftx_plan_t));
   plan->M = M;
@@ -32,9 +32,11 @@ fftx_plan fftx_plan_distributed_1d_default(
   plan->b          = batch;
   plan->is_complex = is_complex;
   plan->is_embed   = is_embedded;
+  plan->is_low_memory = false;
+  plan->is_float_transport = false;
   size_t e         = is_embedded ? 2 : 1;
 
-  init_1d_comms(plan, p, M, N, K);   //embedding uses the input sizes
+  init_1d_comms(plan, p, M, N, K, comm);   //embedding uses the input sizes
 
   /*
     R2C is
@@ -65,11 +67,15 @@ fftx_plan fftx_plan_distributed_1d_default(
   plan->shape[4] = K0;
   plan->shape[5] = K1;
 
+  init_1d_alltoalls(plan);
+
   int invK0 = ceil_div(K*e, p);
 
   size_t buff_size = ((size_t) M0) * ((size_t) M1) * ((size_t) N*e) * 1 * ((size_t) invK0) * ((size_t) batch); // can either omit M1 or K1. arbit omit K1.
-  DEVICE_MALLOC(&(plan->Q3), sizeof(complex<double>) * buff_size * batch);
-  DEVICE_MALLOC(&(plan->Q4), sizeof(complex<double>) * buff_size * batch);
+  DEVICE_MALLOC(&(plan->Q3), sizeof(complex<double>) * buff_size);
+  DEVICE_MALLOC(&(plan->Q4), sizeof(complex<double>) * buff_size);
+  plan->buffer_size = buff_size;
+  plan->workspace  += 2 * sizeof(complex<double>) * buff_size;
 
   if (plan->is_complex) {
     int batch_sizeX = N * K0;  // stage 1, dist Z
@@ -183,7 +189,8 @@ void fftx_execute_1d_default(
   int direction
 ) {
   int rank;
-  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  MPI_Comm_rank(plan->plan_comm, &rank);
+  double t = fftx_mpi_tic(plan);
 
   if (direction == DEVICE_FFT_FORWARD) {
     if (plan->is_complex) {
@@ -197,8 +204,10 @@ void fftx_execute_1d_default(
         );
       }
 
+      fftx_mpi_toc(plan, FFTX_MPI_TIMER_FFT1, t, 0);
       // [ceil(X'/px), pz, ceil(Z/pz), Y, b] <= [px, ceil(X'/px), ceil(Z/pz), Y, b]
       fftx_mpi_rcperm_1d(plan, plan->Q4, plan->Q3, FFTX_MPI_EMBED_1, plan->is_embed);
+      t = fftx_mpi_tic(plan);
 
       for (size_t b = 0; b < plan->b; ++b) {
         // [Y, ceil(X'/px), pz, ceil(Z/pz), b] <= [ceil(X'/px), pz, ceil(Z/pz), Y, b]
@@ -209,6 +218,7 @@ void fftx_execute_1d_default(
           direction
         );
       }
+      fftx_mpi_toc(plan, FFTX_MPI_TIMER_FFT2, t, 0);
 
       double *stg2_output = (double *) plan->Q3;
       double *stg3_input  = (double *) plan->Q4;
@@ -219,6 +229,7 @@ void fftx_execute_1d_default(
         // no permutation necessary, use previous output as input.
         stg3_input = stg2_output;
       }
+      t = fftx_mpi_tic(plan);
       // [Y, X'/px, Z] (no permutation on last stage)
       for (int b = 0; b < plan->b; ++b) {
         DEVICE_FFT_EXECZ2Z(
@@ -228,6 +239,7 @@ void fftx_execute_1d_default(
           direction
         );
       }
+      fftx_mpi_toc(plan, FFTX_MPI_TIMER_FFT3, t, 0);
     } else {
       //forward real
       // [X', Z/p, Y, b] <= [Z/p, Y, X, b]
@@ -238,8 +250,10 @@ void fftx_execute_1d_default(
           ((DEVICE_FFT_DOUBLECOMPLEX *) plan->Q3)  + b
         );
       }
+      fftx_mpi_toc(plan, FFTX_MPI_TIMER_FFT1, t, 0);
       // [X'/px, pz, b, Z/pz, Y] <= [px, X'/px, b, Z/pz, Y]
       fftx_mpi_rcperm_1d(plan, plan->Q4, plan->Q3, FFTX_MPI_EMBED_1, plan->is_embed);
+      t = fftx_mpi_tic(plan);
 
       // [Y, X'/px, Z] <= [X'/px, Z, Y]
       // [Y, X'/px, 2Z]
@@ -251,6 +265,7 @@ void fftx_execute_1d_default(
           direction
         );
       }
+      fftx_mpi_toc(plan, FFTX_MPI_TIMER_FFT2, t, 0);
 
       double *stg2_output = (double *) plan->Q3;
       double *stg3_input  = (double *) plan->Q4;
@@ -260,6 +275,7 @@ void fftx_execute_1d_default(
         // no permutation necessary, use previous output as input.
         stg3_input = stg2_output;
       }
+      t = fftx_mpi_tic(plan);
 
       // [Y, X'/px, Z] (no permutation on last stage)
       for (size_t b = 0; b < plan->b; ++b) {
@@ -270,6 +286,7 @@ void fftx_execute_1d_default(
           direction
         );
       }
+      fftx_mpi_toc(plan, FFTX_MPI_TIMER_FFT3, t, 0);
     }
   } else if (direction == DEVICE_FFT_INVERSE) { // backward
     DEVICE_FFT_DOUBLECOMPLEX *stg3i_input  = (DEVICE_FFT_DOUBLECOMPLEX *) in_buffer;
@@ -278,6 +295,8 @@ void fftx_execute_1d_default(
     for (size_t b = 0; b < plan->b; b++) {
       DEVICE_FFT_EXECZ2Z(plan->stg3, stg3i_input + b, stg3i_output + b, direction);
     }
+    fftx_mpi_toc(plan, FFTX_MPI_TIMER_FFT3, t, 0);
+    t = fftx_mpi_tic(plan);
     // no permutation necessary, use previous output as input.
     DEVICE_FFT_DOUBLECOMPLEX *stg2i_input  = stg3i_output;
     DEVICE_FFT_DOUBLECOMPLEX *stg2i_output = (DEVICE_FFT_DOUBLECOMPLEX *) plan->Q4;
@@ -287,6 +306,7 @@ void fftx_execute_1d_default(
     for (size_t b = 0; b < plan->b; ++b) {
       DEVICE_FFT_EXECZ2Z(plan->stg2i, stg2i_input + b, stg2i_output + b, direction);
     }
+    fftx_mpi_toc(plan, FFTX_MPI_TIMER_FFT2, t, 0);
 
     DEVICE_FFT_DOUBLECOMPLEX *stg1i_input = (DEVICE_FFT_DOUBLECOMPLEX *) plan->Q3;
 
@@ -296,6 +316,7 @@ void fftx_execute_1d_default(
     // [px, X'/px, Z/pz, Y] <= [pz, X'/px, Z/pz, Y] (all2all)
     // [       X', Z/pz, Y] <= [px, X'/px, Z/pz, Y] (reshape)
     fftx_mpi_rcperm_1d(plan, (double *) stg1i_input, (double *) stg2i_output, FFTX_MPI_EMBED_4, plan->is_embed);
+    t = fftx_mpi_tic(plan);
 
     DEVICE_FFT_DOUBLECOMPLEX *stg1i_output = (DEVICE_FFT_DOUBLECOMPLEX *) out_buffer;
 
@@ -310,5 +331,6 @@ void fftx_execute_1d_default(
         DEVICE_FFT_EXECZ2D(plan->stg1i, stg1i_input + b, ((DEVICE_FFT_DOUBLEREAL *) stg1i_output) + b);
       }
     }
+    fftx_mpi_toc(plan, FFTX_MPI_TIMER_FFT1, t, 0);
   } // end backward.
 }
\ No newline at end of file
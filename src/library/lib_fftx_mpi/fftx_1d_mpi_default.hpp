@@ -1,3 +1,6 @@
+#ifndef __FFTX_1D_MPI_DEFAULT__
+#define __FFTX_1D_MPI_DEFAULT__
+
 #include <complex>
 #include <cstdio>
 #include <vector>
@@ -11,5 +14,7 @@
 
 using namespace std;
 
-fftx_plan  fftx_plan_distributed_1d_default(int p, int M, int N, int K, int batch, bool is_embedded, bool is_complex);
-void fftx_execute_1d_default(fftx_plan plan, double* out_buffer, double*in_buffer, int direction);
\ No newline at end of file
+fftx_plan  fftx_plan_distributed_1d_default(int p, int M, int N, int K, int batch, bool is_embedded, bool is_complex, MPI_Comm comm = MPI_COMM_WORLD);
+void fftx_execute_1d_default(fftx_plan plan, double* out_buffer, double*in_buffer, int direction);
+
+#endif
@@ -17,8 +17,8 @@
 #include "ibatch2ddftObj.hpp"
 #include "batch1dprdftObj.hpp"
 #include "ibatch1dprdftObj.hpp"
-// #include "batch2dprdftObj.hpp"
-// #include "ibatch2dprdftObj.hpp"
+#include "batch2dprdftObj.hpp"
+#include "ibatch2dprdftObj.hpp"
 #if defined FFTX_CUDA
 #include "cudabackend.hpp"
 #elif defined FFTX_HIP
@@ -35,7 +35,7 @@ inline int ceil_div(int a, int b) {
 
 fftx_plan fftx_plan_distributed_1d_spiral(
   int p, int M, int N, int K,
-  int batch, bool is_embedded, bool is_complex
+  int batch, bool is_embedded, bool is_complex, MPI_Comm comm
 ) {
   fftx_plan plan   = (fftx_plan) malloc(sizeof(fftx_plan_t));
   plan->M = M;
@@ -46,9 +46,11 @@ fftx_plan fftx_plan_distributed_1d_spiral(
   plan->b          = batch;
   plan->is_complex = is_complex;
   plan->is_embed   = is_embedded;
+  plan->is_low_memory = false;
+  plan->is_float_transport = false;
   int e            = is_embedded ? 2 : 1;
 
-  init_1d_comms(plan, p, M, N, K);   //embedding uses the input sizes
+  init_1d_comms(plan, p, M, N, K, comm);   //embedding uses the input sizes
 
   /*
     R2C is
@@ -79,11 +81,15 @@ fftx_plan fftx_plan_distributed_1d_spiral(
   plan->shape[4] = K0;
   plan->shape[5] = K1;
 
+  init_1d_alltoalls(plan);
+
   int invK0 = ceil_div(K*e, p);
 
   size_t buff_size = ((size_t) M0) * ((size_t) M1) * ((size_t) N*e) * 1 * ((size_t) invK0) * ((size_t) batch); // can either omit M1 or K1. arbit omit K1.
-  DEVICE_MALLOC(&(plan->Q3), sizeof(complex<double>) * buff_size * batch);
-  DEVICE_MALLOC(&(plan->Q4), sizeof(complex<double>) * buff_size * batch);
+  DEVICE_MALLOC(&(plan->Q3), sizeof(complex<double>) * buff_size);
+  DEVICE_MALLOC(&(plan->Q4), sizeof(complex<double>) * buff_size);
+  plan->buffer_size = buff_size;
+  plan->workspace  += 2 * sizeof(complex<double>) * buff_size;
 
   return plan;
 }
@@ -94,7 +100,7 @@ void fftx_execute_1d_spiral(
   int direction )
 {
   int rank;
-  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  MPI_Comm_rank(plan->plan_comm, &rank);
   int inM = plan->M * (plan->is_embed ? 2 : 1);
   int inN = plan->N * (plan->is_embed ? 2 : 1);
   int inK = plan->K * (plan->is_embed ? 2 : 1);
@@ -121,8 +127,8 @@ void fftx_execute_1d_spiral(
   BATCH1DPRDFTProblem bprdstg1;
   IBATCH1DPRDFTProblem ibprdstg1;
 
-  // BATCH2DPRDFTProblem b2prdstg1;
-  // IBATCH2DPRDFTProblem ib2prdstg1;
+  BATCH2DPRDFTProblem b2prdstg1;
+  IBATCH2DPRDFTProblem ib2prdstg1;
 
   std::vector<int> size_stg1;  
   std::vector<int> size_stg2;  
@@ -181,26 +187,29 @@ void fftx_execute_1d_spiral(
       bdstg3.setName("b1dft");
       ibprdstg1.setName("ib1prdft");
       ibdstg2.setName("ib1dft");
+    } else {
+      // the batch is interleaved with each pencil, so every all-to-all below
+      // carries all plan->b transforms in a single exchange.
+      std::vector<int> size_stg1 = {inM, plan->b, batch_sizeX, 0, 1};  
+      std::vector<int> size_stg2 = {inN, plan->b, batch_sizeY, 0, 1};  
+      std::vector<int> size_stg3 = {inK, plan->b, batch_sizeZ, 0, 0};  
+      std::vector<int> size_istg2 = {inN, plan->b, batch_sizeY_inv, 1, 0};  
+      std::vector<int> size_istg1 = {inM, plan->b, batch_sizeX_inv, 1, 0};  
+      b2prdstg1.setSizes(size_stg1);
+      b2dstg2.setSizes(size_stg2);
+      b2dstg3.setSizes(size_stg3);
+      ib2prdstg1.setSizes(size_istg1);
+      ib2dstg2.setSizes(size_istg2);
+      b2prdstg1.setName("b2prdft");
+      b2dstg2.setName("b2dft");
+      b2dstg3.setName("b2dft");
+      ib2prdstg1.setName("ib2prdft");
+      ib2dstg2.setName("ib2dft");
     }
-    // } else {
-    //   std::vector<int> size_stg1 = {inM, plan->b, batch_sizeX, 0, 1};  
-    //   std::vector<int> size_stg2 = {inN, plan->b, batch_sizeY, 0, 1};  
-    //   std::vector<int> size_stg3 = {inK, plan->b, batch_sizeZ, 0, 0};  
-    //   std::vector<int> size_istg2 = {inN, plan->b, batch_sizeY_inv, 1, 0};  
-    //   std::vector<int> size_istg1 = {inM, plan->b, batch_sizeX_inv, 1, 0};  
-    //   b2prdstg1.setSizes(size_stg1);
-    //   b2dstg2.setSizes(size_stg2);
-    //   b2dstg3.setSizes(size_stg3);
-    //   ib2prdstg1.setSizes(size_istg1);
-    //   ib2dstg2.setSizes(size_istg2);
-    //   b2prdstg1.setName("b2prdft");
-    //   b2dstg2.setName("b2dft");
-    //   b2dstg3.setName("b2dft");
-    //   ib2prdstg1.setName("ib2prdft");
-    //   ib2dstg2.setName("ib2dft");
-    // }
   }
 
+  double t = fftx_mpi_tic(plan);
+
   if (direction == DEVICE_FFT_FORWARD) {
     if (plan->is_complex) {
       // [X', Z/p, Y, b] <= [Z/p, Y, X, b]
@@ -222,8 +231,10 @@ void fftx_execute_1d_spiral(
         b2dstg1.transform();
       }
 
+      fftx_mpi_toc(plan, FFTX_MPI_TIMER_FFT1, t, 0);
       // [X'/px, pz, b, Z/pz, Y] <= [px, X'/px, b, Z/pz, Y] // is this right? should batch be inner?
       fftx_mpi_rcperm_1d(plan, plan->Q4, plan->Q3, FFTX_MPI_EMBED_1, plan->is_embed);
+      t = fftx_mpi_tic(plan);
       if(plan->b == 1) {
         #if defined FFTX_CUDA
         std::vector<void*> args{&(plan->Q3), &(plan->Q4)};
@@ -241,6 +252,7 @@ void fftx_execute_1d_spiral(
         b2dstg2.setArgs(args);
         b2dstg2.transform();
       }
+      fftx_mpi_toc(plan, FFTX_MPI_TIMER_FFT2, t, 0);
 
       double *stg2_output = (double *) plan->Q3;
       double *stg3_input  = (double *) plan->Q4;
@@ -250,6 +262,7 @@ void fftx_execute_1d_spiral(
         // no permutation necessary, use previous output as input.
         stg3_input = stg2_output;
       }
+      t = fftx_mpi_tic(plan);
       // [Y, X'/px, Z] (no permutation on last stage)
       if(plan->b == 1) {
         #if defined FFTX_CUDA
@@ -268,6 +281,7 @@ void fftx_execute_1d_spiral(
         b2dstg3.setArgs(args);
         b2dstg3.transform();
       }
+      fftx_mpi_toc(plan, FFTX_MPI_TIMER_FFT3, t, 0);
     } else {
       // [X', Z/p, Y, b] <= [Z/p, Y, X, b]
       if(plan->b  == 1){
@@ -278,19 +292,20 @@ void fftx_execute_1d_spiral(
         #endif
         bprdstg1.setArgs(args);
         bprdstg1.transform();
+      } else {
+        #if defined FFTX_CUDA
+          std::vector<void*> args{&plan->Q3, &in_buffer};
+        #else 
+          std::vector<void*> args{plan->Q3, in_buffer};
+        #endif
+        b2prdstg1.setArgs(args);
+        b2prdstg1.transform();
       }
-      // } else {
-      //   #if defined FFTX_CUDA
-      //     std::vector<void*> args{&plan->Q3, &in_buffer};
-      //   #else 
-      //     std::vector<void*> args{plan->Q3, in_buffer};
-      //   #endif
-      //   b2prdstg1.setArgs(args);
-      //   b2prdstg1.transform();
-      // }
 
+      fftx_mpi_toc(plan, FFTX_MPI_TIMER_FFT1, t, 0);
       // [X'/px, pz, b, Z/pz, Y] <= [px, X'/px, b, Z/pz, Y] // is this right? should batch be inner?
       fftx_mpi_rcperm_1d(plan, plan->Q4, plan->Q3, FFTX_MPI_EMBED_1, plan->is_embed);
+      t = fftx_mpi_tic(plan);
       if(plan->b == 1) {
         #if defined FFTX_CUDA
         std::vector<void*> args{&(plan->Q3), &(plan->Q4)};
@@ -299,16 +314,16 @@ void fftx_execute_1d_spiral(
         #endif
         bdstg2.setArgs(args);
         bdstg2.transform();
-      } 
-      // else {
-      //   #if defined FFTX_CUDA
-      //     std::vector<void*> args{&plan->Q3, &plan->Q4};
-      //   #else 
-      //     std::vector<void*> args{plan->Q3, plan->Q4};
-      //   #endif
-      //   b2dstg2.setArgs(args);
-      //   b2dstg2.transform();
-      // }
+      } else {
+        #if defined FFTX_CUDA
+          std::vector<void*> args{&plan->Q3, &plan->Q4};
+        #else 
+          std::vector<void*> args{plan->Q3, plan->Q4};
+        #endif
+        b2dstg2.setArgs(args);
+        b2dstg2.transform();
+      }
+      fftx_mpi_toc(plan, FFTX_MPI_TIMER_FFT2, t, 0);
 
       double *stg2_output = (double *) plan->Q3;
       double *stg3_input  = (double *) plan->Q4;
@@ -318,6 +333,7 @@ void fftx_execute_1d_spiral(
         // no permutation necessary, use previous output as input.
         stg3_input = stg2_output;
       }
+      t = fftx_mpi_tic(plan);
       // [Y, X'/px, Z] (no permutation on last stage)
       if(plan->b == 1) {
         #if defined FFTX_CUDA
@@ -327,16 +343,16 @@ void fftx_execute_1d_spiral(
         #endif
         bdstg3.setArgs(args);
         bdstg3.transform();
-      } 
-      // else {
-      //   #if defined FFTX_CUDA
-      //     std::vector<void*> args{&out_buffer, &stg3_input};
-      //   #else 
-      //     std::vector<void*> args{out_buffer, stg3_input};
-      //   #endif
-      //   b2dstg3.setArgs(args);
-      //   b2dstg3.transform();
-      // }
+      } else {
+        #if defined FFTX_CUDA
+          std::vector<void*> args{&out_buffer, &stg3_input};
+        #else 
+          std::vector<void*> args{out_buffer, stg3_input};
+        #endif
+        b2dstg3.setArgs(args);
+        b2dstg3.transform();
+      }
+      fftx_mpi_toc(plan, FFTX_MPI_TIMER_FFT3, t, 0);
     }
   } else if (direction == DEVICE_FFT_INVERSE) { // backward
     DEVICE_FFT_DOUBLECOMPLEX *stg3i_input  = (DEVICE_FFT_DOUBLECOMPLEX *) in_buffer;
@@ -359,6 +375,8 @@ void fftx_execute_1d_spiral(
       b2dstg3.setArgs(args);
       b2dstg3.transform();
     }
+    fftx_mpi_toc(plan, FFTX_MPI_TIMER_FFT3, t, 0);
+    t = fftx_mpi_tic(plan);
     // no permutation necessary, use previous output as input.
     DEVICE_FFT_DOUBLECOMPLEX *stg2i_input  = stg3i_output;
     DEVICE_FFT_DOUBLECOMPLEX *stg2i_output = (DEVICE_FFT_DOUBLECOMPLEX *) plan->Q4;
@@ -383,6 +401,7 @@ void fftx_execute_1d_spiral(
       ib2dstg2.setArgs(args);
       ib2dstg2.transform();
     }
+    fftx_mpi_toc(plan, FFTX_MPI_TIMER_FFT2, t, 0);
 
     DEVICE_FFT_DOUBLECOMPLEX *stg1i_input = (DEVICE_FFT_DOUBLECOMPLEX *) plan->Q3;
 
@@ -392,6 +411,7 @@ void fftx_execute_1d_spiral(
     // [px, X'/px, Z/pz, Y] <= [pz, X'/px, Z/pz, Y] (all2all)
     // [       X', Z/pz, Y] <= [px, X'/px, Z/pz, Y] (reshape)
     fftx_mpi_rcperm_1d(plan, (double *) stg1i_input, (double *) stg2i_output, FFTX_MPI_EMBED_4, plan->is_embed);
+    t = fftx_mpi_tic(plan);
 
     DEVICE_FFT_DOUBLECOMPLEX *stg1i_output = (DEVICE_FFT_DOUBLECOMPLEX *) out_buffer;
 
@@ -423,16 +443,16 @@ void fftx_execute_1d_spiral(
           #endif
           ibprdstg1.setArgs(args);
           ibprdstg1.transform();
-      } 
-      // else {
-      //   #if defined FFTX_CUDA
-      //   std::vector<void*> args{&stg1i_output,  &stg1i_input};
-      //   #else 
-      //   std::vector<void*> args{stg1i_output,  stg1i_input};
-      //   #endif
-      //   ib2prdstg1.setArgs(args);
-      //   ib2prdstg1.transform();
-      // }
+      } else {
+        #if defined FFTX_CUDA
+        std::vector<void*> args{&stg1i_output,  &stg1i_input};
+        #else 
+        std::vector<void*> args{stg1i_output,  stg1i_input};
+        #endif
+        ib2prdstg1.setArgs(args);
+        ib2prdstg1.transform();
+      }
     }
+    fftx_mpi_toc(plan, FFTX_MPI_TIMER_FFT1, t, 0);
   } // end backward.
 }
@@ -80,7 +80,7 @@ __global__ void __pack_embed(
 
 
 // slowest to fastest
-// [a, b, c] -> [b, 2a, c]
+// [a, b, c] <- [b, 2a, c], center a of 2a kept
 __global__ void __unpack_embed(
 	double2 *dst,
 	double2 *src,
@@ -91,12 +91,130 @@ __global__ void __unpack_embed(
 
     size_t ia = blockIdx.y;
     size_t ib = blockIdx.x;
-    src += (ia - a/2) *   b*c + ib * c;
-    dst +=         ib * 2*c*a + ia * c;
+    src +=         ib * 2*c*a + (ia + a/2) * c;
+    dst +=         ia *   b*c + ib * c;
 
-    double2 zero = {};
     for (size_t ic = threadIdx.x; ic < c; ic += blockDim.x) {
-        dst[ic] = a/2 <= ia && ia < 3*a/2 ? src[ic] : zero;
+        dst[ic] = src[ic];
+    }
+}
+
+
+// [n, b] *= [n]
+__global__ void __pointwise_real(
+	double2 *data,
+	double *symbol,
+	size_t n,
+	size_t b
+) {
+
+    for (size_t i = blockIdx.x * blockDim.x + threadIdx.x; i < n*b; i += gridDim.x * blockDim.x) {
+        double s = symbol[i / b];
+        data[i].x *= s;
+        data[i].y *= s;
+    }
+}
+
+
+__global__ void __narrow_complex(
+	float2 *dst,
+	double2 *src,
+	size_t n
+) {
+
+    for (size_t i = blockIdx.x * blockDim.x + threadIdx.x; i < n; i += gridDim.x * blockDim.x) {
+        dst[i].x = (float) src[i].x;
+        dst[i].y = (float) src[i].y;
+    }
+}
+
+
+__global__ void __widen_complex(
+	double2 *dst,
+	float2 *src,
+	size_t n
+) {
+
+    for (size_t i = blockIdx.x * blockDim.x + threadIdx.x; i < n; i += gridDim.x * blockDim.x) {
+        dst[i].x = (double) src[i].x;
+        dst[i].y = (double) src[i].y;
+    }
+}
+
+
+// [n] <- [n, b] at j, w doubles per value
+__global__ void __extract_batch(
+	double *dst,
+	double *src,
+	size_t n,
+	size_t b,
+	size_t j,
+	size_t w
+) {
+
+    for (size_t i = blockIdx.x * blockDim.x + threadIdx.x; i < n*w; i += gridDim.x * blockDim.x) {
+        dst[i] = src[((i / w) * b + j) * w + i % w];
+    }
+}
+
+
+// [n, b] at j <- [n], w doubles per value
+__global__ void __insert_batch(
+	double *dst,
+	double *src,
+	size_t n,
+	size_t b,
+	size_t j,
+	size_t w
+) {
+
+    for (size_t i = blockIdx.x * blockDim.x + threadIdx.x; i < n*w; i += gridDim.x * blockDim.x) {
+        dst[((i / w) * b + j) * w + i % w] = src[i];
+    }
+}
+
+
+// slowest to fastest
+// [c, b, a] -> [b, n], n <= c*a
+__global__ void __pack_trimmed(
+	double2 *dst,
+	double2 *src,
+	size_t a,
+	size_t b,
+	size_t c,
+	size_t n
+) {
+
+    size_t ic = blockIdx.y;
+    size_t ib = blockIdx.x;
+    src += ic * b*a + ib * a;
+    dst += ib *   n + ic * a;
+
+    for (size_t ia = threadIdx.x; ia < a && ic * a + ia < n; ia += blockDim.x) {
+        dst[ia] = src[ia];
+    }
+}
+
+
+// slowest to fastest
+// [b, n] -> [c, b, a], n <= c*a
+__global__ void __unpack_trimmed(
+	double2 *dst,
+	double2 *src,
+	size_t a,
+	size_t b,
+	size_t c,
+	size_t n
+) {
+
+    size_t ic = blockIdx.y;
+    size_t ib = blockIdx.x;
+    src += ib *   n + ic * a;
+    dst += ic * b*a + ib * a;
+
+    double2 zero = {};
+    for (size_t ia = threadIdx.x; ia < a; ia += blockDim.x) {
+        dst[ia] = ic * a + ia < n ? src[ia] : zero;
     }
 }
 
@@ -137,6 +255,122 @@ DEVICE_ERROR_T pack_embedded(
 	return DEVICE_SUCCESS;
 }
 
+DEVICE_ERROR_T pack_trimmed(
+	std::complex<double> *dst,
+	std::complex<double> *src,
+	size_t a,
+	size_t b,
+	size_t c,
+	size_t n
+) {
+	__pack_trimmed<<<dim3(b, c), dim3(min(a, (size_t) 1024))>>>((double2 *) dst, (double2 *) src, a, b, c, n);
+	DEVICE_ERROR_T device_status = DEVICE_SYNCHRONIZE();
+	if (device_status != DEVICE_SUCCESS) {
+		fprintf(stderr, "DEVICE_SYNCHRONIZE returned error code %d after launching addKernel!\n", device_status);
+		return device_status;
+	}
+	return DEVICE_SUCCESS;
+}
+
+DEVICE_ERROR_T unpack_trimmed(
+	std::complex<double> *dst,
+	std::complex<double> *src,
+	size_t a,
+	size_t b,
+	size_t c,
+	size_t n
+) {
+	__unpack_trimmed<<<dim3(b, c), dim3(min(a, (size_t) 1024))>>>((double2 *) dst, (double2 *) src, a, b, c, n);
+	DEVICE_ERROR_T device_status = DEVICE_SYNCHRONIZE();
+	if (device_status != DEVICE_SUCCESS) {
+		fprintf(stderr, "DEVICE_SYNCHRONIZE returned error code %d after launching addKernel!\n", device_status);
+		return device_status;
+	}
+	return DEVICE_SUCCESS;
+}
+
+DEVICE_ERROR_T pointwise_real(
+	std::complex<double> *data,
+	double *symbol,
+	size_t n,
+	size_t b
+) {
+	size_t blocks = min((n*b + 255) / 256, (size_t) 65535);
+	__pointwise_real<<<dim3(blocks), dim3(256)>>>((double2 *) data, symbol, n, b);
+	DEVICE_ERROR_T device_status = DEVICE_SYNCHRONIZE();
+	if (device_status != DEVICE_SUCCESS) {
+		fprintf(stderr, "DEVICE_SYNCHRONIZE returned error code %d after launching addKernel!\n", device_status);
+		return device_status;
+	}
+	return DEVICE_SUCCESS;
+}
+
+DEVICE_ERROR_T narrow_complex(
+	std::complex<float> *dst,
+	std::complex<double> *src,
+	size_t n
+) {
+	size_t blocks = min((n + 255) / 256, (size_t) 65535);
+	__narrow_complex<<<dim3(blocks), dim3(256)>>>((float2 *) dst, (double2 *) src, n);
+	DEVICE_ERROR_T device_status = DEVICE_SYNCHRONIZE();
+	if (device_status != DEVICE_SUCCESS) {
+		fprintf(stderr, "DEVICE_SYNCHRONIZE returned error code %d after launching addKernel!\n", device_status);
+		return device_status;
+	}
+	return DEVICE_SUCCESS;
+}
+
+DEVICE_ERROR_T widen_complex(
+	std::complex<double> *dst,
+	std::complex<float> *src,
+	size_t n
+) {
+	size_t blocks = min((n + 255) / 256, (size_t) 65535);
+	__widen_complex<<<dim3(blocks), dim3(256)>>>((double2 *) dst, (float2 *) src, n);
+	DEVICE_ERROR_T device_status = DEVICE_SYNCHRONIZE();
+	if (device_status != DEVICE_SUCCESS) {
+		fprintf(stderr, "DEVICE_SYNCHRONIZE returned error code %d after launching addKernel!\n", device_status);
+		return device_status;
+	}
+	return DEVICE_SUCCESS;
+}
+
+DEVICE_ERROR_T extract_batch(
+	double *dst,
+	double *src,
+	size_t n,
+	size_t b,
+	size_t j,
+	size_t w
+) {
+	size_t blocks = min((n*w + 255) / 256, (size_t) 65535);
+	__extract_batch<<<dim3(blocks), dim3(256)>>>(dst, src, n, b, j, w);
+	DEVICE_ERROR_T device_status = DEVICE_SYNCHRONIZE();
+	if (device_status != DEVICE_SUCCESS) {
+		fprintf(stderr, "DEVICE_SYNCHRONIZE returned error code %d after launching addKernel!\n", device_status);
+		return device_status;
+	}
+	return DEVICE_SUCCESS;
+}
+
+DEVICE_ERROR_T insert_batch(
+	double *dst,
+	double *src,
+	size_t n,
+	size_t b,
+	size_t j,
+	size_t w
+) {
+	size_t blocks = min((n*w + 255) / 256, (size_t) 65535);
+	__insert_batch<<<dim3(blocks), dim3(256)>>>(dst, src, n, b, j, w);
+	DEVICE_ERROR_T device_status = DEVICE_SYNCHRONIZE();
+	if (device_status != DEVICE_SUCCESS) {
+		fprintf(stderr, "DEVICE_SYNCHRONIZE returned error code %d after launching addKernel!\n", device_status);
+		return device_status;
+	}
+	return DEVICE_SUCCESS;
+}
+
 DEVICE_ERROR_T unpack_embedded(
 	std::complex<double> *dst,
 	std::complex<double> *src,
@@ -144,7 +378,7 @@ DEVICE_ERROR_T unpack_embedded(
 	size_t y,
 	size_t z
 ) {
-	__unpack_embed<<<dim3(y, 2*x), dim3(min(z, (size_t) 1024))>>>((double2 *) dst, (double2 *) src, x, y, z);
+	__unpack_embed<<<dim3(y, x), dim3(min(z, (size_t) 1024))>>>((double2 *) dst, (double2 *) src, x, y, z);
 	DEVICE_ERROR_T device_status = DEVICE_SYNCHRONIZE();
 	if (device_status != DEVICE_SUCCESS) {
 		fprintf(stderr, "DEVICE_SYNCHRONIZE returned error code %d after launching addKernel!\n", device_status);
@@ -45,7 +45,7 @@ DEVICE_ERROR_T unpack(
 
 
 // slowest to fastest
-// [a, b, c] -> [b, a, 2c]
+// [a, b, c] <- [b, 2a, c], center a of 2a kept
 DEVICE_ERROR_T unpack_embedded(
 	std::complex<double> *dst,
 	std::complex<double> *src,
@@ -55,6 +55,72 @@ DEVICE_ERROR_T unpack_embedded(
 );
 
 
+// slowest to fastest
+// [c, b, a] -> [b, n], where n <= c*a drops the padded tail of each pencil
+DEVICE_ERROR_T pack_trimmed(
+	std::complex<double> *dst,
+	std::complex<double> *src,
+	size_t a,
+	size_t b,
+	size_t c,
+	size_t n
+);
+
+
+// slowest to fastest
+// [b, n] -> [c, b, a], zero filling the padded tail of each pencil
+DEVICE_ERROR_T unpack_trimmed(
+	std::complex<double> *dst,
+	std::complex<double> *src,
+	size_t a,
+	size_t b,
+	size_t c,
+	size_t n
+);
+
+
+// [n, b] *= [n], scaling each of the b interleaved transforms by a real symbol
+DEVICE_ERROR_T pointwise_real(
+	std::complex<double> *data,
+	double *symbol,
+	size_t n,
+	size_t b
+);
+
+
+// complex<double> -> complex<float> and back, n values
+DEVICE_ERROR_T narrow_complex(
+	std::complex<float> *dst,
+	std::complex<double> *src,
+	size_t n
+);
+
+DEVICE_ERROR_T widen_complex(
+	std::complex<double> *dst,
+	std::complex<float> *src,
+	size_t n
+);
+
+
+// [n] <- [n, b] at batch element j, and back; w doubles per value
+DEVICE_ERROR_T extract_batch(
+	double *dst,
+	double *src,
+	size_t n,
+	size_t b,
+	size_t j,
+	size_t w
+);
+
+DEVICE_ERROR_T insert_batch(
+	double *dst,
+	double *src,
+	size_t n,
+	size_t b,
+	size_t j,
+	size_t w
+);
+
 
 void execute_packing(size_t cp_size,
 		     size_t a_dim, size_t b_dim,
@@ -1,6 +1,7 @@
 #include <complex>
 #include <cstdio>
 #include <vector>
+#include <mutex>
 #include <mpi.h>
 #include <iostream>
 
@@ -17,28 +18,35 @@
 
 using namespace std;
 
-void init_2d_comms(fftx_plan plan, int rr, int cc, int M, int N, int K) {
+inline int ceil_div(int a, int b) {
+  return (a + b - 1) / b;
+}
+
+void init_2d_comms(fftx_plan plan, int rr, int cc, int M, int N, int K, MPI_Comm comm) {
   // pass in the dft size. if embedded, double dims when necessary.
   plan->r = rr;
   plan->c = cc;
-  size_t max_size = M*N*K*(plan->is_embed ? 8 : 1)/(plan->r * plan->c) * plan->b;
-
-#if CUDA_AWARE_MPI
-  DEVICE_MALLOC(&(plan->send_buffer), max_size * sizeof(complex<double>));
-  DEVICE_MALLOC(&(plan->recv_buffer), max_size * sizeof(complex<double>));
-#else
-  plan->send_buffer = (complex<double> *) malloc(max_size * sizeof(complex<double>));
-  plan->recv_buffer = (complex<double> *) malloc(max_size * sizeof(complex<double>));
-#endif
-
-  int world_rank;
-  MPI_Comm_rank(MPI_COMM_WORLD, &world_rank);
-
-  int col_color = world_rank % plan->r;
-  int row_color = world_rank / plan->r;
+  plan->M = M;
+  plan->N = N;
+  plan->K = K;
+
+  int comm_size;
+  MPI_Comm_size(comm, &comm_size);
+  if (comm_size != rr * cc) {
+    fprintf(stderr, "2D plan needs a %d x %d grid but the communicator has %d ranks\n", rr, cc, comm_size);
+    exit(-1);
+  }
 
-  MPI_Comm_split(MPI_COMM_WORLD, row_color, world_rank, &(plan->row_comm));
-  MPI_Comm_split(MPI_COMM_WORLD, col_color, world_rank, &(plan->col_comm));
+  if (plan->is_embed && (M % rr || N % rr || K % cc)) {
+    fprintf(stderr, "embedded 2D plans require sizes divisible by the processor grid\n");
+    exit(-1);
+  }
+  // the X and Y halves are padded by whole blocks of the r ranks of a row, so
+  // the data lands in the center only when r is even.
+  if (plan->is_embed && rr % 2) {
+    fprintf(stderr, "embedded 2D plans require an even number of rows in the processor grid\n");
+    exit(-1);
+  }
 
   size_t kDim = K;
   if (!(plan->is_complex))
@@ -52,19 +60,67 @@ void init_2d_comms(fftx_plan plan, int rr, int cc, int M, int N, int K) {
     }
 
   // initial layout is [4, 5, 0, 1, 2, 3], after first fft [0, 1, 2, 3, 4, 5]
-  plan->shape[0] = M/plan->r;
+  // sizes that do not divide evenly are padded out to ceil(size/ranks) per rank;
+  // the padding is trimmed from each pencil before its 1D FFT in fftx_mpi_rcperm.
+  plan->shape[0] = ceil_div(M, plan->r);
   plan->shape[1] = plan->r;
-  plan->shape[2] = N/plan->r;
+  plan->shape[2] = ceil_div(N, plan->r);
   plan->shape[3] = plan->r;
-  plan->shape[4] = kDim/plan->c;
+  plan->shape[4] = ceil_div(kDim, plan->c);
   plan->shape[5] = plan->c;
 
+  // the exchange buffers hold the largest stage exchange, computed from each
+  // stage's own layout. Q3 and Q4 also hold the pencils permuted out of or into
+  // an exchange, which are twice the exchange when embedded.
+  size_t max_size = 0;
+  for (int stage = FFTX_MPI_EMBED_1; stage <= FFTX_MPI_EMBED_4; stage++) {
+    size_t ranks = (stage == FFTX_MPI_EMBED_1 || stage == FFTX_MPI_EMBED_4) ? plan->r : plan->c;
+    max_size = max(max_size, max(fftx_mpi_stage_size(plan, stage) * plan->b, fftx_mpi_a2a_count(plan, stage) * ranks));
+  }
+  plan->a2a_size    = max_size;
+  plan->buffer_size = max_size * (plan->is_embed ? 2 : 1);
+  plan->workspace   = 2 * max_size * sizeof(complex<double>);
+  plan->is_timed    = false;
+  fftx_plan_timers_reset(plan);
+  plan->pipeline_depth = 0;
+  plan->pipe_send = plan->pipe_recv = NULL;
+  plan->pipe_req  = NULL;
+  plan->stages    = NULL;
+
+#if CUDA_AWARE_MPI
+  DEVICE_MALLOC(&(plan->send_buffer), max_size * sizeof(complex<double>));
+  DEVICE_MALLOC(&(plan->recv_buffer), max_size * sizeof(complex<double>));
+#else
+  plan->send_buffer = (complex<double> *) malloc(max_size * sizeof(complex<double>));
+  plan->recv_buffer = (complex<double> *) malloc(max_size * sizeof(complex<double>));
+#endif
+
+  MPI_Comm_dup(comm, &(plan->plan_comm));
+
+  int comm_rank;
+  MPI_Comm_rank(plan->plan_comm, &comm_rank);
+
+  int col_color = comm_rank % plan->r;
+  int row_color = comm_rank / plan->r;
+
+  MPI_Comm_split(plan->plan_comm, row_color, comm_rank, &(plan->row_comm));
+  MPI_Comm_split(plan->plan_comm, col_color, comm_rank, &(plan->col_comm));
+
+  // stages 1 and 4 exchange along rows, stages 2 and 3 along columns.
+  fftx_mpi_alltoall_init(plan, FFTX_MPI_EMBED_1, fftx_mpi_a2a_count(plan, FFTX_MPI_EMBED_1), plan->row_comm);
+  fftx_mpi_alltoall_init(plan, FFTX_MPI_EMBED_2, fftx_mpi_a2a_count(plan, FFTX_MPI_EMBED_2), plan->col_comm);
+  fftx_mpi_alltoall_init(plan, FFTX_MPI_EMBED_3, fftx_mpi_a2a_count(plan, FFTX_MPI_EMBED_3), plan->col_comm);
+  fftx_mpi_alltoall_init(plan, FFTX_MPI_EMBED_4, fftx_mpi_a2a_count(plan, FFTX_MPI_EMBED_4), plan->row_comm);
 }
 
+static void fftx_plan_pipeline_slots(fftx_plan plan, int depth);
+
 void destroy_2d_comms(fftx_plan plan) {
   if (plan){
+    fftx_mpi_alltoall_free(plan);
     MPI_Comm_free(&(plan->row_comm));
     MPI_Comm_free(&(plan->col_comm));
+    MPI_Comm_free(&(plan->plan_comm));
 
 #if CUDA_AWARE_MPI
   DEVICE_FREE(plan->send_buffer);
@@ -73,20 +129,83 @@ void destroy_2d_comms(fftx_plan plan) {
   free(plan->send_buffer);
   free(plan->recv_buffer);
 #endif
+  fftx_plan_pipeline_slots(plan, 0);
   }
 }
 
-fftx_plan fftx_plan_distributed(int r, int c, int M, int N, int K, int batch, bool is_embedded, bool is_complex) {
-
+// plans handed out by the cache; 1D plans are keyed with c = 0. An entry
+// matches a communicator with the same group and order as the plan's own
+// duplicate, so duplicates of the planning communicator also hit.
+struct fftx_plan_cache_entry {
+  int r, c, M, N, K, batch, flags;
+  bool is_embedded, is_complex;
   fftx_plan plan;
-   if(is_complex || (!is_complex && batch == 1)) {
-    plan = fftx_plan_distributed_spiral(r, c, M, N, K, batch, is_embedded, is_complex);
-    plan->use_fftx = true;
-  } else {
-    std::cout << "configuration not supported, using vendor backend" << std::endl;
-    plan = fftx_plan_distributed_default(r, c, M, N, K, batch, is_embedded, is_complex);
-    plan->use_fftx = false;
+  int refs;
+};
+
+static bool fftx_plan_cache_on = false;
+static vector<fftx_plan_cache_entry> fftx_plan_cache;
+static mutex fftx_plan_cache_lock;
+
+void fftx_plan_cache_enable(bool enable) {
+  lock_guard<mutex> guard(fftx_plan_cache_lock);
+  fftx_plan_cache_on = enable;
+}
+
+fftx_plan fftx_plan_cache_lookup(int r, int c, int M, int N, int K, int batch, bool is_embedded, bool is_complex, int flags, MPI_Comm comm) {
+  lock_guard<mutex> guard(fftx_plan_cache_lock);
+  if (!fftx_plan_cache_on)
+    return NULL;
+  for (size_t i = 0; i != fftx_plan_cache.size(); ++i) {
+    fftx_plan_cache_entry &e = fftx_plan_cache[i];
+    if (e.r == r && e.c == c && e.M == M && e.N == N && e.K == K && e.batch == batch &&
+        e.flags == flags && e.is_embedded == is_embedded && e.is_complex == is_complex) {
+      int same_comm;
+      MPI_Comm_compare(e.plan->plan_comm, comm, &same_comm);
+      if (same_comm == MPI_IDENT || same_comm == MPI_CONGRUENT) {
+        e.refs++;
+        return e.plan;
+      }
+    }
+  }
+  return NULL;
+}
+
+void fftx_plan_cache_insert(fftx_plan plan, int r, int c, int M, int N, int K, int batch, bool is_embedded, bool is_complex, int flags, MPI_Comm comm) {
+  lock_guard<mutex> guard(fftx_plan_cache_lock);
+  if (!fftx_plan_cache_on)
+    return;
+  fftx_plan_cache_entry e = {r, c, M, N, K, batch, flags, is_embedded, is_complex, plan, 1};
+  fftx_plan_cache.push_back(e);
+}
+
+static void fftx_plan_free(fftx_plan plan) {
+  if(plan->use_fftx == true)
+    fftx_plan_destroy_spiral(plan);
+  else
+    fftx_plan_destroy_default(plan);
+}
+
+void fftx_plan_cache_clear() {
+  lock_guard<mutex> guard(fftx_plan_cache_lock);
+  vector<fftx_plan_cache_entry> in_use;
+  for (size_t i = 0; i != fftx_plan_cache.size(); ++i) {
+    if (fftx_plan_cache[i].refs > 0)
+      in_use.push_back(fftx_plan_cache[i]);
+    else
+      fftx_plan_free(fftx_plan_cache[i].plan);
   }
+  fftx_plan_cache.swap(in_use);
+}
+
+fftx_plan fftx_plan_distributed(int r, int c, int M, int N, int K, int batch, bool is_embedded, bool is_complex, int flags, MPI_Comm comm) {
+  fftx_plan plan = fftx_plan_cache_lookup(r, c, M, N, K, batch, is_embedded, is_complex, flags, comm);
+  if (plan)
+    return plan;
+
+  plan = fftx_plan_distributed_spiral(r, c, M, N, K, batch, is_embedded, is_complex, flags, comm);
+  plan->use_fftx = true;
+  fftx_plan_cache_insert(plan, r, c, M, N, K, batch, is_embedded, is_complex, flags, comm);
   return plan;
 }
 
@@ -99,17 +218,98 @@ void fftx_execute(fftx_plan plan, double* out_buffer, double*in_buffer, int dire
 }
 
 void fftx_plan_destroy(fftx_plan plan) {
-  if(plan->use_fftx == true)
-    fftx_plan_destroy_spiral(plan);
-  else
-    fftx_plan_destroy_default(plan);
+  // cached plans are kept for reuse until fftx_plan_cache_clear.
+  {
+    lock_guard<mutex> guard(fftx_plan_cache_lock);
+    for (size_t i = 0; i != fftx_plan_cache.size(); ++i) {
+      if (fftx_plan_cache[i].plan == plan) {
+        fftx_plan_cache[i].refs--;
+        return;
+      }
+    }
+  }
+  fftx_plan_free(plan);
+}
+
+size_t fftx_plan_spectral_size(fftx_plan plan) {
+  // [zl, xl, Y] after forward stage 3, per transform of the batch.
+  size_t e = plan->is_embed ? 2 : 1;
+  return plan->shape[4] * plan->shape[0] * e*e * plan->N * e;
+}
+
+void fftx_execute_rconv(fftx_plan plan, double *out_buffer, double *in_buffer, double *symbol) {
+  if (plan->c == 0 || plan->is_low_memory || !plan->use_fftx) {
+    fprintf(stderr, "fftx_execute_rconv needs a 2D plan without FFTX_MPI_LOW_MEMORY\n");
+    exit(-1);
+  }
+  fftx_execute_spiral(plan, out_buffer, in_buffer, DEVICE_FFT_FORWARD, symbol);
+}
+
+size_t fftx_plan_workspace(fftx_plan plan) {
+  return plan ? plan->workspace : 0;
+}
+
+bool fftx_plan_is_shared(fftx_plan plan) {
+  lock_guard<mutex> guard(fftx_plan_cache_lock);
+  for (size_t i = 0; i != fftx_plan_cache.size(); ++i) {
+    if (fftx_plan_cache[i].plan == plan)
+      return fftx_plan_cache[i].refs > 1;
+  }
+  return false;
+}
+
+void fftx_plan_pipeline(fftx_plan plan, int depth) {
+  if (depth > 0 && (plan->c == 0 || plan->is_low_memory)) {
+    fprintf(stderr, "batch pipelining needs a 2D plan without FFTX_MPI_LOW_MEMORY\n");
+    exit(-1);
+  }
+  if (fftx_plan_is_shared(plan)) {
+    fprintf(stderr, "fftx_plan_pipeline: the plan is shared through the plan cache\n");
+    exit(-1);
+  }
+  fftx_plan_pipeline_slots(plan, depth);
+}
+
+// (re)allocates the exchange slots of a pipeline of depth, none for 0.
+static void fftx_plan_pipeline_slots(fftx_plan plan, int depth) {
+  size_t slot_size = plan->a2a_size / plan->b;
+  if (plan->pipeline_depth > 0) {
+#if CUDA_AWARE_MPI
+    DEVICE_FREE(plan->pipe_send);
+    DEVICE_FREE(plan->pipe_recv);
+#else
+    free(plan->pipe_send);
+    free(plan->pipe_recv);
+#endif
+    free(plan->pipe_req);
+    plan->workspace -= 4 * (plan->pipeline_depth + 1) * slot_size * sizeof(complex<double>);
+    plan->pipe_send = plan->pipe_recv = NULL;
+    plan->pipe_req  = NULL;
+  }
+  plan->pipeline_depth = depth > 0 ? depth : 0;
+  if (plan->pipeline_depth == 0)
+    return;
+
+  size_t slots = 2 * (depth + 1);
+#if CUDA_AWARE_MPI
+  DEVICE_MALLOC(&(plan->pipe_send), slots * slot_size * sizeof(complex<double>));
+  DEVICE_MALLOC(&(plan->pipe_recv), slots * slot_size * sizeof(complex<double>));
+#else
+  plan->pipe_send = (complex<double> *) malloc(slots * slot_size * sizeof(complex<double>));
+  plan->pipe_recv = (complex<double> *) malloc(slots * slot_size * sizeof(complex<double>));
+#endif
+  plan->pipe_req = (MPI_Request *) malloc(slots * sizeof(MPI_Request));
+  for (size_t i = 0; i != slots; ++i)
+    plan->pipe_req[i] = MPI_REQUEST_NULL;
+  plan->workspace += 2 * slots * slot_size * sizeof(complex<double>);
 }
 
 // perm: [a, b, c] -> [a, 2c, b]
-void pack_embed(fftx_plan plan, complex<double> *dst, complex<double> *src, size_t a, size_t b, size_t c, bool is_embedded) {
+void pack_embed(fftx_plan plan, complex<double> *dst, complex<double> *src, size_t a, size_t b, size_t c, bool is_embedded, size_t n) {
   // size_t buffer_size = a * b * c * (is_embedded ? 2 : 1); // assume embedded
   size_t buffer_size = a * b * c;
 #if CPU_PERMUTE
+  double t = fftx_mpi_tic(plan);
   if (is_embedded) {
     for (int ib = 0; ib < b; ib++) {
       for (int ic = 0; ic < c/2; ic++) {
@@ -129,28 +329,37 @@ void pack_embed(fftx_plan plan, complex<double> *dst, complex<double> *src, size
       }
     }
   } else {
+    size_t len = (n > 0 ? n : c*a);
     for (int ib = 0; ib < b; ib++) {
       for (int ic = 0; ic < c; ic++) {
-        for (int ia = 0; ia < a; ia++) {
-            plan->send_buffer[ib * c*a + ic * a + ia] =
+        for (int ia = 0; ia < a && ic * a + ia < len; ia++) {
+            plan->send_buffer[ib * len + ic * a + ia] =
             plan->recv_buffer[ic * b*a + ib * a + ia];
         }
       }
     }
   }
-  DEVICE_MEM_COPY(dst, plan->send_buffer, buffer_size * sizeof(complex<double>), MEM_COPY_HOST_TO_DEVICE);
+  fftx_mpi_toc(plan, FFTX_MPI_TIMER_PACK, t, 2 * buffer_size * sizeof(complex<double>));
+  FFTX_MPI_COPY(plan, dst, plan->send_buffer, buffer_size * sizeof(complex<double>), MEM_COPY_HOST_TO_DEVICE);
 #else
   //this part of the code does unpacking on the GPU
 #if (!CUDA_AWARE_MPI)  //this copies data to the GPU to perform packing
-  DEVICE_MEM_COPY(src, plan->recv_buffer, buffer_size * sizeof(complex<double>), MEM_COPY_HOST_TO_DEVICE);
+  FFTX_MPI_COPY(plan, src, plan->recv_buffer, buffer_size * sizeof(complex<double>), MEM_COPY_HOST_TO_DEVICE);
 #endif
 
+  double t = fftx_mpi_tic(plan);
   DEVICE_ERROR_T err;
   if (is_embedded) {
     err = pack_embedded(
       dst, src,
       c, b, a
     );
+  } else if (n > 0 && n < c*a) {
+    // [a, b, c] -> [n, b], padding dropped
+    err = pack_trimmed(
+      dst, src,
+      a, b, c, n
+    );
   } else {
     // [a, b, c] -> [a, c, b]
     err = pack(
@@ -164,58 +373,57 @@ void pack_embed(fftx_plan plan, complex<double> *dst, complex<double> *src, size
     fprintf(stderr, "pack failed Y <- St1_Comm!\n");
     exit(-1);
   }
-
+  fftx_mpi_toc(plan, FFTX_MPI_TIMER_PACK, t, 2 * buffer_size * sizeof(complex<double>));
 #endif
 }
 
-// perm: [a, b, c] -> [a, 2c, b]
-void unpack_embed(fftx_plan plan, complex<double> *dst, complex<double> *src, int a, int b, int c, bool is_embedded) {
+// perm: [a, 2c, b] -> [a, b, c], center c of 2c kept, when embedded.
+void unpack_embed(fftx_plan plan, complex<double> *dst, complex<double> *src, int a, int b, int c, bool is_embedded, size_t n = 0) {
   size_t buffer_size = a * b * c;
 #if CPU_PERMUTE
   //copy data to recv buffer on host in order to unpack into the send_buffer
-  DEVICE_MEM_COPY(plan->recv_buffer, src, buffer_size * sizeof(complex<double>), MEM_COPY_DEVICE_TO_HOST);
+  FFTX_MPI_COPY(plan, plan->recv_buffer, src, buffer_size * (is_embedded ? 2 : 1) * sizeof(complex<double>), MEM_COPY_DEVICE_TO_HOST);
 
-  //the CPU code needs to be updated. It is currently the packing code.
+  double t = fftx_mpi_tic(plan);
   if (is_embedded) {
-    // TODO:
+    // the zero padded half of each pencil is dropped before the exchange.
     for (int ib = 0; ib < b; ib++) {
-      for (int ic = 0; ic < c/2; ic++) {
-        for (int ia = 0; ia < a; ia++) {
-          plan->send_buffer[ib * 2*c*a + ic * a + ia] = complex<double>(0,0);
-        }
-      }
-      for (int icd = c/2, ics = 0; icd < 3*c/2; icd++, ics++) {
-        for (int ia = 0; ia < a; ia++) {
-          plan->send_buffer[ib * 2*c*a + icd * a + ia] = plan->recv_buffer[ics * b*a + ib * a + ia];
-        }
-      }
-      for (int ic = 3*c/2; ic < 2*c; ic++) {
+      for (int ic = 0; ic < c; ic++) {
         for (int ia = 0; ia < a; ia++) {
-          plan->send_buffer[ib * 2*c*a + ic * a + ia] = complex<double>(0,0);
+          plan->send_buffer[ic * b*a + ib * a + ia] = plan->recv_buffer[ib * 2*c*a + (ic + c/2) * a + ia];
         }
       }
     }
   } else {
     // [a, b, c] <- [a, c, b]
+    size_t len = (n > 0 ? n : c*a);
     for (int ib = 0; ib < b; ib++) {
       for (int ic = 0; ic < c; ic++) {
         for (int ia = 0; ia < a; ia++) {
-          plan->send_buffer[ic * b*a + ib * a + ia] =
-          plan->recv_buffer[ib * c*a + ic * a + ia];
+          plan->send_buffer[ic * b*a + ib * a + ia] = (ic * a + ia < len) ?
+          plan->recv_buffer[ib * len + ic * a + ia] : complex<double>(0,0);
         }
       }
     }
   }
+  fftx_mpi_toc(plan, FFTX_MPI_TIMER_UNPACK, t, 2 * buffer_size * sizeof(complex<double>));
 #else
 
   //this part of the code does unpacking on the GPU
+  double t = fftx_mpi_tic(plan);
   DEVICE_ERROR_T err;
   if (is_embedded) {
-    //embedded unpack GPU code needs to be updated
+    // [a, 2c, b] -> [a, b, c], center c of 2c kept
     err = unpack_embedded(
       dst, src,
       c, b, a
     );
+  } else if (n > 0 && n < c*a) {
+    // [a, b, c] <- [n, b], padding zero filled
+    err = unpack_trimmed(
+      dst, src,
+      a, b, c, n
+    );
   } else {
     err = unpack(
       dst, src,
@@ -228,13 +436,141 @@ void unpack_embed(fftx_plan plan, complex<double> *dst, complex<double> *src, in
     fprintf(stderr, "pack failed Y <- St1_Comm!\n");
     exit(-1);
   }
+  fftx_mpi_toc(plan, FFTX_MPI_TIMER_UNPACK, t, 2 * buffer_size * sizeof(complex<double>));
 #if (!CUDA_AWARE_MPI)  //this copies data to the GPU to perform packing
-  DEVICE_MEM_COPY(plan->send_buffer, dst, buffer_size * sizeof(complex<double>), MEM_COPY_DEVICE_TO_HOST);
+  FFTX_MPI_COPY(plan, plan->send_buffer, dst, buffer_size * sizeof(complex<double>), MEM_COPY_DEVICE_TO_HOST);
+#endif
+#endif
+}
+
+// complex values sent to each rank of the stage's communicator, whole batch.
+size_t fftx_mpi_a2a_count(fftx_plan plan, int stage) {
+  size_t e = plan->is_embed ? 2 : 1;
+  switch (stage) {
+    case FFTX_MPI_EMBED_1:
+      return plan->shape[0] * plan->shape[2] * plan->shape[4] * e * plan->b;
+    case FFTX_MPI_EMBED_2:
+      return plan->shape[2] * plan->shape[4] * e * plan->shape[0] * e * plan->b;
+    case FFTX_MPI_EMBED_3:
+      return plan->shape[2] * plan->shape[4] * e * plan->shape[0] * e * plan->b;
+    case FFTX_MPI_EMBED_4:
+      return plan->shape[0] * plan->shape[2] * plan->shape[4] * e * plan->b;
+    default:
+      return 0;
+  }
+}
+
+size_t fftx_mpi_stage_size(fftx_plan plan, int stage) {
+  size_t e = plan->is_embed ? 2 : 1;
+  switch (stage) {
+    case FFTX_MPI_EMBED_1:
+      return plan->shape[0] * plan->shape[2] * plan->shape[4] * e * plan->shape[5];
+    case FFTX_MPI_EMBED_2:
+      return plan->shape[2] * plan->shape[4] * e * plan->shape[0] * e * plan->shape[1];
+    case FFTX_MPI_EMBED_3:
+      return plan->shape[2] * plan->shape[3] * plan->shape[4] * plan->shape[0] * e * e;
+    case FFTX_MPI_EMBED_4:
+      return plan->shape[0] * plan->shape[1] * plan->shape[2] * plan->shape[4] * e;
+    default:
+      return 0;
+  }
+}
+
+// complex<double> <-> complex<float> between the exchange buffers.
+void fftx_mpi_narrow(fftx_plan plan, size_t n) {
+#if CUDA_AWARE_MPI
+  DEVICE_ERROR_T err = narrow_complex((complex<float> *) plan->recv_buffer, plan->send_buffer, n);
+  if (err != DEVICE_SUCCESS) {
+    fprintf(stderr, "narrow_complex failed!\n");
+    exit(-1);
+  }
+#else
+  complex<float> *dst = (complex<float> *) plan->recv_buffer;
+  for (size_t i = 0; i < n; i++)
+    dst[i] = complex<float>(plan->send_buffer[i]);
+#endif
+}
+
+void fftx_mpi_widen(fftx_plan plan, size_t n) {
+#if CUDA_AWARE_MPI
+  DEVICE_ERROR_T err = widen_complex(plan->recv_buffer, (complex<float> *) plan->send_buffer, n);
+  if (err != DEVICE_SUCCESS) {
+    fprintf(stderr, "widen_complex failed!\n");
+    exit(-1);
+  }
+#else
+  complex<float> *src = (complex<float> *) plan->send_buffer;
+  for (size_t i = 0; i < n; i++)
+    plan->recv_buffer[i] = complex<double>(src[i]);
 #endif
+}
+
+void fftx_mpi_alltoall_init(fftx_plan plan, int stage, size_t count, MPI_Comm comm) {
+  plan->a2a_req[stage-1] = MPI_REQUEST_NULL;
+#if FFTX_MPI_PERSISTENT
+  if (plan->is_float_transport) {
+    MPI_Alltoall_init(
+      plan->recv_buffer, (int) count,
+      MPI_COMPLEX,
+      plan->send_buffer, (int) count,
+      MPI_COMPLEX,
+      comm, MPI_INFO_NULL,
+      &(plan->a2a_req[stage-1])
+    );
+    return;
+  }
+  MPI_Alltoall_init(
+    plan->send_buffer, (int) count,
+    MPI_DOUBLE_COMPLEX,
+    plan->recv_buffer, (int) count,
+    MPI_DOUBLE_COMPLEX,
+    comm, MPI_INFO_NULL,
+    &(plan->a2a_req[stage-1])
+  );
 #endif
 }
 
-void fftx_mpi_rcperm(fftx_plan plan, double * _Y, double *_X, int stage, bool is_embedded) {
+void fftx_mpi_alltoall(fftx_plan plan, int stage, size_t count, MPI_Comm comm) {
+  double t = fftx_mpi_tic(plan);
+  int p;
+  MPI_Comm_size(comm, &p);
+  if (plan->is_float_transport)
+    fftx_mpi_narrow(plan, count * p);
+#if FFTX_MPI_PERSISTENT
+  if (plan->a2a_req[stage-1] != MPI_REQUEST_NULL) {
+    MPI_Start(&(plan->a2a_req[stage-1]));
+    MPI_Wait(&(plan->a2a_req[stage-1]), MPI_STATUS_IGNORE);
+  } else
+#endif
+  if (plan->is_float_transport)
+    MPI_Alltoall(
+      plan->recv_buffer, (int) count,
+      MPI_COMPLEX,
+      plan->send_buffer, (int) count,
+      MPI_COMPLEX,
+      comm
+    );
+  else
+    MPI_Alltoall(
+      plan->send_buffer, (int) count,
+      MPI_DOUBLE_COMPLEX,
+      plan->recv_buffer, (int) count,
+      MPI_DOUBLE_COMPLEX,
+      comm
+    );
+  if (plan->is_float_transport)
+    fftx_mpi_widen(plan, count * p);
+  fftx_mpi_toc(plan, FFTX_MPI_TIMER_A2A, t, count * p * (plan->is_float_transport ? sizeof(complex<float>) : sizeof(complex<double>)));
+}
+
+void fftx_mpi_alltoall_free(fftx_plan plan) {
+  for (int i = 0; i != 4; ++i) {
+    if (plan->a2a_req[i] != MPI_REQUEST_NULL)
+      MPI_Request_free(&(plan->a2a_req[i]));
+  }
+}
+
+void fftx_mpi_rcperm_phases(fftx_plan plan, double * _Y, double *_X, int stage, bool is_embedded, int phases) {
   complex<double> *X = (complex<double> *) _X;
   complex<double> *Y = (complex<double> *) _Y;
 
@@ -243,33 +579,25 @@ void fftx_mpi_rcperm(fftx_plan plan, double * _Y, double *_X, int stage, bool is
       {
         // after first 1D FFT on K dim.
         // [xl, yl, zl, zr]
-        size_t buffer_size = plan->shape[0] * plan->shape[2] * plan->shape[4] * (is_embedded ? 2 : 1) * plan->shape[5];
-        int       sendSize = plan->shape[0] * plan->shape[2] * plan->shape[4] * (is_embedded ? 2 : 1);
-        int recvSize = sendSize;
+        size_t buffer_size = fftx_mpi_stage_size(plan, stage);
+        size_t sendSize = fftx_mpi_a2a_count(plan, stage);
 
         // [xl, yl, zl, zr] -> [xl, yl, zl, xr]
         // [xl, (yl, zl), xr] -> [xl, xr, (yl, zl)]
 #if CUDA_AWARE_MPI
-        DEVICE_MEM_COPY(plan->send_buffer, X, buffer_size * sizeof(complex<double>) * plan->b, MEM_COPY_DEVICE_TO_DEVICE);
-        MPI_Alltoall(
-          // X, sendSize*plan->b,
-          plan->send_buffer, sendSize*plan->b,
-          MPI_DOUBLE_COMPLEX,
-          plan->recv_buffer, recvSize*plan->b,
-          MPI_DOUBLE_COMPLEX,
-          plan->row_comm // TODO: Make sure this is the correct communicator
-        ); // assume N dim is initially distributed along col comm.
-        pack_embed(plan, Y, plan->recv_buffer, plan->b * plan->shape[0], plan->shape[2] * plan->shape[4] * (is_embedded ? 2 : 1), plan->shape[1], is_embedded);
+        if (phases & FFTX_MPI_PHASE_PRE)
+          FFTX_MPI_COPY(plan, plan->send_buffer, X, buffer_size * sizeof(complex<double>) * plan->b, MEM_COPY_DEVICE_TO_DEVICE);
+        if (phases & FFTX_MPI_PHASE_A2A)
+          fftx_mpi_alltoall(plan, stage, sendSize, plan->row_comm);
+        if (phases & FFTX_MPI_PHASE_POST)
+          pack_embed(plan, Y, plan->recv_buffer, plan->b * plan->shape[0], plan->shape[2] * plan->shape[4] * (is_embedded ? 2 : 1), plan->shape[1], is_embedded, plan->b * plan->M);
 #else
-        DEVICE_MEM_COPY(plan->send_buffer, X, buffer_size * sizeof(complex<double>) * plan->b, MEM_COPY_DEVICE_TO_HOST);
-        MPI_Alltoall(
-          plan->send_buffer, sendSize*plan->b,
-          MPI_DOUBLE_COMPLEX,
-          plan->recv_buffer, recvSize*plan->b,
-          MPI_DOUBLE_COMPLEX,
-          plan->row_comm // TODO: Make sure this is the correct communicator
-        ); // assume N dim is initially distributed along col comm.
-        pack_embed(plan, Y,                 X, plan->b * plan->shape[0], plan->shape[2] * plan->shape[4] * (is_embedded ? 2 : 1), plan->shape[1], is_embedded);
+        if (phases & FFTX_MPI_PHASE_PRE)
+          FFTX_MPI_COPY(plan, plan->send_buffer, X, buffer_size * sizeof(complex<double>) * plan->b, MEM_COPY_DEVICE_TO_HOST);
+        if (phases & FFTX_MPI_PHASE_A2A)
+          fftx_mpi_alltoall(plan, stage, sendSize, plan->row_comm);
+        if (phases & FFTX_MPI_PHASE_POST)
+          pack_embed(plan, Y,                 X, plan->b * plan->shape[0], plan->shape[2] * plan->shape[4] * (is_embedded ? 2 : 1), plan->shape[1], is_embedded, plan->b * plan->M);
 #endif
       } // end FFTX_MPI_EMBED_1
       break;
@@ -277,102 +605,157 @@ void fftx_mpi_rcperm(fftx_plan plan, double * _Y, double *_X, int stage, bool is
     case FFTX_MPI_EMBED_2:
       {
         // [yl, zl, xl, xr]
-        size_t buffer_size = plan->shape[2] * plan->shape[4] * (is_embedded ? 2 : 1) * plan->shape[0] * (is_embedded ? 2 : 1) * plan->shape[1];
-        int sendSize       = plan->shape[2] * plan->shape[4] * (is_embedded ? 2 : 1) * plan->shape[0] * (is_embedded ? 2 : 1);
-        int recvSize = sendSize;
+        size_t buffer_size = fftx_mpi_stage_size(plan, stage);
+        size_t sendSize = fftx_mpi_a2a_count(plan, stage);
 
         // [yl, zl, xl, xr] -> [yl, zl, xl, yr]
         // [yl, (zl, xl), yr] -> [yl, yr, (zl, xl)]
 #if CUDA_AWARE_MPI
-        DEVICE_MEM_COPY(plan->send_buffer, X, buffer_size * sizeof(complex<double>) * plan->b, MEM_COPY_DEVICE_TO_DEVICE);
-        MPI_Alltoall(
-	  plan->send_buffer, sendSize*plan->b,
-          MPI_DOUBLE_COMPLEX,
-          plan->recv_buffer, recvSize*plan->b,
-          MPI_DOUBLE_COMPLEX,
-          plan->col_comm // TODO: make sure this is the right communicator to support non-square grid
-        );
-        pack_embed(plan, Y, plan->recv_buffer, plan->b * plan->shape[2], plan->shape[4] * (is_embedded ? 2 : 1) * plan->shape[0] * (is_embedded ? 2 : 1), plan->shape[3], is_embedded);
+        if (phases & FFTX_MPI_PHASE_PRE)
+          FFTX_MPI_COPY(plan, plan->send_buffer, X, buffer_size * sizeof(complex<double>) * plan->b, MEM_COPY_DEVICE_TO_DEVICE);
+        if (phases & FFTX_MPI_PHASE_A2A)
+          fftx_mpi_alltoall(plan, stage, sendSize, plan->col_comm);
+        if (phases & FFTX_MPI_PHASE_POST)
+          pack_embed(plan, Y, plan->recv_buffer, plan->b * plan->shape[2], plan->shape[4] * (is_embedded ? 2 : 1) * plan->shape[0] * (is_embedded ? 2 : 1), plan->shape[3], is_embedded, plan->b * plan->N);
 #else
-        DEVICE_MEM_COPY(plan->send_buffer, X, buffer_size * sizeof(complex<double>) * plan->b, MEM_COPY_DEVICE_TO_HOST);
-        MPI_Alltoall(
-	        plan->send_buffer, sendSize*plan->b,
-          MPI_DOUBLE_COMPLEX,
-          plan->recv_buffer, recvSize*plan->b,
-          MPI_DOUBLE_COMPLEX,
-          plan->col_comm // TODO: make sure this is the right communicator to support non-square grid
-        );
-        pack_embed(plan, Y, X, plan->b * plan->shape[2], plan->shape[4] * (is_embedded ? 2 : 1) * plan->shape[0] * (is_embedded ? 2 : 1), plan->shape[3], is_embedded);
+        if (phases & FFTX_MPI_PHASE_PRE)
+          FFTX_MPI_COPY(plan, plan->send_buffer, X, buffer_size * sizeof(complex<double>) * plan->b, MEM_COPY_DEVICE_TO_HOST);
+        if (phases & FFTX_MPI_PHASE_A2A)
+          fftx_mpi_alltoall(plan, stage, sendSize, plan->col_comm);
+        if (phases & FFTX_MPI_PHASE_POST)
+          pack_embed(plan, Y, X, plan->b * plan->shape[2], plan->shape[4] * (is_embedded ? 2 : 1) * plan->shape[0] * (is_embedded ? 2 : 1), plan->shape[3], is_embedded, plan->b * plan->N);
 #endif
       } // end FFTX_MPI_EMBED_2
       break;
 
     case FFTX_MPI_EMBED_3:
       {
-        // TODO: add embedded for inverse.
-        // [yl, yr, zl, xl]
-        size_t buffer_size = plan->shape[2] * plan->shape[3] * plan->shape[4] * plan->shape[0];
-        int sendSize = plan->shape[2] * plan->shape[4] * plan->shape[0];
-        int recvSize = sendSize;
+        // [yl, yr, zl, xl]; when embedded only the center yr blocks are sent.
+        size_t buffer_size = fftx_mpi_stage_size(plan, stage);
+        size_t sendSize = fftx_mpi_a2a_count(plan, stage);
         // [yl, yr, (zl, xl)] -> [yl, (zl, xl), yr]
         // [yl, zl, xl, yr] -> [yl, zl, xl, xr]
 #if CUDA_AWARE_MPI
-        unpack_embed(plan, plan->send_buffer, X, plan->b * plan->shape[2], plan->shape[4] * plan->shape[0], plan->shape[3], is_embedded);
-        MPI_Alltoall(
-	        plan->send_buffer, sendSize*plan->b,
-          MPI_DOUBLE_COMPLEX,
-	        plan->recv_buffer, recvSize*plan->b,
-          MPI_DOUBLE_COMPLEX,
-          plan->col_comm
-        ); // assume K dim is initially distributed along row comm.
-        DEVICE_MEM_COPY(Y, plan->recv_buffer, buffer_size * sizeof(complex<double>) * plan->b, MEM_COPY_DEVICE_TO_DEVICE);
+        if (phases & FFTX_MPI_PHASE_PRE)
+          unpack_embed(plan, plan->send_buffer, X, plan->b * plan->shape[2], plan->shape[4] * plan->shape[0] * (is_embedded ? 4 : 1), plan->shape[3], is_embedded, plan->b * plan->N);
+        if (phases & FFTX_MPI_PHASE_A2A)
+          fftx_mpi_alltoall(plan, stage, sendSize, plan->col_comm);
+        if (phases & FFTX_MPI_PHASE_POST)
+          FFTX_MPI_COPY(plan, Y, plan->recv_buffer, buffer_size * sizeof(complex<double>) * plan->b, MEM_COPY_DEVICE_TO_DEVICE);
 #else
-        unpack_embed(plan, Y, X, plan->b * plan->shape[2], plan->shape[4] * plan->shape[0], plan->shape[3], is_embedded);
-        MPI_Alltoall(
-	        plan->send_buffer, sendSize*plan->b,
-          MPI_DOUBLE_COMPLEX,
-	        plan->recv_buffer, recvSize*plan->b,
-          MPI_DOUBLE_COMPLEX,
-          plan->col_comm
-        ); // assume K dim is initially distributed along row comm.
-        DEVICE_MEM_COPY(Y, plan->recv_buffer, buffer_size * sizeof(complex<double>) * plan->b, MEM_COPY_HOST_TO_DEVICE);
+        if (phases & FFTX_MPI_PHASE_PRE)
+          unpack_embed(plan, Y, X, plan->b * plan->shape[2], plan->shape[4] * plan->shape[0] * (is_embedded ? 4 : 1), plan->shape[3], is_embedded, plan->b * plan->N);
+        if (phases & FFTX_MPI_PHASE_A2A)
+          fftx_mpi_alltoall(plan, stage, sendSize, plan->col_comm);
+        if (phases & FFTX_MPI_PHASE_POST)
+          FFTX_MPI_COPY(plan, Y, plan->recv_buffer, buffer_size * sizeof(complex<double>) * plan->b, MEM_COPY_HOST_TO_DEVICE);
 #endif
       } // end FFTX_MPI_EMBED_3
       break;
 
     case FFTX_MPI_EMBED_4:
       {
-        // [xl, xr, yl, zl]
-        size_t buffer_size = plan->shape[0] * plan->shape[1] * plan->shape[2] * plan->shape[4];
-        int sendSize = plan->shape[0] * plan->shape[2] * plan->shape[4];
-        int recvSize = sendSize;
+        // [xl, xr, yl, zl]; when embedded only the center xr blocks are sent.
+        size_t buffer_size = fftx_mpi_stage_size(plan, stage);
+        size_t sendSize = fftx_mpi_a2a_count(plan, stage);
 
         // [xl, xr, (yl, zl)] -> [xl, (yl, zl), xr]
         // [xl, yl, zl, xr] -> [xl, yl, zl, zr]
 #if CUDA_AWARE_MPI
-        unpack_embed(plan, plan->send_buffer, X, plan->b * plan->shape[0], plan->shape[2] * plan->shape[4], plan->shape[1], is_embedded);
-        MPI_Alltoall(
-          plan->send_buffer, sendSize*plan->b,
-          MPI_DOUBLE_COMPLEX,
-          plan->recv_buffer, recvSize*plan->b,
-          MPI_DOUBLE_COMPLEX,
-          plan->row_comm
-        ); // assume N dim is initially distributed along col comm.
-        DEVICE_MEM_COPY(Y, plan->recv_buffer, buffer_size * sizeof(complex<double>) * plan->b, MEM_COPY_DEVICE_TO_DEVICE);
+        if (phases & FFTX_MPI_PHASE_PRE)
+          unpack_embed(plan, plan->send_buffer, X, plan->b * plan->shape[0], plan->shape[2] * plan->shape[4] * (is_embedded ? 2 : 1), plan->shape[1], is_embedded, plan->b * plan->M);
+        if (phases & FFTX_MPI_PHASE_A2A)
+          fftx_mpi_alltoall(plan, stage, sendSize, plan->row_comm);
+        if (phases & FFTX_MPI_PHASE_POST)
+          FFTX_MPI_COPY(plan, Y, plan->recv_buffer, buffer_size * sizeof(complex<double>) * plan->b, MEM_COPY_DEVICE_TO_DEVICE);
 #else
-        unpack_embed(plan, Y, X, plan->b * plan->shape[0], plan->shape[2] * plan->shape[4], plan->shape[1], is_embedded);
-        MPI_Alltoall(
-          plan->send_buffer, sendSize*plan->b,
-          MPI_DOUBLE_COMPLEX,
-          plan->recv_buffer, recvSize*plan->b,
-          MPI_DOUBLE_COMPLEX,
-          plan->row_comm
-        ); // assume N dim is initially distributed along col comm.
-        DEVICE_MEM_COPY(Y, plan->recv_buffer, buffer_size * sizeof(complex<double>) * plan->b, MEM_COPY_HOST_TO_DEVICE);
+        if (phases & FFTX_MPI_PHASE_PRE)
+          unpack_embed(plan, Y, X, plan->b * plan->shape[0], plan->shape[2] * plan->shape[4] * (is_embedded ? 2 : 1), plan->shape[1], is_embedded, plan->b * plan->M);
+        if (phases & FFTX_MPI_PHASE_A2A)
+          fftx_mpi_alltoall(plan, stage, sendSize, plan->row_comm);
+        if (phases & FFTX_MPI_PHASE_POST)
+          FFTX_MPI_COPY(plan, Y, plan->recv_buffer, buffer_size * sizeof(complex<double>) * plan->b, MEM_COPY_HOST_TO_DEVICE);
 #endif
       } // end FFTX_MPI_EMBED_4
       break;
   default:
       break;
   }
-}
\ No newline at end of file
+}
+
+void fftx_mpi_rcperm(fftx_plan plan, double * Y, double *X, int stage, bool is_embedded) {
+  fftx_mpi_rcperm_phases(plan, Y, X, stage, is_embedded, FFTX_MPI_PHASE_PRE | FFTX_MPI_PHASE_A2A | FFTX_MPI_PHASE_POST);
+}
+
+// a pipeline slot stands in for the exchange buffers of a batch 1 plan.
+static void fftx_mpi_enter_slot(fftx_plan plan, int slot, complex<double> **saved, int *saved_b) {
+  size_t slot_size = plan->a2a_size / plan->b;
+  saved[0] = plan->send_buffer;
+  saved[1] = plan->recv_buffer;
+  *saved_b = plan->b;
+  plan->send_buffer = plan->pipe_send + slot * slot_size;
+  plan->recv_buffer = plan->pipe_recv + slot * slot_size;
+  plan->b = 1;
+}
+
+static void fftx_mpi_leave_slot(fftx_plan plan, complex<double> **saved, int saved_b) {
+  plan->send_buffer = saved[0];
+  plan->recv_buffer = saved[1];
+  plan->b = saved_b;
+}
+
+static MPI_Comm fftx_mpi_stage_comm(fftx_plan plan, int stage) {
+  return (stage == FFTX_MPI_EMBED_1 || stage == FFTX_MPI_EMBED_4) ? plan->row_comm : plan->col_comm;
+}
+
+void fftx_mpi_rcperm_start(fftx_plan plan, double *Y, double *X, int stage, bool is_embedded, int slot) {
+  complex<double> *saved[2];
+  int saved_b;
+  fftx_mpi_enter_slot(plan, slot, saved, &saved_b);
+
+  MPI_Comm comm = fftx_mpi_stage_comm(plan, stage);
+  int p;
+  MPI_Comm_size(comm, &p);
+  size_t count = fftx_mpi_a2a_count(plan, stage);
+
+  fftx_mpi_rcperm_phases(plan, Y, X, stage, is_embedded, FFTX_MPI_PHASE_PRE);
+  if (plan->is_float_transport) {
+    fftx_mpi_narrow(plan, count * p);
+    MPI_Ialltoall(
+      plan->recv_buffer, (int) count,
+      MPI_COMPLEX,
+      plan->send_buffer, (int) count,
+      MPI_COMPLEX,
+      comm, &(plan->pipe_req[slot])
+    );
+  } else {
+    MPI_Ialltoall(
+      plan->send_buffer, (int) count,
+      MPI_DOUBLE_COMPLEX,
+      plan->recv_buffer, (int) count,
+      MPI_DOUBLE_COMPLEX,
+      comm, &(plan->pipe_req[slot])
+    );
+  }
+  fftx_mpi_leave_slot(plan, saved, saved_b);
+}
+
+void fftx_mpi_rcperm_finish(fftx_plan plan, double *Y, double *X, int stage, bool is_embedded, int slot) {
+  complex<double> *saved[2];
+  int saved_b;
+  fftx_mpi_enter_slot(plan, slot, saved, &saved_b);
+
+  MPI_Comm comm = fftx_mpi_stage_comm(plan, stage);
+  int p;
+  MPI_Comm_size(comm, &p);
+  size_t count = fftx_mpi_a2a_count(plan, stage);
+
+  // only the wait is left by now, which is what the timer records.
+  double t = fftx_mpi_tic(plan);
+  MPI_Wait(&(plan->pipe_req[slot]), MPI_STATUS_IGNORE);
+  fftx_mpi_toc(plan, FFTX_MPI_TIMER_A2A, t, count * p * (plan->is_float_transport ? sizeof(complex<float>) : sizeof(complex<double>)));
+  if (plan->is_float_transport)
+    fftx_mpi_widen(plan, count * p);
+  fftx_mpi_rcperm_phases(plan, Y, X, stage, is_embedded, FFTX_MPI_PHASE_POST);
+  fftx_mpi_leave_slot(plan, saved, saved_b);
+}
@@ -20,11 +20,37 @@
 #define FFTX_FORWARD  1
 #define FFTX_BACKWARD 2
 
+// parts of fftx_mpi_rcperm_phases
+#define FFTX_MPI_PHASE_PRE  0x1   // stage the local data into the send buffer
+#define FFTX_MPI_PHASE_A2A  0x2   // blocking all-to-all
+#define FFTX_MPI_PHASE_POST 0x4   // permute the received data into the output
+
+// per-stage timers, see fftx_plan_timing
+#define FFTX_MPI_TIMER_FFT1   0   // local 1D FFTs of stage 1 (Z for 2D plans, X for 1D plans)
+#define FFTX_MPI_TIMER_FFT2   1   // local 1D FFTs of stage 2
+#define FFTX_MPI_TIMER_FFT3   2   // local 1D FFTs of stage 3
+#define FFTX_MPI_TIMER_PACK   3   // device permutes after an exchange
+#define FFTX_MPI_TIMER_UNPACK 4   // device permutes before an exchange
+#define FFTX_MPI_TIMER_COPY   5   // host <-> device and staging copies
+#define FFTX_MPI_TIMER_A2A    6   // all-to-all, start to completion
+#define FFTX_MPI_NUM_TIMERS   7
+
+// plan flags for fftx_plan_distributed
+#define FFTX_MPI_LOW_MEMORY 0x1   // use the output buffer as stage scratch instead of Q3
+#define FFTX_MPI_FLOAT_TRANSPORT 0x2   // exchange complex<float>, compute in double
+
 using namespace std;
 
 #define CPU_PERMUTE 0     //Todo: Fix CPU PERMUTE to work with batch + embedded
 #define CUDA_AWARE_MPI 0
 
+// MPI-4 persistent all-to-all, set up once per plan; older MPIs call MPI_Alltoall.
+#if defined(MPI_VERSION) && MPI_VERSION >= 4
+#define FFTX_MPI_PERSISTENT 1
+#else
+#define FFTX_MPI_PERSISTENT 0
+#endif
+
 // implement on GPU.
 // [A, B, C] -> [B, A, C]
 // launch with c thread blocks? can change parallelism if that's too much
@@ -39,24 +65,139 @@ struct fftx_plan_t {
   bool is_forward;
   bool is_complex;
   bool use_fftx;
+  bool is_low_memory;
+  bool is_float_transport;
+  MPI_Comm plan_comm; // duplicate of the communicator passed at plan time.
   MPI_Comm row_comm, col_comm;
+  MPI_Request a2a_req[4]; // persistent all-to-all, one per FFTX_MPI_EMBED_* stage.
+  bool is_timed;
+  double timer_sec[FFTX_MPI_NUM_TIMERS];
+  size_t timer_bytes[FFTX_MPI_NUM_TIMERS];
+  int timer_calls[FFTX_MPI_NUM_TIMERS];
+  int pipeline_depth; // batch elements between pipeline stages, 0 when off.
+  complex<double> *pipe_send, *pipe_recv; // 2 * (depth + 1) single element exchange slots.
+  MPI_Request *pipe_req;
+  void *stages; // backend kernel objects, host slab plans only.
   size_t shape[6]; // used for buffers for A2A.
   int M, N, K; // used for FFT sizes.
+  size_t buffer_size; // complex elements in each of Q3 and Q4.
+  size_t a2a_size;    // complex elements in each of the A2A buffers.
+  size_t workspace;   // bytes allocated by the plan for Q3, Q4 and the A2A buffers.
   DEVICE_FFT_HANDLE stg3, stg2, stg1;
   DEVICE_FFT_HANDLE stg2i, stg1i;
 };
 
 typedef fftx_plan_t* fftx_plan;
 
-void init_2d_comms(fftx_plan plan, int rr, int cc, int M, int N, int K);
+// timer statistics across the ranks of a plan; bytes are summed over ranks.
+struct fftx_mpi_timer_stats_t {
+  double min, max, avg;
+  size_t bytes;
+  int calls;
+};
+
+// timing is off by default; when on, each timed region is bracketed by
+// device synchronizations, so leave it off for production runs.
+inline double fftx_mpi_tic(fftx_plan plan) {
+  if (!plan->is_timed)
+    return 0.0;
+  DEVICE_SYNCHRONIZE();
+  return MPI_Wtime();
+}
+
+inline void fftx_mpi_toc(fftx_plan plan, int timer, double start, size_t bytes) {
+  if (!plan->is_timed)
+    return;
+  DEVICE_SYNCHRONIZE();
+  plan->timer_sec[timer]   += MPI_Wtime() - start;
+  plan->timer_bytes[timer] += bytes;
+  plan->timer_calls[timer] += 1;
+}
+
+// DEVICE_MEM_COPY, accounted to FFTX_MPI_TIMER_COPY.
+#define FFTX_MPI_COPY(plan, dst, src, bytes, kind) do {   \
+    double fftx_copy_t = fftx_mpi_tic(plan);              \
+    DEVICE_MEM_COPY(dst, src, bytes, kind);               \
+    fftx_mpi_toc(plan, FFTX_MPI_TIMER_COPY, fftx_copy_t, bytes); \
+  } while (0)
+
+void init_2d_comms(fftx_plan plan, int rr, int cc, int M, int N, int K, MPI_Comm comm = MPI_COMM_WORLD);
 void destroy_2d_comms(fftx_plan plan);
 
-fftx_plan  fftx_plan_distributed(int r, int c, int M, int N, int K, int batch, bool is_embedded, bool is_complex);
+// with FFTX_MPI_LOW_MEMORY set in flags, out_buffer doubles as stage scratch and
+// must hold plan->buffer_size complex elements; the input buffer is not modified.
+// Only Q3 is saved: the plan still holds Q4 (buffer_size complex elements) and
+// the send and receive buffers (a2a_size each, on the host unless
+// CUDA_AWARE_MPI), which the persistent all-to-alls bind at plan time.
+// fftx_plan_workspace reports all three.
+// the r x c grid is laid out over the ranks of comm, which must have r*c ranks.
+fftx_plan  fftx_plan_distributed(int r, int c, int M, int N, int K, int batch, bool is_embedded, bool is_complex, int flags = 0, MPI_Comm comm = MPI_COMM_WORLD);
 void fftx_execute(fftx_plan plan, double* out_buffer, double*in_buffer,int direction);
 void fftx_plan_destroy(fftx_plan plan);
+// bytes of host and device memory held by the plan, excluding vendor FFT plans.
+size_t fftx_plan_workspace(fftx_plan plan);
+
+// plan cache, off by default. When enabled, the planners return a shared plan
+// when grid, sizes, batch, embedded, complex and flags match an earlier plan on
+// a communicator with the same ranks in the same order (MPI_IDENT or
+// MPI_CONGRUENT), such as a duplicate, and fftx_plan_destroy only drops a
+// reference. Unreferenced plans stay cached until fftx_plan_cache_clear, which
+// is collective like fftx_plan_destroy. The cache is guarded by a lock, but
+// planning is collective, so threads must not plan on one communicator at once.
+// The pipeline depth and the timers belong to the shared plan, not to a handle,
+// so fftx_plan_pipeline, fftx_plan_timing and fftx_plan_timers_reset exit with
+// an error while a plan has more than one reference. Set them before the plan
+// is looked up again, or plan with the cache off.
+void fftx_plan_cache_enable(bool enable);
+void fftx_plan_cache_clear();
+// true while the cache holds more than one reference to plan.
+bool fftx_plan_is_shared(fftx_plan plan);
+// returns a cached plan with one more reference, or NULL.
+fftx_plan fftx_plan_cache_lookup(int r, int c, int M, int N, int K, int batch, bool is_embedded, bool is_complex, int flags, MPI_Comm comm);
+void fftx_plan_cache_insert(fftx_plan plan, int r, int c, int M, int N, int K, int batch, bool is_embedded, bool is_complex, int flags, MPI_Comm comm);
+
+// pipeline the batch of a 2D plan with depth > 0: element j runs its first
+// FFT stage while element j - depth is in the first exchange and element
+// j - 2 depth in the second. Allocates 2 (depth + 1) single element exchange
+// slots; depth 0 turns pipelining off. Not for FFTX_MPI_LOW_MEMORY plans.
+void fftx_plan_pipeline(fftx_plan plan, int depth);
 
-void pack_embed(fftx_plan plan, complex<double> *dst, complex<double> *src, size_t a, size_t b, size_t c, bool is_embedded);
+// distributed convolution, out = IFFT(symbol .* FFT(in)), unnormalized like
+// rconv. The real symbol holds fftx_plan_spectral_size(plan) values per rank in
+// the layout of the plan's forward output, and is shared by the whole batch.
+// The spectrum stays in the plan's buffers, so each call runs four all-to-alls.
+// 2D plans only; not available with FFTX_MPI_LOW_MEMORY.
+size_t fftx_plan_spectral_size(fftx_plan plan);
+void fftx_execute_rconv(fftx_plan plan, double *out_buffer, double *in_buffer, double *symbol);
+
+// enable or disable the per-stage timers of a plan, and clear them.
+void fftx_plan_timing(fftx_plan plan, bool enable);
+void fftx_plan_timers_reset(fftx_plan plan);
+// collective over the plan's communicator; fills FFTX_MPI_NUM_TIMERS entries.
+void fftx_plan_timers(fftx_plan plan, fftx_mpi_timer_stats_t *stats);
+// collective; the first rank of the plan writes the statistics as JSON to out.
+void fftx_plan_timers_json(fftx_plan plan, FILE *out);
+
+// perm: [a, b, c] -> [a, c, b]; when n > 0 only the first n elements of each
+// (a, c) pencil are kept, dropping the padding of uneven block distributions.
+void pack_embed(fftx_plan plan, complex<double> *dst, complex<double> *src, size_t a, size_t b, size_t c, bool is_embedded, size_t n = 0);
 void fftx_mpi_rcperm(fftx_plan plan, double * _Y, double *_X, int stage, bool is_embedded);
+void fftx_mpi_rcperm_phases(fftx_plan plan, double * _Y, double *_X, int stage, bool is_embedded, int phases);
+// split phase fftx_mpi_rcperm of one batch element through pipeline slot slot.
+void fftx_mpi_rcperm_start(fftx_plan plan, double *Y, double *X, int stage, bool is_embedded, int slot);
+void fftx_mpi_rcperm_finish(fftx_plan plan, double *Y, double *X, int stage, bool is_embedded, int slot);
+
+// all-to-all of count complex values per rank from send_buffer to recv_buffer.
+// fftx_mpi_alltoall_init is collective and called at plan time for each stage;
+// the count and communicator passed to fftx_mpi_alltoall must match it.
+// with float transport the values are narrowed into recv_buffer, exchanged
+// into send_buffer, and widened back into recv_buffer.
+size_t fftx_mpi_a2a_count(fftx_plan plan, int stage);
+// complex elements a 2D stage copies through the exchange buffers, per batch element.
+size_t fftx_mpi_stage_size(fftx_plan plan, int stage);
+void fftx_mpi_alltoall_init(fftx_plan plan, int stage, size_t count, MPI_Comm comm);
+void fftx_mpi_alltoall(fftx_plan plan, int stage, size_t count, MPI_Comm comm);
+void fftx_mpi_alltoall_free(fftx_plan plan);
 
 #include "fftx_mpi_spiral.hpp"
 #include "fftx_mpi_default.hpp"
@@ -12,22 +12,31 @@
 using namespace std;
 
 
-fftx_plan fftx_plan_distributed_default(int r, int c, int M, int N, int K, int batch, bool is_embedded, bool is_complex) {
+fftx_plan fftx_plan_distributed_default(int r, int c, int M, int N, int K, int batch, bool is_embedded, bool is_complex, int flags, MPI_Comm comm) {
 
   fftx_plan plan = (fftx_plan) malloc(sizeof(fftx_plan_t));
 
   plan->b = batch;
   plan->is_embed = is_embedded;
   plan->is_complex = is_complex;
+  plan->is_low_memory = (flags & FFTX_MPI_LOW_MEMORY) != 0;
+  plan->is_float_transport = (flags & FFTX_MPI_FLOAT_TRANSPORT) != 0;
 
-  init_2d_comms(plan, r, c,  M,  N, K);   //embedding uses the input sizes
+  init_2d_comms(plan, r, c,  M,  N, K, comm);   //embedding uses the input sizes
 
-  DEVICE_MALLOC(&(plan->Q3), M*N*K*(is_embedded ? 8 : 1) / (r * c) * sizeof(complex<double>) * batch);
-  DEVICE_MALLOC(&(plan->Q4), M*N*K*(is_embedded ? 8 : 1) / (r * c) * sizeof(complex<double>) * batch);
+  // low memory plans ping-pong between Q4 and the caller's output buffer.
+  plan->Q3 = NULL;
+  if (!plan->is_low_memory) {
+    DEVICE_MALLOC(&(plan->Q3), plan->buffer_size * sizeof(complex<double>));
+    plan->workspace += plan->buffer_size * sizeof(complex<double>);
+  }
+  DEVICE_MALLOC(&(plan->Q4), plan->buffer_size * sizeof(complex<double>));
+  plan->workspace += plan->buffer_size * sizeof(complex<double>);
 
-  int batch_sizeZ = M/r * N/c;
-  int batch_sizeX = N/c * K/r;
-  int batch_sizeY = K/r * M/c;
+  // local pencil counts, including any padding pencils of uneven grids.
+  int batch_sizeZ = plan->shape[0] * plan->shape[2];
+  int batch_sizeX = plan->shape[2] * plan->shape[4];
+  int batch_sizeY = plan->shape[4] * plan->shape[0];
 
   int inK = K * (is_embedded ? 2 : 1);
   int inM = M * (is_embedded ? 2 : 1);
@@ -95,46 +104,59 @@ fftx_plan fftx_plan_distributed_default(int r, int c, int M, int N, int K, int b
 }
 
 void fftx_execute_default(fftx_plan plan, double* out_buffer, double*in_buffer, int direction) {
+  // stage scratch; a low memory plan borrows the output buffer instead of Q3.
+  double *Q3 = plan->is_low_memory ? out_buffer : plan->Q3;
+
+  double t = fftx_mpi_tic(plan);
   if (direction == DEVICE_FFT_FORWARD) {
     if (plan->is_complex) {
       for (int i = 0; i != plan->b; ++i) {
-        DEVICE_FFT_EXECZ2Z(plan->stg1, ((DEVICE_FFT_DOUBLECOMPLEX  *) in_buffer + i), ((DEVICE_FFT_DOUBLECOMPLEX  *) plan->Q3 + i), direction);
+        DEVICE_FFT_EXECZ2Z(plan->stg1, ((DEVICE_FFT_DOUBLECOMPLEX  *) in_buffer + i), ((DEVICE_FFT_DOUBLECOMPLEX  *) Q3 + i), direction);
       }
     } else {
       for (int i = 0; i != plan->b; ++i) {
-        DEVICE_FFT_EXECD2Z(plan->stg1, ((DEVICE_FFT_DOUBLEREAL  *) in_buffer + i), ((DEVICE_FFT_DOUBLECOMPLEX  *) plan->Q3 + i));
+        DEVICE_FFT_EXECD2Z(plan->stg1, ((DEVICE_FFT_DOUBLEREAL  *) in_buffer + i), ((DEVICE_FFT_DOUBLECOMPLEX  *) Q3 + i));
       }
     }
 
-    fftx_mpi_rcperm(plan, plan->Q4, plan->Q3, FFTX_MPI_EMBED_1, plan->is_embed);
+    fftx_mpi_toc(plan, FFTX_MPI_TIMER_FFT1, t, 0);
+    fftx_mpi_rcperm(plan, plan->Q4, Q3, FFTX_MPI_EMBED_1, plan->is_embed);
+    t = fftx_mpi_tic(plan);
 
     for (int i = 0; i != plan->b; ++i) {
-      DEVICE_FFT_EXECZ2Z(plan->stg2, ((DEVICE_FFT_DOUBLECOMPLEX  *) plan->Q4 + i), ((DEVICE_FFT_DOUBLECOMPLEX  *) plan->Q3 + i), direction);
+      DEVICE_FFT_EXECZ2Z(plan->stg2, ((DEVICE_FFT_DOUBLECOMPLEX  *) plan->Q4 + i), ((DEVICE_FFT_DOUBLECOMPLEX  *) Q3 + i), direction);
     }
 
-    fftx_mpi_rcperm(plan, plan->Q4, plan->Q3, FFTX_MPI_EMBED_2, plan->is_embed);
+    fftx_mpi_toc(plan, FFTX_MPI_TIMER_FFT2, t, 0);
+    fftx_mpi_rcperm(plan, plan->Q4, Q3, FFTX_MPI_EMBED_2, plan->is_embed);
+    t = fftx_mpi_tic(plan);
 
     for (int i = 0; i != plan->b; ++i) {
       DEVICE_FFT_EXECZ2Z(plan->stg3, ((DEVICE_FFT_DOUBLECOMPLEX  *) plan->Q4 + i), ((DEVICE_FFT_DOUBLECOMPLEX  *) out_buffer + i), direction);
     }
+    fftx_mpi_toc(plan, FFTX_MPI_TIMER_FFT3, t, 0);
 
   } else if (direction == DEVICE_FFT_INVERSE) {
     for (int i = 0; i != plan->b; ++i) {
       DEVICE_FFT_EXECZ2Z(
         plan->stg3,
         ((DEVICE_FFT_DOUBLECOMPLEX  *) in_buffer + i),
-        ((DEVICE_FFT_DOUBLECOMPLEX  *) plan->Q3 + i),
+        ((DEVICE_FFT_DOUBLECOMPLEX  *) Q3 + i),
         direction
       );
     }
 
-    fftx_mpi_rcperm(plan, plan->Q4, plan->Q3, FFTX_MPI_EMBED_3, plan->is_embed);
+    fftx_mpi_toc(plan, FFTX_MPI_TIMER_FFT3, t, 0);
+    fftx_mpi_rcperm(plan, plan->Q4, Q3, FFTX_MPI_EMBED_3, plan->is_embed);
+    t = fftx_mpi_tic(plan);
 
     for (int i = 0; i != plan->b; ++i){
-      DEVICE_FFT_EXECZ2Z(plan->stg2i, ((DEVICE_FFT_DOUBLECOMPLEX  *) plan->Q4 + i), ((DEVICE_FFT_DOUBLECOMPLEX  *) plan->Q3 + i), direction);
+      DEVICE_FFT_EXECZ2Z(plan->stg2i, ((DEVICE_FFT_DOUBLECOMPLEX  *) plan->Q4 + i), ((DEVICE_FFT_DOUBLECOMPLEX  *) Q3 + i), direction);
     }
 
-    fftx_mpi_rcperm(plan, plan->Q4, plan->Q3, FFTX_MPI_EMBED_4, plan->is_embed);
+    fftx_mpi_toc(plan, FFTX_MPI_TIMER_FFT2, t, 0);
+    fftx_mpi_rcperm(plan, plan->Q4, Q3, FFTX_MPI_EMBED_4, plan->is_embed);
+    t = fftx_mpi_tic(plan);
 
     if (plan->is_complex) {
       for (int i = 0; i != plan->b; ++i) {
@@ -145,6 +167,7 @@ void fftx_execute_default(fftx_plan plan, double* out_buffer, double*in_buffer,
         DEVICE_FFT_EXECZ2D(plan->stg1i, ((DEVICE_FFT_DOUBLECOMPLEX  *) plan->Q4 + i), ((DEVICE_FFT_DOUBLEREAL  *) out_buffer + i));
       }
     }
+    fftx_mpi_toc(plan, FFTX_MPI_TIMER_FFT1, t, 0);
   }
 }
 
@@ -156,7 +179,8 @@ void fftx_plan_destroy_default(fftx_plan plan) {
     else
       destroy_2d_comms(plan);
 
-    DEVICE_FREE(plan->Q3);
+    if (plan->Q3)
+      DEVICE_FREE(plan->Q3);
     DEVICE_FREE(plan->Q4);
 
     free(plan);
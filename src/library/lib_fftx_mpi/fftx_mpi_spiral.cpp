@@ -16,8 +16,8 @@
 #include "ibatch2ddftObj.hpp"
 #include "batch1dprdftObj.hpp"
 #include "ibatch1dprdftObj.hpp"
-// #include "batch2dprdftObj.hpp"
-// #include "ibatch2dprdftObj.hpp"
+#include "batch2dprdftObj.hpp"
+#include "ibatch2dprdftObj.hpp"
 #if defined FFTX_CUDA
 #include "cudabackend.hpp"
 #elif defined FFTX_HIP
@@ -29,47 +29,108 @@
 
 using namespace std;
 
-fftx_plan fftx_plan_distributed_spiral(int r, int c, int M, int N, int K, int batch, bool is_embedded, bool is_complex) {
+fftx_plan fftx_plan_distributed_spiral(int r, int c, int M, int N, int K, int batch, bool is_embedded, bool is_complex, int flags, MPI_Comm comm) {
 
   fftx_plan plan = (fftx_plan) malloc(sizeof(fftx_plan_t));
 
   plan->b = batch;
   plan->is_embed = is_embedded;
   plan->is_complex = is_complex;
+  plan->is_low_memory = (flags & FFTX_MPI_LOW_MEMORY) != 0;
+  plan->is_float_transport = (flags & FFTX_MPI_FLOAT_TRANSPORT) != 0;
   plan->M = M;
   plan->N = N;
   plan->K = K;
 
-  init_2d_comms(plan, r, c,  M,  N, K);   //embedding uses the input sizes
+  init_2d_comms(plan, r, c,  M,  N, K, comm);   //embedding uses the input sizes
 
-  DEVICE_MALLOC(&(plan->Q3), M*N*K*(is_embedded ? 8 : 1) / (r * c) * sizeof(complex<double>) * batch);
-  DEVICE_MALLOC(&(plan->Q4), M*N*K*(is_embedded ? 8 : 1) / (r * c) * sizeof(complex<double>) * batch);
-
-  // int batch_sizeZ = M/r * N/c;
-  int batch_sizeX = N/c * K/r;
-  int batch_sizeY = K/r * M/c;
-
-  // int inK = K * (is_embedded ? 2 : 1);
-  // int inM = M * (is_embedded ? 2 : 1);
-  // int inN = N * (is_embedded ? 2 : 1);
+  // low memory plans ping-pong between Q4 and the caller's output buffer.
+  plan->Q3 = NULL;
+  if (!plan->is_low_memory) {
+    DEVICE_MALLOC(&(plan->Q3), plan->buffer_size * sizeof(complex<double>));
+    plan->workspace += plan->buffer_size * sizeof(complex<double>);
+  }
+  DEVICE_MALLOC(&(plan->Q4), plan->buffer_size * sizeof(complex<double>));
+  plan->workspace += plan->buffer_size * sizeof(complex<double>);
 
+  return plan;
+}
 
-  // int outK = K * (is_embedded ? 2 : 1);
-  // int outM = M * (is_embedded ? 2 : 1);
-  // int outN = N * (is_embedded ? 2 : 1);
+static bool fftx_mpi_is_pipelined(fftx_plan plan, double *symbol) {
+  return plan->pipeline_depth > 0 && plan->b > 1 && symbol == NULL;
+}
 
+// one local FFT stage, timed as timer.
+static void fftx_mpi_stage(fftx_plan plan, FFTXProblem &stage, double *out, double *in, int timer) {
+  double t = fftx_mpi_tic(plan);
+  #if defined FFTX_CUDA
+  std::vector<void*> args{&out, &in};
+  #else
+  std::vector<void*> args{out, in};
+  #endif
+  stage.setArgs(args);
+  stage.transform();
+  fftx_mpi_toc(plan, timer, t, 0);
+}
 
-  batch_sizeX *= (is_embedded ? 2 : 1);
-  batch_sizeY *= (is_embedded ? 4 : 1);
+// runs the batch one element at a time through stage_a, exchange ex_a, stage_b,
+// exchange ex_b and stage_c. Element j is in stage_a while element j - d waits
+// on ex_a and element j - 2d on ex_b, so the exchanges of d elements are in
+// flight behind the FFTs. Q3 and Q4 serve as single element scratch.
+static void fftx_mpi_pipeline(
+  fftx_plan plan, double *out, double *in,
+  size_t n_in, size_t w_in, size_t n_out, size_t w_out,
+  FFTXProblem &stage_a, FFTXProblem &stage_b, FFTXProblem &stage_c,
+  int ex_a, int ex_b
+) {
+  int d = plan->pipeline_depth;
+  int b = plan->b;
+  double *S0 = plan->Q3;
+  double *S1 = plan->Q4;
+  int timer_a = ex_a == FFTX_MPI_EMBED_1 ? FFTX_MPI_TIMER_FFT1 : FFTX_MPI_TIMER_FFT3;
+  int timer_c = ex_a == FFTX_MPI_EMBED_1 ? FFTX_MPI_TIMER_FFT3 : FFTX_MPI_TIMER_FFT1;
 
-  return plan;
+  for (int j = 0; j < b + 2 * d; j++) {
+    int k1 = j - d;
+    int k2 = j - 2 * d;
+    if (j < b) {
+      DEVICE_ERROR_T err = extract_batch(S0, in, n_in, b, j, w_in);
+      if (err != DEVICE_SUCCESS) {
+        fprintf(stderr, "extract_batch failed!\n");
+        exit(-1);
+      }
+      fftx_mpi_stage(plan, stage_a, S1, S0, timer_a);
+      fftx_mpi_rcperm_start(plan, S0, S1, ex_a, plan->is_embed, j % (d + 1));
+    }
+    if (k1 >= 0 && k1 < b) {
+      fftx_mpi_rcperm_finish(plan, S0, S1, ex_a, plan->is_embed, k1 % (d + 1));
+      fftx_mpi_stage(plan, stage_b, S1, S0, FFTX_MPI_TIMER_FFT2);
+      fftx_mpi_rcperm_start(plan, S0, S1, ex_b, plan->is_embed, d + 1 + k1 % (d + 1));
+    }
+    if (k2 >= 0) {
+      fftx_mpi_rcperm_finish(plan, S0, S1, ex_b, plan->is_embed, d + 1 + k2 % (d + 1));
+      fftx_mpi_stage(plan, stage_c, S1, S0, timer_c);
+      DEVICE_ERROR_T err = insert_batch(out, S1, n_out, b, k2, w_out);
+      if (err != DEVICE_SUCCESS) {
+        fprintf(stderr, "insert_batch failed!\n");
+        exit(-1);
+      }
+    }
+  }
 }
 
-void fftx_execute_spiral(fftx_plan plan, double* out_buffer, double*in_buffer, int direction)
+void fftx_execute_spiral(fftx_plan plan, double* out_buffer, double*in_buffer, int direction, double *symbol)
 {
-  int batch_sizeZ = plan->M/plan->r * plan->N/plan->c;
-  int batch_sizeX = plan->N/plan->c * plan->K/plan->r;
-  int batch_sizeY = plan->K/plan->r * plan->M/plan->c;
+  // stage scratch; a low memory plan borrows the output buffer instead of Q3.
+  double *Q3 = plan->is_low_memory ? out_buffer : plan->Q3;
+  double *Q4 = plan->Q4;
+  // a convolution keeps the spectrum in Q3 instead of writing it out.
+  double *fwd_out = symbol ? Q3 : out_buffer;
+
+  // local pencil counts, including any padding pencils of uneven grids.
+  int batch_sizeZ = plan->shape[0] * plan->shape[2];
+  int batch_sizeX = plan->shape[2] * plan->shape[4];
+  int batch_sizeY = plan->shape[4] * plan->shape[0];
 
   int inK = plan->K * (plan->is_embed ? 2 : 1);
   int inM = plan->M * (plan->is_embed ? 2 : 1);
@@ -93,16 +154,18 @@ void fftx_execute_spiral(fftx_plan plan, double* out_buffer, double*in_buffer, i
   BATCH1DPRDFTProblem bprdstg1;
   IBATCH1DPRDFTProblem ibprdstg1;
 
-  // BATCH2DPRDFTProblem b2prdstg1;
-  // IBATCH2DPRDFTProblem ib2prdstg1;
+  BATCH2DPRDFTProblem b2prdstg1;
+  IBATCH2DPRDFTProblem ib2prdstg1;
 
   std::vector<int> size_stg1; 
   std::vector<int> size_stg2;
   std::vector<int> size_stg3;  
   std::vector<int> size_istg1;
   std::vector<int> size_istg2;
+  // a pipelined batch runs the single transform kernels on one element at a time.
+  bool per_element = plan->b == 1 || fftx_mpi_is_pipelined(plan, symbol);
   if(plan->is_complex) {
-    if(plan->b == 1) {
+    if(per_element) {
       size_stg1 = {inK, batch_sizeZ, 0, 1}; 
       size_stg2 = {inM, batch_sizeX, 0, 1};
       size_stg3 = {inN, batch_sizeY, 0, 0};  
@@ -136,7 +199,7 @@ void fftx_execute_spiral(fftx_plan plan, double* out_buffer, double*in_buffer, i
       ib2dstg2.setName("ib2dft");
     }
   } else {
-    if(plan->b == 1) {
+    if(per_element) {
       size_stg1 = {inK, batch_sizeZ, 0, 1}; 
       size_stg2 = {inM, batch_sizeX, 0, 1};
       size_stg3 = {inN, batch_sizeY, 0, 0};  
@@ -152,40 +215,63 @@ void fftx_execute_spiral(fftx_plan plan, double* out_buffer, double*in_buffer, i
       bdstg3.setName("b1dft");
       ibprdstg1.setName("ib1prdft");
       ibdstg2.setName("ib1dft");
-    } 
-    // else {
-    //   size_stg1 = {inK,  plan->b, batch_sizeZ, 0, 1}; 
-    //   size_stg2 = {inM, plan->b, batch_sizeX, 0, 1};
-    //   size_stg3 = {inN, plan->b, batch_sizeY, 0, 0};  
-    //   size_istg1 = {inK, plan->b, batch_sizeZ, 1, 0};
-    //   size_istg2 = {inM,plan->b, batch_sizeX, 1, 0}; 
-    //   b2prdstg1.setSizes(size_stg1);
-    //   b2dstg2.setSizes(size_stg2);
-    //   b2dstg3.setSizes(size_stg3);
-    //   ib2prdstg1.setSizes(size_istg1);
-    //   ib2dstg2.setSizes(size_istg2);
-    //   b2prdstg1.setName("b2dft");
-    //   b2dstg2.setName("b2dft");
-    //   b2dstg3.setName("b2dft");
-    //   ib2prdstg1.setName("ib2dft");
-    //   ib2dstg2.setName("ib2dft");
-    // }
+    } else {
+      // the batch is interleaved with each pencil, so every all-to-all below
+      // carries all plan->b transforms in a single exchange.
+      size_stg1 = {inK,  plan->b, batch_sizeZ, 0, 1}; 
+      size_stg2 = {inM, plan->b, batch_sizeX, 0, 1};
+      size_stg3 = {inN, plan->b, batch_sizeY, 0, 0};  
+      size_istg1 = {inK, plan->b, batch_sizeZ, 1, 0};
+      size_istg2 = {inM,plan->b, batch_sizeX, 1, 0}; 
+      b2prdstg1.setSizes(size_stg1);
+      b2dstg2.setSizes(size_stg2);
+      b2dstg3.setSizes(size_stg3);
+      ib2prdstg1.setSizes(size_istg1);
+      ib2dstg2.setSizes(size_istg2);
+      b2prdstg1.setName("b2prdft");
+      b2dstg2.setName("b2dft");
+      b2dstg3.setName("b2dft");
+      ib2prdstg1.setName("ib2prdft");
+      ib2dstg2.setName("ib2dft");
+    }
   }
+  if (fftx_mpi_is_pipelined(plan, symbol)) {
+    // per element sizes, in values; complex input and all spectra are 2 doubles wide.
+    size_t n_space = (size_t) batch_sizeZ * inK;
+    size_t n_freq  = (size_t) batch_sizeY * inN;
+    size_t w_space = plan->is_complex ? 2 : 1;
+    if (direction == DEVICE_FFT_FORWARD) {
+      fftx_mpi_pipeline(
+        plan, out_buffer, in_buffer, n_space, w_space, n_freq, 2,
+        plan->is_complex ? (FFTXProblem &) bdstg1 : (FFTXProblem &) bprdstg1, bdstg2, bdstg3,
+        FFTX_MPI_EMBED_1, FFTX_MPI_EMBED_2
+      );
+    } else {
+      fftx_mpi_pipeline(
+        plan, out_buffer, in_buffer, n_freq, 2, n_space, w_space,
+        bdstg3, ibdstg2, plan->is_complex ? (FFTXProblem &) ibdstg1 : (FFTXProblem &) ibprdstg1,
+        FFTX_MPI_EMBED_3, FFTX_MPI_EMBED_4
+      );
+    }
+    return;
+  }
+
+  double t = fftx_mpi_tic(plan);
   if (direction == DEVICE_FFT_FORWARD) {
     if (plan->is_complex) {
       if(plan->b == 1) {
         #if defined FFTX_CUDA
-        std::vector<void*> args{&plan->Q3, &in_buffer};
+        std::vector<void*> args{&Q3, &in_buffer};
         #else
-        std::vector<void*> args{plan->Q3, in_buffer};
+        std::vector<void*> args{Q3, in_buffer};
         #endif
         bdstg1.setArgs(args);
         bdstg1.transform();
       } else{
         #if defined FFTX_CUDA
-        std::vector<void*> args{&plan->Q3, &in_buffer};
+        std::vector<void*> args{&Q3, &in_buffer};
         #else
-        std::vector<void*> args{plan->Q3, in_buffer};
+        std::vector<void*> args{Q3, in_buffer};
         #endif
         b2dstg1.setArgs(args);
         b2dstg1.transform();
@@ -193,114 +279,139 @@ void fftx_execute_spiral(fftx_plan plan, double* out_buffer, double*in_buffer, i
     } else {
       if(plan->b == 1) {
         #if defined FFTX_CUDA
-        std::vector<void*> args{&plan->Q3, &in_buffer};
+        std::vector<void*> args{&Q3, &in_buffer};
         #else
-        std::vector<void*> args{plan->Q3, in_buffer};
+        std::vector<void*> args{Q3, in_buffer};
         #endif
         bprdstg1.setArgs(args);
         bprdstg1.transform();
-      } 
-      // else{
-      //   #if defined FFTX_CUDA
-      //   std::vector<void*> args{&plan->Q3, &in_buffer};
-      //   #else
-      //   std::vector<void*> args{plan->Q3, in_buffer};
-      //   #endif
-      //   b2prdstg1.setArgs(args);
-      //   b2prdstg1.transform();
-      // }
+      } else {
+        #if defined FFTX_CUDA
+        std::vector<void*> args{&Q3, &in_buffer};
+        #else
+        std::vector<void*> args{Q3, in_buffer};
+        #endif
+        b2prdstg1.setArgs(args);
+        b2prdstg1.transform();
+      }
     }
 
-    fftx_mpi_rcperm(plan, plan->Q4, plan->Q3, FFTX_MPI_EMBED_1, plan->is_embed);
+    fftx_mpi_toc(plan, FFTX_MPI_TIMER_FFT1, t, 0);
+    fftx_mpi_rcperm(plan, Q4, Q3, FFTX_MPI_EMBED_1, plan->is_embed);
+    t = fftx_mpi_tic(plan);
     
     if(plan->b == 1) {
       #if defined FFTX_CUDA
-      std::vector<void*> args{&plan->Q3, &plan->Q4};
+      std::vector<void*> args{&Q3, &Q4};
       #else
-      std::vector<void*> args{plan->Q3, plan->Q4};
+      std::vector<void*> args{Q3, Q4};
       #endif
       bdstg2.setArgs(args);
       bdstg2.transform();
     } else {
       #if defined FFTX_CUDA
-      std::vector<void*> args{&plan->Q3, &plan->Q4};
+      std::vector<void*> args{&Q3, &Q4};
       #else
-      std::vector<void*> args{plan->Q3, plan->Q4};
+      std::vector<void*> args{Q3, Q4};
       #endif
       b2dstg2.setArgs(args);
       b2dstg2.transform();
     }
 
-    fftx_mpi_rcperm(plan, plan->Q4, plan->Q3, FFTX_MPI_EMBED_2, plan->is_embed);
+    fftx_mpi_toc(plan, FFTX_MPI_TIMER_FFT2, t, 0);
+    fftx_mpi_rcperm(plan, Q4, Q3, FFTX_MPI_EMBED_2, plan->is_embed);
+    t = fftx_mpi_tic(plan);
     if(plan->b == 1) {
       #if defined FFTX_CUDA
-      std::vector<void*> args{&out_buffer, &plan->Q4};
+      std::vector<void*> args{&fwd_out, &Q4};
       #else
-      std::vector<void*> args{out_buffer, plan->Q4};
+      std::vector<void*> args{fwd_out, Q4};
       #endif
       bdstg3.setArgs(args);
       bdstg3.transform();
     } else {
       #if defined FFTX_CUDA
-      std::vector<void*> args{&out_buffer, &plan->Q4};
+      std::vector<void*> args{&fwd_out, &Q4};
       #else
-      std::vector<void*> args{out_buffer, plan->Q4};
+      std::vector<void*> args{fwd_out, Q4};
       #endif
       b2dstg3.setArgs(args);
       b2dstg3.transform();
     }
-  } else if (direction == DEVICE_FFT_INVERSE) {
+    fftx_mpi_toc(plan, FFTX_MPI_TIMER_FFT3, t, 0);
+  }
+  if (symbol != NULL) {
+    // scale the spectrum in the Y pencil layout of forward stage 3, then run the
+    // inverse stages from it with Q3 and Q4 swapped, so the spectrum is never
+    // permuted back to the input layout. The inverse X and Z FFTs still need the
+    // exchanges of stages 3 and 4, so a convolution does four in all.
+    DEVICE_ERROR_T err = pointwise_real((complex<double> *) Q3, symbol, (size_t) batch_sizeY * inN, plan->b);
+    if (err != DEVICE_SUCCESS) {
+      fprintf(stderr, "pointwise_real failed!\n");
+      exit(-1);
+    }
+    in_buffer = Q3;
+    Q3 = plan->Q4;
+    Q4 = plan->Q3;
+    direction = DEVICE_FFT_INVERSE;
+    t = fftx_mpi_tic(plan);
+  }
+  if (direction == DEVICE_FFT_INVERSE) {
     if(plan->b == 1) {
       #if defined FFTX_CUDA
-      std::vector<void*> args{&plan->Q3, &in_buffer};
+      std::vector<void*> args{&Q3, &in_buffer};
       #else
-      std::vector<void*> args{plan->Q3, in_buffer};
+      std::vector<void*> args{Q3, in_buffer};
       #endif
       bdstg3.setArgs(args);
       bdstg3.transform();
     } else {
       #if defined FFTX_CUDA
-      std::vector<void*> args{&plan->Q3, &in_buffer};
+      std::vector<void*> args{&Q3, &in_buffer};
       #else
-      std::vector<void*> args{plan->Q3, in_buffer};
+      std::vector<void*> args{Q3, in_buffer};
       #endif
       b2dstg3.setArgs(args);
       b2dstg3.transform();
     }
-    fftx_mpi_rcperm(plan, plan->Q4, plan->Q3, FFTX_MPI_EMBED_3, plan->is_embed);
+    fftx_mpi_toc(plan, FFTX_MPI_TIMER_FFT3, t, 0);
+    fftx_mpi_rcperm(plan, Q4, Q3, FFTX_MPI_EMBED_3, plan->is_embed);
+    t = fftx_mpi_tic(plan);
     if(plan->b == 1) {
       #if defined FFTX_CUDA
-      std::vector<void*> args{&plan->Q3, &plan->Q4};
+      std::vector<void*> args{&Q3, &Q4};
       #else
-      std::vector<void*> args{plan->Q3, plan->Q4};
+      std::vector<void*> args{Q3, Q4};
       #endif
       ibdstg2.setArgs(args);
       ibdstg2.transform();
     } else {
       #if defined FFTX_CUDA
-      std::vector<void*> args{&plan->Q3, &plan->Q4};
+      std::vector<void*> args{&Q3, &Q4};
       #else
-      std::vector<void*> args{plan->Q3, plan->Q4};
+      std::vector<void*> args{Q3, Q4};
       #endif
       ib2dstg2.setArgs(args);
       ib2dstg2.transform();
     }
-    fftx_mpi_rcperm(plan, plan->Q4, plan->Q3, FFTX_MPI_EMBED_4, plan->is_embed);
+    fftx_mpi_toc(plan, FFTX_MPI_TIMER_FFT2, t, 0);
+    fftx_mpi_rcperm(plan, Q4, Q3, FFTX_MPI_EMBED_4, plan->is_embed);
+    t = fftx_mpi_tic(plan);
 
     if (plan->is_complex) {
       if(plan->b == 1) {
         #if defined FFTX_CUDA
-        std::vector<void*> args{&out_buffer, &plan->Q4};
+        std::vector<void*> args{&out_buffer, &Q4};
         #else
-        std::vector<void*> args{out_buffer, plan->Q4};
+        std::vector<void*> args{out_buffer, Q4};
         #endif
         ibdstg1.setArgs(args);
         ibdstg1.transform();
       } else {
         #if defined FFTX_CUDA
-        std::vector<void*> args{&out_buffer, &plan->Q4};
+        std::vector<void*> args{&out_buffer, &Q4};
         #else
-        std::vector<void*> args{out_buffer, plan->Q4};
+        std::vector<void*> args{out_buffer, Q4};
         #endif
         ib2dstg1.setArgs(args);
         ib2dstg1.transform();
@@ -308,23 +419,23 @@ void fftx_execute_spiral(fftx_plan plan, double* out_buffer, double*in_buffer, i
     } else {
       if(plan->b == 1) {
         #if defined FFTX_CUDA
-        std::vector<void*> args{&out_buffer, &plan->Q4};
+        std::vector<void*> args{&out_buffer, &Q4};
         #else
-        std::vector<void*> args{out_buffer, plan->Q4};
+        std::vector<void*> args{out_buffer, Q4};
         #endif
         ibprdstg1.setArgs(args);
         ibprdstg1.transform();
-      } 
-      // else {
-      //   #if defined FFTX_CUDA
-      //   std::vector<void*> args{&out_buffer, &plan->Q4};
-      //   #else
-      //   std::vector<void*> args{out_buffer, plan->Q4};
-      //   #endif
-      //   ib2prdstg1.setArgs(args);
-      //   ib2prdstg1.transform();
-      // }
+      } else {
+        #if defined FFTX_CUDA
+        std::vector<void*> args{&out_buffer, &Q4};
+        #else
+        std::vector<void*> args{out_buffer, Q4};
+        #endif
+        ib2prdstg1.setArgs(args);
+        ib2prdstg1.transform();
+      }
     }
+    fftx_mpi_toc(plan, FFTX_MPI_TIMER_FFT1, t, 0);
   }
 }
 
@@ -335,7 +446,8 @@ void fftx_plan_destroy_spiral(fftx_plan plan) {
     else
       destroy_2d_comms(plan);
 
-    DEVICE_FREE(plan->Q3);
+    if (plan->Q3)
+      DEVICE_FREE(plan->Q3);
     DEVICE_FREE(plan->Q4);
 
     free(plan);
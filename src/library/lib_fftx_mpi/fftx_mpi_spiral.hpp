@@ -57,8 +57,9 @@ using namespace std;
 // void fftx_mpi_rcperm(fftx_plan plan, double * _Y, double *_X, int stage, bool is_embedded);
 
 
-fftx_plan  fftx_plan_distributed_spiral(int r, int c, int M, int N, int K, int batch, bool is_embedded, bool is_complex);
-void fftx_execute_spiral(fftx_plan plan, double* out_buffer, double*in_buffer,int direction);
+fftx_plan  fftx_plan_distributed_spiral(int r, int c, int M, int N, int K, int batch, bool is_embedded, bool is_complex, int flags = 0, MPI_Comm comm = MPI_COMM_WORLD);
+// with a symbol, a forward call runs the whole convolution, see fftx_execute_rconv.
+void fftx_execute_spiral(fftx_plan plan, double* out_buffer, double*in_buffer,int direction, double *symbol = NULL);
 void fftx_plan_destroy_spiral(fftx_plan plan);
 
 #endif
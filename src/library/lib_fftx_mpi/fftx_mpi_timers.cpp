@@ -0,0 +1,75 @@
+#include <cstdio>
+#include <cstdlib>
+#include <mpi.h>
+
+#include "fftx_mpi.hpp"
+
+// the timers only use MPI, so host and device builds share them.
+
+// a plan shared through the cache has one set of timers for all its handles.
+static void fftx_plan_timers_owned(fftx_plan plan, const char *caller) {
+  if (fftx_plan_is_shared(plan)) {
+    fprintf(stderr, "%s: the plan is shared through the plan cache\n", caller);
+    exit(-1);
+  }
+}
+
+void fftx_plan_timing(fftx_plan plan, bool enable) {
+  fftx_plan_timers_owned(plan, "fftx_plan_timing");
+  fftx_plan_timers_reset(plan);
+  plan->is_timed = enable;
+}
+
+void fftx_plan_timers_reset(fftx_plan plan) {
+  fftx_plan_timers_owned(plan, "fftx_plan_timers_reset");
+  for (int i = 0; i != FFTX_MPI_NUM_TIMERS; ++i) {
+    plan->timer_sec[i]   = 0.0;
+    plan->timer_bytes[i] = 0;
+    plan->timer_calls[i] = 0;
+  }
+}
+
+void fftx_plan_timers(fftx_plan plan, fftx_mpi_timer_stats_t *stats) {
+  double min_sec[FFTX_MPI_NUM_TIMERS], max_sec[FFTX_MPI_NUM_TIMERS], sum_sec[FFTX_MPI_NUM_TIMERS];
+  unsigned long long bytes[FFTX_MPI_NUM_TIMERS], sum_bytes[FFTX_MPI_NUM_TIMERS];
+  int p;
+  MPI_Comm_size(plan->plan_comm, &p);
+  for (int i = 0; i != FFTX_MPI_NUM_TIMERS; ++i)
+    bytes[i] = plan->timer_bytes[i];
+
+  MPI_Allreduce(plan->timer_sec, min_sec, FFTX_MPI_NUM_TIMERS, MPI_DOUBLE, MPI_MIN, plan->plan_comm);
+  MPI_Allreduce(plan->timer_sec, max_sec, FFTX_MPI_NUM_TIMERS, MPI_DOUBLE, MPI_MAX, plan->plan_comm);
+  MPI_Allreduce(plan->timer_sec, sum_sec, FFTX_MPI_NUM_TIMERS, MPI_DOUBLE, MPI_SUM, plan->plan_comm);
+  MPI_Allreduce(bytes, sum_bytes, FFTX_MPI_NUM_TIMERS, MPI_UNSIGNED_LONG_LONG, MPI_SUM, plan->plan_comm);
+
+  for (int i = 0; i != FFTX_MPI_NUM_TIMERS; ++i) {
+    stats[i].min   = min_sec[i];
+    stats[i].max   = max_sec[i];
+    stats[i].avg   = sum_sec[i] / p;
+    stats[i].bytes = sum_bytes[i];
+    stats[i].calls = plan->timer_calls[i];
+  }
+}
+
+void fftx_plan_timers_json(fftx_plan plan, FILE *out) {
+  static const char *names[FFTX_MPI_NUM_TIMERS] = {
+    "fft_stage1", "fft_stage2", "fft_stage3", "pack", "unpack", "copy", "alltoall"
+  };
+  fftx_mpi_timer_stats_t stats[FFTX_MPI_NUM_TIMERS];
+  fftx_plan_timers(plan, stats);
+
+  int rank, p;
+  MPI_Comm_rank(plan->plan_comm, &rank);
+  MPI_Comm_size(plan->plan_comm, &p);
+  if (rank != 0)
+    return;
+
+  fprintf(out, "{\n  \"ranks\": %d,\n  \"timers\": {\n", p);
+  for (int i = 0; i != FFTX_MPI_NUM_TIMERS; ++i) {
+    fprintf(out, "    \"%s\": {\"calls\": %d, \"min\": %.9e, \"max\": %.9e, \"avg\": %.9e, \"bytes\": %zu}%s\n",
+            names[i], stats[i].calls, stats[i].min, stats[i].max, stats[i].avg, stats[i].bytes,
+            (i + 1 < FFTX_MPI_NUM_TIMERS) ? "," : "");
+  }
+  fprintf(out, "  }\n}\n");
+  fflush(out);
+}
@@ -0,0 +1,104 @@
+#ifndef mdr2r_PRECOMPILE_H
+#define mdr2r_PRECOMPILE_H
+
+#include "fftx3.hpp"
+#include "transformer.fftx.precompile.hpp"
+
+/*
+ Real to real 3D DCT and DST classes for precompiled transforms
+
+ null contruction should fail if a transform of size [NX,NY,NZ] is not available
+*/
+
+namespace fftx {
+
+  // the families differ only in the library they look up.
+  template <int DIM>
+  class mdr2r : public transformer<DIM, double, double>
+  {
+  public:
+    typedef transformTuple_t* (*tuple_fn)(point_t<DIM>);
+
+    mdr2r(const point_t<DIM>& a_size, tuple_fn a_tuple, const char* a_shortname) :
+      transformer<DIM, double, double>(a_size),
+      m_tuple(a_tuple),
+      m_shortname(a_shortname)
+    {
+      // look up this transform size in the database.
+      transformTuple_t* tupl = m_tuple ( this->m_size );
+      this->setInit(tupl);
+      if (tupl != NULL) this->transform_spiral = *tupl->runfp;
+    }
+
+    inline bool defined()
+    {
+      transformTuple_t* tupl = m_tuple ( this->m_size );
+      return (tupl != NULL);
+    }
+
+    inline fftx::handle_t transform(array_t<DIM, double>& a_src,
+                                    array_t<DIM, double>& a_dst)
+    {
+      return this->transform2(a_src, a_dst);
+    }
+
+    inline fftx::handle_t transformBuffers(double* a_src,
+                                           double* a_dst)
+    {
+      return this->transform2Buffers(a_src, a_dst);
+    }
+
+    std::string shortname()
+    {
+      return m_shortname;
+    }
+
+  private:
+    tuple_fn m_tuple;
+    std::string m_shortname;
+  };
+
+  template <int DIM>
+  class mddct : public mdr2r<DIM>
+  {
+  public:
+    mddct(const point_t<DIM>& a_size) : mdr2r<DIM>(a_size, fftx_mddct_Tuple, "mddct") {}
+  };
+
+  template <int DIM>
+  class imddct : public mdr2r<DIM>
+  {
+  public:
+    imddct(const point_t<DIM>& a_size) : mdr2r<DIM>(a_size, fftx_imddct_Tuple, "imddct") {}
+  };
+
+  template <int DIM>
+  class mddst : public mdr2r<DIM>
+  {
+  public:
+    mddst(const point_t<DIM>& a_size) : mdr2r<DIM>(a_size, fftx_mddst_Tuple, "mddst") {}
+  };
+
+  template <int DIM>
+  class imddst : public mdr2r<DIM>
+  {
+  public:
+    imddst(const point_t<DIM>& a_size) : mdr2r<DIM>(a_size, fftx_imddst_Tuple, "imddst") {}
+  };
+
+  template <int DIM>
+  class mddct1 : public mdr2r<DIM>
+  {
+  public:
+    mddct1(const point_t<DIM>& a_size) : mdr2r<DIM>(a_size, fftx_mddct1_Tuple, "mddct1") {}
+  };
+
+  template <int DIM>
+  class mddst1 : public mdr2r<DIM>
+  {
+  public:
+    mddst1(const point_t<DIM>& a_size) : mdr2r<DIM>(a_size, fftx_mddst1_Tuple, "mddst1") {}
+  };
+}
+
+#endif
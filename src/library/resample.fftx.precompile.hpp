@@ -0,0 +1,78 @@
+#ifndef resample_PRECOMPILE_H
+#define resample_PRECOMPILE_H
+
+#include "fftx3.hpp"
+#include "transformer.fftx.precompile.hpp"
+
+/*
+ Spectral resampling class for precompiled transforms: Fourier interpolation
+ of a real field on the coarse grid [NX/2,NY/2,NZ/2] onto [NX,NY,NZ]
+
+ null contruction should fail if a transform of size [NX,NY,NZ] is not available
+*/
+
+namespace fftx {
+  
+  template <int DIM>
+  class resampler : public transformer<DIM, double, double>
+  {
+  public:
+    resampler(const point_t<DIM>& a_size) :
+      transformer<DIM, double, double>(a_size)
+    {
+      this->m_inputSize = this->sizeCoarse();
+      // look up this transform size in the database.
+      // I would prefer if this was a constexpr kind of thing where we fail at compile time
+      transformTuple_t* tupl = fftx_resample_Tuple ( this->m_size );
+      this->setInit(tupl);
+      if (tupl != NULL) this->transform_spiral = *tupl->runfp;
+    }
+    
+    ~resampler()
+    {
+      // in base class
+      // if (destroy_spiral != nullptr) destroy_spiral();
+    }
+
+    inline bool defined()
+    {
+      transformTuple_t* tupl = fftx_resample_Tuple ( this->m_size );
+      return (tupl != NULL);
+    }
+
+    inline fftx::handle_t transform(array_t<DIM, double>& a_src,
+                                    array_t<DIM, double>& a_dst)
+    { // for the moment, the function signature is hard-coded.  trace will
+      // generate this in our better world
+      return this->transform2(a_src, a_dst);
+    }
+
+    inline fftx::handle_t transformBuffers(double* a_src,
+                                           double* a_dst)
+    { // for the moment, the function signature is hard-coded.  trace will
+      // generate this in our better world
+      return this->transform2Buffers(a_src, a_dst);
+    }
+
+    // the coarse grid is n/2 in each dimension
+    point_t<DIM> sizeCoarse()
+    {
+      point_t<DIM> ret = this->m_size;
+      for (int d = 0; d < DIM; d++)
+        ret[d] = this->m_size[d]/2;
+      return ret;
+    }
+
+    std::string shortname()
+    {
+      return "resample";
+    }
+
+  private:
+    // void (*init_spiral)() = nullptr;
+    // void (*transform_spiral)(double*, double*, double*) = nullptr;
+    // void (*destroy_spiral)() = nullptr;
+  };
+}
+
+#endif  